@@ -0,0 +1,139 @@
+#include <bitmap/io/image_format_png.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+
+// Writes a synthetic 16 bit image (smooth gradient plus sensor like noise) with different encoder
+// settings and thread counts and prints file size and encode time.
+//
+// usage: bitmap_png_write [width height]
+
+
+namespace {
+
+
+    bmp::bitmap<std::uint16_t> make_image(std::size_t w, std::size_t h) {
+        std::mt19937 gen(42);
+        std::normal_distribution<double> noise(0, 40);
+
+        bmp::bitmap<std::uint16_t> result(w, h);
+        for(std::size_t y = 0; y < h; ++y) {
+            for(std::size_t x = 0; x < w; ++x) {
+                auto const v = 20000 + 10000 * std::sin(static_cast<double>(x) / 200.)
+                    * std::cos(static_cast<double>(y) / 150.) + noise(gen);
+                result(x, y) = static_cast<std::uint16_t>(std::clamp(v, 0., 65535.));
+            }
+        }
+        return result;
+    }
+
+    char const* name(bmp::png::filter filter) {
+        using enum bmp::png::filter;
+        switch(filter) {
+        case none:
+            return "none";
+        case sub:
+            return "sub";
+        case up:
+            return "up";
+        case average:
+            return "average";
+        case paeth:
+            return "paeth";
+        case adaptive:
+            return "adaptive";
+        }
+        return "?";
+    }
+
+    char const* name(bmp::png::compression_strategy strategy) {
+        using enum bmp::png::compression_strategy;
+        switch(strategy) {
+        case standard:
+            return "default";
+        case filtered:
+            return "filtered";
+        case huffman_only:
+            return "huffman";
+        case rle:
+            return "rle";
+        case fixed:
+            return "fixed";
+        }
+        return "?";
+    }
+
+
+}
+
+
+int main(int argc, char** argv) {
+    std::size_t w = 4096;
+    std::size_t h = 3072;
+    if(argc == 3) {
+        w = std::stoul(argv[1]);
+        h = std::stoul(argv[2]);
+    }
+
+    auto const image = make_image(w, h);
+    auto const raw_size = static_cast<double>(image.point_count() * sizeof(std::uint16_t));
+
+    std::cout << "image " << w << "x" << h << " 16 bit gray, " << raw_size / 1e6 << " MB raw\n\n";
+    std::cout << std::setw(10) << "interlace" << std::setw(7) << "level" << std::setw(10) << "strategy"
+              << std::setw(10) << "filter" << std::setw(10) << "ratio" << std::setw(10) << "ms"
+              << std::setw(10) << "MB/s" << '\n';
+
+    using bmp::png::compression_strategy;
+    using bmp::png::filter;
+    for(auto const interlace: {false, true}) {
+        for(auto const level: {0, 1, 3, 6, 9}) {
+            for(auto const strategy: {compression_strategy::filtered, compression_strategy::rle}) {
+                for(auto const f: {filter::none, filter::up, filter::paeth, filter::adaptive}) {
+                    std::ostringstream os;
+                    auto const start = std::chrono::steady_clock::now();
+                    if(!bmp::png::write(image, os, {interlace, level, strategy, f})) {
+                        std::cerr << "write failed\n";
+                        return 1;
+                    }
+                    auto const end = std::chrono::steady_clock::now();
+
+                    auto const ms = std::chrono::duration<double, std::milli>(end - start).count();
+                    auto const size = static_cast<double>(os.str().size());
+                    std::cout << std::setw(10) << (interlace ? "adam7" : "none") << std::setw(7) << level
+                              << std::setw(10) << name(strategy) << std::setw(10) << name(f) << std::setw(10)
+                              << std::fixed << std::setprecision(3) << size / raw_size << std::setw(10)
+                              << std::setprecision(1) << ms << std::setw(10) << raw_size / 1e3 / ms << '\n';
+                }
+            }
+        }
+    }
+
+    std::cout << '\n' << std::setw(10) << "threads" << std::setw(7) << "level" << std::setw(10) << "filter"
+              << std::setw(10) << "ratio" << std::setw(10) << "ms" << std::setw(10) << "MB/s" << '\n';
+
+    for(auto const threads: {std::size_t(1), std::size_t(2), std::size_t(4), std::size_t(0)}) {
+        for(auto const level: {1, 6}) {
+            for(auto const f: {filter::up, filter::adaptive}) {
+                std::ostringstream os;
+                auto const start = std::chrono::steady_clock::now();
+                if(!bmp::png::write(image, os, {false, level, compression_strategy::filtered, f, threads})) {
+                    std::cerr << "write failed\n";
+                    return 1;
+                }
+                auto const end = std::chrono::steady_clock::now();
+
+                auto const ms = std::chrono::duration<double, std::milli>(end - start).count();
+                auto const size = static_cast<double>(os.str().size());
+                std::cout << std::setw(10) << threads << std::setw(7) << level << std::setw(10) << name(f)
+                          << std::setw(10) << std::fixed << std::setprecision(3) << size / raw_size
+                          << std::setw(10) << std::setprecision(1) << ms << std::setw(10) << raw_size / 1e3 / ms
+                          << '\n';
+            }
+        }
+    }
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "binary_write.hpp"
+#include "bitmap.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Writes bitmaps in background threads
+    ///
+    /// Bitmaps are moved into the queue, their data is never copied. If the bitmaps in the queue
+    /// and in progress exceed the memory budget, write() blocks until enough writes are done. A
+    /// single bitmap larger than the budget is accepted if nothing else is queued.
+    ///
+    /// Any write function can be queued, e.g. for PNG:
+    ///
+    ///     writer.write(std::move(image), [path](auto const& image) {
+    ///         if(!bmp::png::write(image, path)) throw std::runtime_error("png write failed");
+    ///     });
+    ///
+    /// The destructor waits until all queued writes are done.
+    class async_writer {
+    public:
+        /// \brief Starts thread_count writer threads, 0 means one per hardware thread
+        explicit async_writer(std::size_t thread_count = 1, std::size_t memory_budget = std::size_t(256) << 20)
+            : memory_budget_(memory_budget) {
+            auto const count = detail::thread_count(thread_count);
+            threads_.reserve(count);
+            for(std::size_t i = 0; i < count; ++i) {
+                threads_.emplace_back([this] { work(); });
+            }
+        }
+
+        async_writer(async_writer const&) = delete;
+        async_writer& operator=(async_writer const&) = delete;
+
+        ~async_writer() {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            job_available_.notify_all();
+
+            for(auto& thread: threads_) {
+                thread.join();
+            }
+        }
+
+
+        /// \brief Queue fn(image), the future reports completion or the exception thrown by fn
+        template <typename T, typename WriteFn>
+        std::future<void> write(bitmap<T>&& image, WriteFn&& fn) {
+            std::promise<void> promise;
+            auto future = promise.get_future();
+            write(std::move(image), static_cast<WriteFn&&>(fn), [promise = std::move(promise)](std::exception_ptr error) mutable {
+                if(error) {
+                    promise.set_exception(error);
+                } else {
+                    promise.set_value();
+                }
+            });
+            return future;
+        }
+
+        /// \brief Queue fn(image), done(error) is called by the writer thread afterwards
+        ///
+        /// error is nullptr on success or holds the exception thrown by fn. done must not throw.
+        template <typename T, typename WriteFn, typename DoneFn>
+        void write(bitmap<T>&& image, WriteFn&& fn, DoneFn&& done) {
+            auto const bytes = memory_size(image);
+
+            job job{
+                [image = std::move(image), fn = static_cast<WriteFn&&>(fn), done = static_cast<DoneFn&&>(done)]() mutable {
+                    std::exception_ptr error;
+                    try {
+                        fn(static_cast<bitmap<T> const&>(image));
+                    } catch(...) {
+                        error = std::current_exception();
+                    }
+
+                    // release the image before signaling completion
+                    image = bitmap<T>();
+                    done(error);
+                },
+                bytes};
+
+            std::unique_lock lock(mutex_);
+            space_available_.wait(lock, [this, bytes] {
+                return used_bytes_ == 0 || used_bytes_ + bytes <= memory_budget_;
+            });
+            used_bytes_ += bytes;
+            jobs_.push_back(std::move(job));
+            lock.unlock();
+
+            job_available_.notify_one();
+        }
+
+        /// \brief Queue binary_write(image, filename, endianness)
+        template <typename T>
+        std::future<void> binary_write(bitmap<T>&& image, std::string filename, std::endian endianness = std::endian::native) {
+            return write(std::move(image), [filename = std::move(filename), endianness](bitmap<T> const& image) {
+                ::bmp::binary_write(image, filename, endianness);
+            });
+        }
+
+
+        /// \brief Blocks until all queued writes are done
+        void wait() {
+            std::unique_lock lock(mutex_);
+            idle_.wait(lock, [this] { return used_bytes_ == 0 && jobs_.empty() && running_ == 0; });
+        }
+
+        /// \brief Bytes of all queued and currently written bitmaps
+        std::size_t used_bytes() const {
+            std::lock_guard lock(mutex_);
+            return used_bytes_;
+        }
+
+        /// \brief Maximum of used_bytes() before write() blocks
+        std::size_t memory_budget() const noexcept {
+            return memory_budget_;
+        }
+
+
+    private:
+        struct job {
+            std::move_only_function<void()> run;
+            std::size_t bytes;
+        };
+
+        template <typename T>
+        static std::size_t memory_size(bitmap<T> const& image) noexcept {
+            if constexpr(std::is_same_v<T, bool>) {
+                return (image.point_count() + 7) / 8;
+            } else {
+                return image.point_count() * sizeof(T);
+            }
+        }
+
+        void work() {
+            for(;;) {
+                std::unique_lock lock(mutex_);
+                job_available_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                if(jobs_.empty()) {
+                    return;
+                }
+
+                auto job = std::move(jobs_.front());
+                jobs_.pop_front();
+                ++running_;
+                lock.unlock();
+
+                job.run();
+
+                lock.lock();
+                --running_;
+                used_bytes_ -= job.bytes;
+                lock.unlock();
+
+                space_available_.notify_all();
+                idle_.notify_all();
+            }
+        }
+
+        std::size_t const memory_budget_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable job_available_;
+        std::condition_variable space_available_;
+        std::condition_variable idle_;
+
+        std::deque<job> jobs_;
+        std::size_t used_bytes_ = 0;
+        std::size_t running_ = 0;
+        bool stop_ = false;
+
+        std::vector<std::thread> threads_;
+    };
+
+
+}
@@ -0,0 +1,482 @@
+#pragma once
+
+#include "binary_read.hpp"
+#include "binary_write.hpp"
+#include "bitmap.hpp"
+#include "exception.hpp"
+
+#include "detail/io_uring.hpp"
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    define BMP_HAS_PREAD 1
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    include <cerrno>
+#endif
+
+
+namespace bmp {
+
+
+    /// \brief I/O implementation used by binary_read_batch and binary_write_batch
+    enum class batch_io_backend {
+        /// \brief io_uring if the kernel supports it, pread/pwrite otherwise
+        automatic,
+
+        /// \brief Linux io_uring, binary_io_error if not available
+        io_uring,
+
+        /// \brief pread/pwrite on queue_depth threads (std::fstream on non POSIX systems)
+        pread
+    };
+
+    /// \brief Options for binary_read_batch and binary_write_batch
+    struct batch_io_options {
+        /// \brief Maximum number of files in flight
+        std::size_t queue_depth = 32;
+
+        /// \brief Bypass the page cache with O_DIRECT where the file system supports it
+        bool direct_io = false;
+
+        batch_io_backend backend = batch_io_backend::automatic;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Alignment of batch I/O buffers, file offsets and O_DIRECT transfer sizes
+        constexpr std::size_t batch_io_alignment = 4096;
+
+        /// \brief Largest single read or write request
+        constexpr std::size_t batch_io_max_request = std::size_t(1) << 30;
+
+        constexpr std::size_t align_up(std::size_t const value, std::size_t const alignment) noexcept {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        /// \brief Size of a bitmap in the binary format
+        template <typename T>
+        std::size_t binary_file_size(bitmap<T> const& image) noexcept {
+            constexpr std::size_t header_size = 24;
+            if constexpr(std::is_same_v<T, bool>) {
+                return header_size + (image.point_count() + 7) / 8;
+            } else {
+                return header_size + image.point_count() * sizeof(T);
+            }
+        }
+
+        /// \brief std::streambuf over a fixed memory range
+        class memory_streambuf: public std::streambuf {
+        public:
+            memory_streambuf(std::byte* const data, std::size_t const size) {
+                auto const begin = reinterpret_cast<char*>(data);
+                setg(begin, begin, begin + size);
+                setp(begin, begin + size);
+            }
+
+        protected:
+            /// \brief Moves the read position, the tiled format seeks to its tiles
+            pos_type seekoff(off_type const off, std::ios_base::seekdir const dir, std::ios_base::openmode const which)
+                override {
+                if((which & std::ios_base::in) == 0) {
+                    return pos_type(off_type(-1));
+                }
+
+                auto const base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+                auto const position = (base - eback()) + off;
+                if(position < 0 || position > egptr() - eback()) {
+                    return pos_type(off_type(-1));
+                }
+
+                setg(eback(), eback() + position, egptr());
+                return pos_type(position);
+            }
+
+            pos_type seekpos(pos_type const pos, std::ios_base::openmode const which) override {
+                return seekoff(off_type(pos), std::ios_base::beg, which);
+            }
+        };
+
+
+#ifdef BMP_HAS_PREAD
+        /// \brief An open file and its aligned transfer buffer
+        class batch_file {
+        public:
+            batch_file(std::string const& filename, bool const write, bool const direct_io)
+                : filename_(&filename)
+                , write_(write) {
+                int const flags = write ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC;
+#    ifdef O_DIRECT
+                if(direct_io) {
+                    fd_ = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+                    direct_ = fd_ >= 0;
+                }
+#    else
+                static_cast<void>(direct_io);
+#    endif
+                // file systems without O_DIRECT support (e.g. tmpfs) fail with EINVAL
+                if(fd_ < 0) {
+                    fd_ = ::open(filename.c_str(), flags, 0644);
+                }
+                if(fd_ < 0) {
+                    throw binary_io_error("can't open file: " + filename);
+                }
+
+                if(!write) {
+                    struct stat status;
+                    if(::fstat(fd_, &status) != 0) {
+                        fail("can't stat file");
+                    }
+                    resize(static_cast<std::size_t>(status.st_size));
+                }
+            }
+
+            batch_file(batch_file const&) = delete;
+            batch_file& operator=(batch_file const&) = delete;
+
+            ~batch_file() {
+                if(fd_ >= 0) {
+                    ::close(fd_);
+                }
+            }
+
+            /// \brief Allocates the buffer for size bytes of file data
+            void resize(std::size_t const size) {
+                size_ = size;
+                auto const capacity = align_up(std::max<std::size_t>(size, 1), batch_io_alignment);
+                buffer_.reset(static_cast<std::byte*>(std::aligned_alloc(batch_io_alignment, capacity)));
+                if(!buffer_) {
+                    throw std::bad_alloc();
+                }
+                if(direct_) {
+                    // O_DIRECT writes whole blocks, the padding is truncated in finish()
+                    std::memset(buffer_.get() + size, 0, capacity - size);
+                }
+            }
+
+            int fd() const noexcept {
+                return fd_;
+            }
+
+            bool write() const noexcept {
+                return write_;
+            }
+
+            std::byte* data() const noexcept {
+                return buffer_.get();
+            }
+
+            std::size_t size() const noexcept {
+                return size_;
+            }
+
+            /// \brief Offset and size of the next request, size is 0 when the transfer is done
+            std::pair<std::size_t, std::size_t> next_request() const noexcept {
+                auto const end = direct_ ? align_up(size_, batch_io_alignment) : size_;
+                if(done_ >= size_) {
+                    return {done_, 0};
+                }
+                return {done_, std::min(end - done_, batch_io_max_request)};
+            }
+
+            /// \brief Account the result of a request, throws on errors
+            void advance(long long const result) {
+                if(result < 0) {
+                    errno = static_cast<int>(-result);
+                    fail(write_ ? "can't write file" : "can't read file");
+                }
+                if(result == 0) {
+                    fail(write_ ? "can't write file" : "unexpected end of file");
+                }
+                done_ += static_cast<std::size_t>(result);
+            }
+
+            /// \brief Truncates O_DIRECT padding and closes the file
+            void finish() {
+                if(write_ && direct_ && ::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+                    fail("can't truncate file");
+                }
+                auto const fd = fd_;
+                fd_ = -1;
+                if(::close(fd) != 0 && write_) {
+                    fail("can't write file");
+                }
+            }
+
+            /// \brief Transfer the whole buffer with pread/pwrite
+            void transfer() {
+                for(auto [offset, size] = next_request(); size > 0; std::tie(offset, size) = next_request()) {
+                    auto const result = write_
+                        ? ::pwrite(fd_, buffer_.get() + offset, size, static_cast<off_t>(offset))
+                        : ::pread(fd_, buffer_.get() + offset, size, static_cast<off_t>(offset));
+                    if(result < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    advance(result < 0 ? -errno : result);
+                }
+            }
+
+        private:
+            [[noreturn]] void fail(char const* const message) const {
+                throw binary_io_error(std::string(message) + " (" + std::strerror(errno) + "): " + *filename_);
+            }
+
+            struct free_deleter {
+                void operator()(std::byte* const data) const noexcept {
+                    std::free(data);
+                }
+            };
+
+            std::string const* filename_;
+            int fd_ = -1;
+            bool write_;
+            bool direct_ = false;
+            std::unique_ptr<std::byte, free_deleter> buffer_;
+            std::size_t size_ = 0;
+            std::size_t done_ = 0;
+        };
+
+        /// \brief Transfers count files with up to queue_depth files in flight
+        ///
+        /// open(i) returns a batch_file with filled buffer (write) or allocated buffer (read),
+        /// done(i, file) is called after the transfer finished. Both are called on the calling
+        /// thread for io_uring and on the worker threads for pread. The first exception is
+        /// rethrown after all started transfers finished, remaining files are skipped then.
+        template <typename OpenFn, typename DoneFn>
+        void batch_transfer(std::size_t const count, batch_io_options const& options, OpenFn const& open, DoneFn const& done) {
+            auto const queue_depth = std::max<std::size_t>(options.queue_depth, 1);
+
+#    ifdef BMP_HAS_IO_URING
+            if(options.backend != batch_io_backend::pread && count > 0) {
+                std::optional<detail::io_uring> ring;
+                try {
+                    ring.emplace(static_cast<unsigned>(std::min<std::size_t>(queue_depth, 4096)));
+                } catch(std::system_error const& error) {
+                    if(options.backend == batch_io_backend::io_uring) {
+                        throw binary_io_error(std::string("io_uring not available: ") + error.what());
+                    }
+                }
+
+                if(ring) {
+                    auto const slot_count = std::min<std::size_t>({queue_depth, ring->entries(), count});
+                    std::vector<std::unique_ptr<batch_file>> slots(slot_count);
+                    std::vector<std::size_t> slot_file(slot_count);
+                    std::vector<std::size_t> free_slots(slot_count);
+                    for(std::size_t i = 0; i < slot_count; ++i) {
+                        free_slots[i] = slot_count - 1 - i;
+                    }
+
+                    std::exception_ptr error;
+                    std::size_t next = 0;
+                    std::size_t in_flight = 0;
+
+                    // returns false if the file is complete
+                    auto const request = [&ring](batch_file& file, std::size_t const slot) {
+                        auto const [offset, size] = file.next_request();
+                        if(size == 0) {
+                            return false;
+                        }
+                        ring->prepare(file.write(), file.fd(), file.data() + offset, static_cast<unsigned>(size), offset, slot);
+                        return true;
+                    };
+
+                    auto const complete = [&](std::size_t const slot) {
+                        try {
+                            slots[slot]->finish();
+                            done(slot_file[slot], *slots[slot]);
+                        } catch(...) {
+                            if(!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                        slots[slot].reset();
+                        free_slots.push_back(slot);
+                    };
+
+                    for(;;) {
+                        while(!error && next < count && !free_slots.empty()) {
+                            auto const slot = free_slots.back();
+                            free_slots.pop_back();
+                            slot_file[slot] = next;
+                            try {
+                                slots[slot] = open(next++);
+                                if(request(*slots[slot], slot)) {
+                                    ++in_flight;
+                                } else {
+                                    complete(slot);
+                                }
+                            } catch(...) {
+                                error = std::current_exception();
+                                slots[slot].reset();
+                                free_slots.push_back(slot);
+                            }
+                        }
+
+                        if(in_flight == 0) {
+                            break;
+                        }
+
+                        ring->submit(1);
+                        ring->reap([&](std::uint64_t const user_data, int const result) {
+                            auto const slot = static_cast<std::size_t>(user_data);
+                            if(result == -EINTR || result == -EAGAIN) {
+                                request(*slots[slot], slot);
+                                return;
+                            }
+
+                            try {
+                                slots[slot]->advance(result);
+                                if(!error && request(*slots[slot], slot)) {
+                                    return;
+                                }
+                            } catch(...) {
+                                if(!error) {
+                                    error = std::current_exception();
+                                }
+                            }
+
+                            --in_flight;
+                            if(error) {
+                                slots[slot].reset();
+                                free_slots.push_back(slot);
+                            } else {
+                                complete(slot);
+                            }
+                        });
+                    }
+
+                    if(error) {
+                        std::rethrow_exception(error);
+                    }
+                    return;
+                }
+            }
+#    endif
+
+            parallel_for(count, queue_depth, [&](std::size_t const i) {
+                auto file = open(i);
+                file->transfer();
+                file->finish();
+                done(i, *file);
+            });
+        }
+#endif
+
+
+    }
+
+
+    /// \brief Read many bitmaps from disk concurrently
+    ///
+    /// Up to options.queue_depth files are read at once into aligned buffers with io_uring or
+    /// pread. This is much faster than binary_read for many files on fast SSDs.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_read_batch(
+        std::vector<bitmap<T>>& bitmaps,
+        std::vector<std::string> const& filenames,
+        batch_io_options const& options = {},
+        bool ignore_signed = true) {
+        bitmaps.resize(filenames.size());
+
+#ifdef BMP_HAS_PREAD
+        detail::batch_transfer(
+            filenames.size(), options,
+            [&](std::size_t const i) {
+                return std::make_unique<detail::batch_file>(filenames[i], false, options.direct_io);
+            },
+            [&](std::size_t const i, detail::batch_file const& file) {
+                detail::memory_streambuf buffer(file.data(), file.size());
+                std::istream is(&buffer);
+                try {
+                    binary_read(bitmaps[i], is, ignore_signed);
+                } catch(binary_io_error const& error) {
+                    throw binary_io_error(std::string(error.what()) + ": " + filenames[i]);
+                }
+            });
+#else
+        detail::parallel_for(filenames.size(), std::max<std::size_t>(options.queue_depth, 1), [&](std::size_t const i) {
+            binary_read(bitmaps[i], filenames[i], ignore_signed);
+        });
+#endif
+    }
+
+    /// \brief Read many bitmaps from disk concurrently
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    std::vector<bitmap<T>> binary_read_batch(
+        std::vector<std::string> const& filenames,
+        batch_io_options const& options = {},
+        bool ignore_signed = true) {
+        std::vector<bitmap<T>> bitmaps;
+        binary_read_batch(bitmaps, filenames, options, ignore_signed);
+        return bitmaps;
+    }
+
+    /// \brief Write many bitmaps to disk concurrently
+    ///
+    /// bitmaps[i] is written to filenames[i]. Up to options.queue_depth files are serialized into
+    /// aligned buffers and written at once with io_uring or pwrite.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write_batch(
+        std::vector<bitmap<T>> const& bitmaps,
+        std::vector<std::string> const& filenames,
+        std::endian endianness = std::endian::native,
+        batch_io_options const& options = {}) {
+        if(bitmaps.size() != filenames.size()) {
+            throw std::invalid_argument(
+                "binary_write_batch got " + std::to_string(bitmaps.size()) + " bitmaps but "
+                + std::to_string(filenames.size()) + " filenames");
+        }
+
+#ifdef BMP_HAS_PREAD
+        detail::batch_transfer(
+            filenames.size(), options,
+            [&](std::size_t const i) {
+                auto file = std::make_unique<detail::batch_file>(filenames[i], true, options.direct_io);
+                file->resize(detail::binary_file_size(bitmaps[i]));
+
+                detail::memory_streambuf buffer(file->data(), file->size());
+                std::ostream os(&buffer);
+                try {
+                    binary_write(bitmaps[i], os, endianness);
+                } catch(binary_io_error const& error) {
+                    throw binary_io_error(std::string(error.what()) + ": " + filenames[i]);
+                }
+                return file;
+            },
+            [](std::size_t, detail::batch_file const&) {});
+#else
+        detail::parallel_for(filenames.size(), std::max<std::size_t>(options.queue_depth, 1), [&](std::size_t const i) {
+            binary_write(bitmaps[i], filenames[i], endianness);
+        });
+#endif
+    }
+
+
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "exception.hpp"
+
+#include "detail/binary_io_flags.hpp"
+#include "detail/crc32c.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Settings for writing the checksummed binary format version 3
+    ///
+    /// The pixel data is stored in chunks of chunk_size bytes, each followed by its CRC32C.
+    /// binary_read verifies every chunk while reading it.
+    struct binary_checksum {
+        /// \brief Bytes of pixel data per checksum, at most 1 GiB
+        std::size_t chunk_size = std::size_t(1) << 20;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Size of the version 3 header behind the common header
+        constexpr std::size_t binary_checksum_header_size = 8;
+
+        /// \brief Largest chunk of the version 3 format
+        constexpr std::size_t binary_max_chunk_size = std::size_t(1) << 30;
+
+        /// \brief Passes data to target and appends the CRC32C of every chunk_size bytes
+        ///
+        /// finish() must be called after the last write to store the final short chunk.
+        class crc32c_ostreambuf: public std::streambuf {
+        public:
+            crc32c_ostreambuf(std::streambuf* const target, std::size_t const chunk_size)
+                : target_(target)
+                , buffer_(chunk_size) {
+                reset();
+            }
+
+            /// \brief Writes the pending chunk, returns false on errors
+            bool finish() {
+                return flush_chunk();
+            }
+
+        protected:
+            int_type overflow(int_type const c) override {
+                if(!flush_chunk()) {
+                    return traits_type::eof();
+                }
+                if(!traits_type::eq_int_type(c, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(char const* const data, std::streamsize const count) override {
+                auto const size = static_cast<std::size_t>(count);
+                std::size_t done = 0;
+                while(done < size) {
+                    // whole chunks go straight to the target
+                    if(pptr() == pbase() && size - done >= buffer_.size()) {
+                        if(!write_chunk(data + done, buffer_.size())) {
+                            break;
+                        }
+                        done += buffer_.size();
+                        continue;
+                    }
+
+                    auto const part = std::min(static_cast<std::size_t>(epptr() - pptr()), size - done);
+                    std::memcpy(pptr(), data + done, part);
+                    pbump(static_cast<int>(part));
+                    done += part;
+                    if(pptr() == epptr() && !flush_chunk()) {
+                        break;
+                    }
+                }
+                return static_cast<std::streamsize>(done);
+            }
+
+        private:
+            void reset() noexcept {
+                setp(buffer_.data(), buffer_.data() + buffer_.size());
+            }
+
+            bool write_chunk(char const* const data, std::size_t const size) {
+                auto const crc = byteswap_on_little_endian(crc32c(0, data, size));
+                return target_->sputn(data, static_cast<std::streamsize>(size)) == static_cast<std::streamsize>(size)
+                    && target_->sputn(reinterpret_cast<char const*>(&crc), 4) == 4;
+            }
+
+            bool flush_chunk() {
+                auto const size = static_cast<std::size_t>(pptr() - pbase());
+                reset();
+                return size == 0 || write_chunk(buffer_.data(), size);
+            }
+
+            std::streambuf* target_;
+            std::vector<char> buffer_;
+        };
+
+        /// \brief Reads size bytes from chunks with trailing CRC32C from source
+        ///
+        /// Every chunk is verified before any of its data is passed on. Errors are thrown as
+        /// binary_io_error, so the reading stream needs badbit exceptions enabled to see them.
+        class crc32c_istreambuf: public std::streambuf {
+        public:
+            crc32c_istreambuf(std::streambuf* const source, std::size_t const chunk_size, std::uint64_t const size)
+                : source_(source)
+                , chunk_size_(chunk_size)
+                , remaining_(size) {
+                setg(nullptr, nullptr, nullptr);
+            }
+
+        protected:
+            int_type underflow() override {
+                if(gptr() == egptr()) {
+                    if(remaining_ == 0) {
+                        return traits_type::eof();
+                    }
+
+                    auto const size = next_chunk_size();
+                    buffer_.resize(chunk_size_);
+                    read_chunk(buffer_.data(), size);
+                    setg(buffer_.data(), buffer_.data(), buffer_.data() + size);
+                }
+                return traits_type::to_int_type(*gptr());
+            }
+
+            std::streamsize xsgetn(char* const data, std::streamsize const count) override {
+                auto const size = static_cast<std::size_t>(count);
+                std::size_t done = 0;
+                while(done < size) {
+                    if(gptr() != egptr()) {
+                        auto const part = std::min(static_cast<std::size_t>(egptr() - gptr()), size - done);
+                        std::memcpy(data + done, gptr(), part);
+                        gbump(static_cast<int>(part));
+                        done += part;
+                    } else if(remaining_ == 0) {
+                        break;
+                    } else if(size - done >= next_chunk_size()) {
+                        // whole chunks are read and verified in place
+                        auto const part = next_chunk_size();
+                        read_chunk(data + done, part);
+                        done += part;
+                    } else {
+                        underflow();
+                    }
+                }
+                return static_cast<std::streamsize>(done);
+            }
+
+        private:
+            std::size_t next_chunk_size() const noexcept {
+                return static_cast<std::size_t>(std::min<std::uint64_t>(chunk_size_, remaining_));
+            }
+
+            void read_chunk(char* const data, std::size_t const size) {
+                std::uint32_t stored;
+                if(source_->sgetn(data, static_cast<std::streamsize>(size)) != static_cast<std::streamsize>(size)
+                   || source_->sgetn(reinterpret_cast<char*>(&stored), 4) != 4) {
+                    throw binary_io_error("unexpected end of data in chunk " + std::to_string(chunk_index_));
+                }
+
+                if(byteswap_on_little_endian(stored) != crc32c(0, data, size)) {
+                    throw binary_io_error("checksum mismatch in chunk " + std::to_string(chunk_index_));
+                }
+
+                remaining_ -= size;
+                ++chunk_index_;
+            }
+
+            std::streambuf* source_;
+            std::size_t chunk_size_;
+            std::uint64_t remaining_;
+            std::uint64_t chunk_index_ = 0;
+            std::vector<char> buffer_;
+        };
+
+
+    }
+
+
+}
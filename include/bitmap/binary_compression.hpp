@@ -0,0 +1,414 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "exception.hpp"
+#include "pixel.hpp"
+
+#include "detail/binary_io_flags.hpp"
+#include "detail/lz4.hpp"
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Compression codec of the binary format version 1
+    enum class binary_codec : std::uint8_t {
+        /// \brief Prefilters only, bands are stored uncompressed
+        none = 0,
+
+        /// \brief LZ4 block format, decompresses at several GB/s
+        lz4 = 1
+    };
+
+    /// \brief Settings for writing the compressed binary format version 1
+    ///
+    /// The image is split into bands of rows_per_band rows which are compressed independently,
+    /// so writing and reading can use several threads.
+    struct binary_compression {
+        binary_codec codec = binary_codec::lz4;
+
+        /// \brief Group the n-th bytes of all channel values (like Blosc), helps on multi byte types
+        bool shuffle = true;
+
+        /// \brief Store channel differences to the left neighbor, helps on smooth images
+        bool delta = false;
+
+        /// \brief Rows per independently compressed band, 0 means about 256 KiB per band
+        std::size_t rows_per_band = 0;
+
+        /// \brief Threads for compression, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Prefilter bits in the version 1 header
+        enum class binary_prefilter : std::uint8_t { shuffle = 0x01, delta = 0x02 };
+
+        /// \brief Size of the version 1 header behind the common header
+        constexpr std::size_t binary_compression_header_size = 8;
+
+        template <typename T>
+        std::size_t binary_row_bytes(std::size_t const w) noexcept {
+            if constexpr(std::is_same_v<T, bool>) {
+                return w;
+            } else {
+                return w * sizeof(T);
+            }
+        }
+
+        template <typename T>
+        std::size_t binary_band_bytes(std::size_t const w, std::size_t const rows) noexcept {
+            if constexpr(std::is_same_v<T, bool>) {
+                return (w * rows + 7) / 8;
+            } else {
+                return w * rows * sizeof(T);
+            }
+        }
+
+        /// \brief Writes the shuffled data of count values with size bytes each
+        inline void shuffle_bytes(std::byte const* in, std::byte* out, std::size_t const count, std::size_t const size) noexcept {
+            for(std::size_t i = 0; i < count; ++i) {
+                for(std::size_t b = 0; b < size; ++b) {
+                    out[b * count + i] = in[i * size + b];
+                }
+            }
+        }
+
+        /// \brief Inverse of shuffle_bytes
+        inline void unshuffle_bytes(std::byte const* in, std::byte* out, std::size_t const count, std::size_t const size) noexcept {
+            for(std::size_t b = 0; b < size; ++b) {
+                for(std::size_t i = 0; i < count; ++i) {
+                    out[i * size + b] = in[b * count + i];
+                }
+            }
+        }
+
+        template <typename T>
+        using binary_channel_integer = std::make_unsigned_t<integer_type<pixel::channel_type_t<T>>>;
+
+        /// \brief Reusable buffers of one band
+        struct binary_band_buffer {
+            std::vector<std::byte> raw;
+            std::vector<std::byte> filtered;
+            std::vector<std::byte> compressed;
+            std::vector<std::uint32_t> table;
+        };
+
+        /// \brief Filter and compress rows [y, y + rows) into buffer.compressed
+        template <typename T>
+        void compress_band(
+            bitmap<T> const& image,
+            std::size_t const y,
+            std::size_t const rows,
+            std::endian const endianness,
+            binary_compression const& options,
+            binary_band_buffer& buffer) {
+            auto const w = image.w();
+            auto const band_bytes = binary_band_bytes<T>(w, rows);
+            if(options.codec == binary_codec::lz4 && band_bytes > lz4::max_input_size) {
+                throw binary_io_error("band of " + std::to_string(band_bytes) + " bytes is too large for compression");
+            }
+
+            std::byte const* data = nullptr;
+            if constexpr(std::is_same_v<T, bool>) {
+                buffer.raw.assign(band_bytes, std::byte{0});
+                data = buffer.raw.data();
+                auto const begin = image.begin() + static_cast<std::ptrdiff_t>(y * w);
+                for(std::size_t i = 0; i < w * rows; ++i) {
+                    if(*(begin + static_cast<std::ptrdiff_t>(i))) {
+                        buffer.raw[i / 8] |= std::byte(0x80 >> (i % 8));
+                    }
+                }
+            } else {
+                using value_type = pixel::channel_type_t<T>;
+                using integer = binary_channel_integer<T>;
+                constexpr auto channels = pixel::channel_count_v<T>;
+                constexpr auto size = sizeof(value_type);
+
+                auto const source = reinterpret_cast<std::byte const*>(image.data() + y * w);
+                if(!options.delta && endianness == std::endian::native) {
+                    data = source;
+                } else {
+                    buffer.raw.resize(band_bytes);
+                    data = buffer.raw.data();
+                    auto out = buffer.raw.data();
+                    for(std::size_t row = 0; row < rows; ++row) {
+                        auto const row_data = source + row * w * sizeof(T);
+                        integer previous[channels] = {};
+                        for(std::size_t i = 0; i < w * channels; ++i) {
+                            integer value;
+                            std::memcpy(&value, row_data + i * size, size);
+                            if(options.delta) {
+                                auto const current = value;
+                                value = static_cast<integer>(value - previous[i % channels]);
+                                previous[i % channels] = current;
+                            }
+                            if(endianness != std::endian::native) {
+                                value = std::byteswap(value);
+                            }
+                            std::memcpy(out, &value, size);
+                            out += size;
+                        }
+                    }
+                }
+
+                if(options.shuffle && size > 1) {
+                    buffer.filtered.resize(band_bytes);
+                    shuffle_bytes(data, buffer.filtered.data(), band_bytes / size, size);
+                    data = buffer.filtered.data();
+                }
+            }
+
+            if(options.codec == binary_codec::lz4) {
+                buffer.compressed.resize(lz4::compress_bound(band_bytes));
+                auto const compressed_size = lz4::compress(data, band_bytes, buffer.compressed.data(), buffer.table);
+
+                // incompressible bands are stored, the reader detects this by the size
+                if(compressed_size < band_bytes) {
+                    buffer.compressed.resize(compressed_size);
+                    return;
+                }
+            }
+
+            buffer.compressed.assign(data, data + band_bytes);
+        }
+
+        /// \brief Decompress and unfilter a band into rows [y, y + rows)
+        template <typename T>
+        void decompress_band(
+            bitmap<T>& image,
+            std::size_t const y,
+            std::size_t const rows,
+            std::byte const* const in,
+            std::size_t const in_size,
+            bool const swap_endian,
+            binary_codec const codec,
+            std::uint8_t const prefilter,
+            binary_band_buffer& buffer) {
+            auto const w = image.w();
+            auto const band_bytes = binary_band_bytes<T>(w, rows);
+
+            auto const shuffle = (prefilter & std::uint8_t(binary_prefilter::shuffle)) != 0;
+            auto const delta = (prefilter & std::uint8_t(binary_prefilter::delta)) != 0;
+
+            if constexpr(std::is_same_v<T, bool>) {
+                buffer.raw.resize(band_bytes);
+                auto const out = buffer.raw.data();
+                if(in_size == band_bytes) {
+                    std::memcpy(out, in, band_bytes);
+                } else if(codec == binary_codec::lz4) {
+                    lz4::decompress(in, in_size, out, band_bytes);
+                } else {
+                    throw binary_io_error("wrong band size");
+                }
+
+                auto const begin = image.begin() + static_cast<std::ptrdiff_t>(y * w);
+                for(std::size_t i = 0; i < w * rows; ++i) {
+                    *(begin + static_cast<std::ptrdiff_t>(i)) = (out[i / 8] & std::byte(0x80 >> (i % 8))) != std::byte{0};
+                }
+            } else {
+                using value_type = pixel::channel_type_t<T>;
+                using integer = binary_channel_integer<T>;
+                constexpr auto channels = pixel::channel_count_v<T>;
+                constexpr auto size = sizeof(value_type);
+
+                auto const target = reinterpret_cast<std::byte*>(image.data() + y * w);
+                auto const unshuffle = shuffle && size > 1;
+
+                // decode straight into the bitmap unless the shuffle needs a second buffer
+                std::byte* out = target;
+                if(unshuffle) {
+                    buffer.raw.resize(band_bytes);
+                    out = buffer.raw.data();
+                }
+
+                if(in_size == band_bytes) {
+                    std::memcpy(out, in, band_bytes);
+                } else if(codec == binary_codec::lz4) {
+                    lz4::decompress(in, in_size, out, band_bytes);
+                } else {
+                    throw binary_io_error("wrong band size");
+                }
+
+                if(unshuffle) {
+                    unshuffle_bytes(out, target, band_bytes / size, size);
+                }
+
+                if(delta || swap_endian) {
+                    for(std::size_t row = 0; row < rows; ++row) {
+                        auto const row_data = target + row * w * sizeof(T);
+                        integer previous[channels] = {};
+                        for(std::size_t i = 0; i < w * channels; ++i) {
+                            integer value;
+                            std::memcpy(&value, row_data + i * size, size);
+                            if(swap_endian) {
+                                value = std::byteswap(value);
+                            }
+                            if(delta) {
+                                value = static_cast<integer>(value + previous[i % channels]);
+                                previous[i % channels] = value;
+                            }
+                            std::memcpy(row_data + i * size, &value, size);
+                        }
+                    }
+                }
+            }
+        }
+
+        /// \brief Prefilter bits for the header, bool data is never filtered
+        template <typename T>
+        std::uint8_t binary_prefilter_flags(binary_compression const& options) noexcept {
+            auto filters = std::uint8_t(0);
+            if constexpr(!std::is_same_v<T, bool>) {
+                if(options.shuffle) {
+                    filters |= std::uint8_t(binary_prefilter::shuffle);
+                }
+                if(options.delta) {
+                    filters |= std::uint8_t(binary_prefilter::delta);
+                }
+            }
+            return filters;
+        }
+
+        /// \brief Rows per band for the given settings
+        template <typename T>
+        std::size_t binary_rows_per_band(std::size_t const w, std::size_t const h, std::size_t const requested) noexcept {
+            if(requested != 0) {
+                return requested;
+            }
+
+            auto const row_bytes = std::max<std::size_t>(binary_row_bytes<T>(w), 1);
+            return std::clamp<std::size_t>((std::size_t(256) << 10) / row_bytes, 1, std::max<std::size_t>(h, 1));
+        }
+
+        inline void write_u64_be(std::ostream& os, std::uint64_t const value) {
+            auto const data = byteswap_on_little_endian(value);
+            os.write(reinterpret_cast<char const*>(&data), 8);
+        }
+
+        inline std::uint64_t read_u64_be(std::byte const* const data) noexcept {
+            std::uint64_t value;
+            std::memcpy(&value, data, 8);
+            return byteswap_on_little_endian(value);
+        }
+
+        /// \brief Writes the version 1 data behind the common header
+        template <typename T>
+        void binary_write_compressed_data(
+            bitmap<T> const& image,
+            std::ostream& os,
+            std::endian const endianness,
+            binary_compression const& options) {
+            auto const rows_per_band = binary_rows_per_band<T>(image.w(), image.h(), options.rows_per_band);
+            if(rows_per_band > 0xFFFFFFFF) {
+                throw binary_io_error("rows_per_band must fit in 32 bit");
+            }
+
+            auto const filters = binary_prefilter_flags<T>(options);
+            std::uint8_t const codec = static_cast<std::uint8_t>(options.codec);
+            std::uint16_t const reserved = 0;
+            auto const rows_per_band_bytes = byteswap_on_little_endian(static_cast<std::uint32_t>(rows_per_band));
+            os.write(reinterpret_cast<char const*>(&codec), 1);
+            os.write(reinterpret_cast<char const*>(&filters), 1);
+            os.write(reinterpret_cast<char const*>(&reserved), 2);
+            os.write(reinterpret_cast<char const*>(&rows_per_band_bytes), 4);
+
+            auto const band_count = (image.h() + rows_per_band - 1) / rows_per_band;
+            std::vector<binary_band_buffer> bands(band_count);
+            parallel_for(band_count, options.threads, [&](std::size_t const i) {
+                auto const y = i * rows_per_band;
+                compress_band(image, y, std::min(rows_per_band, image.h() - y), endianness, options, bands[i]);
+                bands[i].raw = {};
+                bands[i].filtered = {};
+                bands[i].table = {};
+            });
+
+            for(auto const& band: bands) {
+                write_u64_be(os, band.compressed.size());
+            }
+            for(auto const& band: bands) {
+                os.write(reinterpret_cast<char const*>(band.compressed.data()), static_cast<std::streamsize>(band.compressed.size()));
+            }
+        }
+
+        /// \brief Reads the version 1 data behind the common header
+        template <typename T>
+        void binary_read_compressed_data(bitmap<T>& image, std::istream& is, bool const swap_endian, std::size_t const threads) {
+            std::byte header[binary_compression_header_size];
+            is.read(reinterpret_cast<char*>(header), binary_compression_header_size);
+            if(!is.good()) {
+                throw binary_io_error("can't read compression header");
+            }
+
+            auto const codec = static_cast<binary_codec>(header[0]);
+            auto const filters = static_cast<std::uint8_t>(header[1]);
+            std::uint32_t rows_per_band;
+            std::memcpy(&rows_per_band, header + 4, 4);
+            rows_per_band = byteswap_on_little_endian(rows_per_band);
+
+            if(codec != binary_codec::none && codec != binary_codec::lz4) {
+                throw binary_io_error("unknown codec " + std::to_string(std::uint32_t(codec)));
+            }
+            if((filters & ~std::uint8_t(0x03)) != 0 || header[2] != std::byte{0} || header[3] != std::byte{0}) {
+                throw binary_io_error("unknown compression flags");
+            }
+            if(rows_per_band == 0) {
+                throw binary_io_error("rows per band is 0");
+            }
+
+            auto const band_count = (image.h() + rows_per_band - 1) / rows_per_band;
+
+            std::vector<std::byte> table(band_count * 8);
+            is.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size()));
+            if(!is.good()) {
+                throw binary_io_error("can't read band size table");
+            }
+
+            std::vector<std::size_t> offsets(band_count + 1);
+            for(std::size_t i = 0; i < band_count; ++i) {
+                auto const rows = std::min<std::size_t>(rows_per_band, image.h() - i * rows_per_band);
+                auto const size = read_u64_be(table.data() + i * 8);
+                if(size > lz4::compress_bound(binary_band_bytes<T>(image.w(), rows))) {
+                    throw binary_io_error("band size " + std::to_string(size) + " out of range");
+                }
+                offsets[i + 1] = offsets[i] + size;
+            }
+
+            std::vector<std::byte> data(offsets.back());
+            is.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if(!is.good()) {
+                throw binary_io_error("can't read binary bitmap format data");
+            }
+
+            auto const thread_count = std::min(detail::thread_count(threads), std::max<std::size_t>(band_count, 1));
+            std::vector<binary_band_buffer> buffers(thread_count);
+            parallel_for(thread_count, thread_count, [&](std::size_t const thread) {
+                auto const end = band_begin(thread + 1, thread_count, band_count);
+                for(auto i = band_begin(thread, thread_count, band_count); i < end; ++i) {
+                    auto const y = i * rows_per_band;
+                    decompress_band(image, y, std::min<std::size_t>(rows_per_band, image.h() - y), data.data() + offsets[i],
+                        offsets[i + 1] - offsets[i], swap_endian, codec, filters, buffers[thread]);
+                }
+            });
+        }
+
+
+    }
+
+
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "binary_read.hpp"
+#include "exception.hpp"
+
+#include "detail/binary_io_flags.hpp"
+#include "detail/parallel.hpp"
+#include "detail/positional_file.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Type of the channel values in a binary bitmap file
+    enum class binary_value_type : std::uint8_t {
+        unsigned_integer = 0x00,
+        signed_integer = 0x01,
+        floating_point = 0x02,
+        boolean = 0x03,
+        bfloat = 0x04
+    };
+
+    /// \brief Channel value type stored in header
+    inline binary_value_type binary_type(binary_header const& header) noexcept {
+        return static_cast<binary_value_type>(header.flags & 0x0F);
+    }
+
+    /// \brief Byte order of the channel values stored in header
+    inline std::endian binary_endianness(binary_header const& header) noexcept {
+        return (header.flags & detail::binary_endian_flag_bits)
+                == std::uint8_t(detail::binary_endian_flags::is_little_endian)
+            ? std::endian::little
+            : std::endian::big;
+    }
+
+    /// \brief true if header describes a masked bitmap with a mask plane behind the values
+    inline bool binary_masked(binary_header const& header) noexcept {
+        return (header.flags & detail::binary_masked_flag) != 0;
+    }
+
+
+    /// \brief Read the binary bitmap format header of a file
+    ///
+    /// Unlike binary_read_header on a std::ifstream this is a single open and read of 24 bytes.
+    ///
+    /// \throw binary_io_error
+    inline binary_header binary_probe(std::string const& filename) {
+        detail::positional_file const file(filename, detail::positional_file::mode::read);
+
+        std::byte data[detail::binary_header_size];
+        try {
+            file.read(data, sizeof(data), 0);
+            return detail::binary_parse_header(data, sizeof(data));
+        } catch(binary_io_error const& error) {
+            throw binary_io_error(std::string(error.what()) + ": " + filename);
+        }
+    }
+
+
+    /// \brief Result of probing one file
+    struct binary_probe_result {
+        std::string filename;
+
+        /// \brief Header of the file, only valid if error is empty
+        binary_header header{};
+
+        /// \brief Message of the binary_io_error if the file is not a binary bitmap
+        std::string error;
+
+        bool valid() const noexcept {
+            return error.empty();
+        }
+    };
+
+    /// \brief Probe many files at once, results are in the order of filenames
+    ///
+    /// Files are probed on threads threads, 0 means one per hardware thread. Errors of single
+    /// files are reported in their result.
+    inline std::vector<binary_probe_result> binary_probe(
+        std::vector<std::string> const& filenames,
+        std::size_t const threads = 0) {
+        std::vector<binary_probe_result> results(filenames.size());
+        detail::parallel_for(results.size(), threads, [&](std::size_t const i) {
+            auto& result = results[i];
+            result.filename = filenames[i];
+            try {
+                result.header = binary_probe(filenames[i]);
+            } catch(binary_io_error const& error) {
+                result.error = error.what();
+            }
+        });
+        return results;
+    }
+
+
+    /// \brief Settings of binary_probe_directory
+    struct binary_probe_options {
+        /// \brief Also scan all subdirectories
+        bool recursive = false;
+
+        /// \brief Only probe files with this extension (like ".bbf"), empty means all files
+        std::string extension;
+
+        /// \brief Threads for probing, 0 means one per hardware thread
+        std::size_t threads = 0;
+    };
+
+    /// \brief Probe all regular files in directory, results are sorted by filename
+    ///
+    /// \throw std::filesystem::filesystem_error if the directory can't be listed
+    inline std::vector<binary_probe_result> binary_probe_directory(
+        std::filesystem::path const& directory,
+        binary_probe_options const& options = {}) {
+        std::vector<std::string> filenames;
+        auto const add = [&](std::filesystem::directory_entry const& entry) {
+            if(entry.is_regular_file()
+               && (options.extension.empty() || entry.path().extension() == options.extension)) {
+                filenames.push_back(entry.path().string());
+            }
+        };
+
+        if(options.recursive) {
+            for(auto const& entry: std::filesystem::recursive_directory_iterator(directory)) {
+                add(entry);
+            }
+        } else {
+            for(auto const& entry: std::filesystem::directory_iterator(directory)) {
+                add(entry);
+            }
+        }
+
+        std::sort(filenames.begin(), filenames.end());
+        return binary_probe(filenames, options.threads);
+    }
+
+
+}
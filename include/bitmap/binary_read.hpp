@@ -1,14 +1,20 @@
 #pragma once
 
+#include "binary_checksum.hpp"
+#include "binary_compression.hpp"
 #include "bitmap.hpp"
 #include "exception.hpp"
+#include "masked_bitmap.hpp"
 
 #include "detail/binary_io_flags.hpp"
+#include "detail/binary_tile_layout.hpp"
 #include "detail/valid_binary_format.hpp"
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <string>
 
@@ -25,188 +31,323 @@ namespace bmp {
         std::uint64_t h;
     };
 
-    /// \brief Read binary bitmap format header from std::istream
-    ///
-    /// \throw binary_io_error
-    inline binary_header binary_read_header(std::istream& is) {
-        // read the file header
-        uint32_t magic;
-        is.read(reinterpret_cast<char*>(&magic), 4);
-        if(magic != detail::big_endian_io_magic) {
-            throw binary_io_error("wrong magic number");
-        }
+    namespace detail {
 
-        uint8_t version;
-        is.read(reinterpret_cast<char*>(&version), 1);
-        if(version != 0x00) {
-            throw binary_io_error(
-                "file format version is " + std::to_string(version)
-                + ", but only version 0 is supported");
-        }
 
-        std::uint8_t channel_size;
-        std::uint8_t channel_count;
-        std::uint8_t flags;
-        std::uint64_t w_bytes;
-        std::uint64_t h_bytes;
+        /// \brief Size of the common header of all versions
+        constexpr std::size_t binary_header_size = 24;
 
-        is.read(reinterpret_cast<char*>(&channel_size), 1);
-        is.read(reinterpret_cast<char*>(&channel_count), 1);
-        is.read(reinterpret_cast<char*>(&flags), 1);
-        is.read(reinterpret_cast<char*>(&w_bytes), 8);
-        is.read(reinterpret_cast<char*>(&h_bytes), 8);
+        /// \brief Parse the common header from the first size bytes of a file
+        ///
+        /// \throw binary_io_error
+        inline binary_header binary_parse_header(std::byte const* const data, std::size_t const size) {
+            std::uint32_t magic = 0;
+            if(size >= 4) {
+                std::memcpy(&magic, data, 4);
+            }
+            if(magic != big_endian_io_magic) {
+                throw binary_io_error("wrong magic number");
+            }
 
-        w_bytes = detail::byteswap_on_little_endian(w_bytes);
-        h_bytes = detail::byteswap_on_little_endian(h_bytes);
+            if(size >= 5 && std::uint8_t(data[4]) > 0x03) {
+                throw binary_io_error(
+                    "file format version is " + std::to_string(std::uint8_t(data[4]))
+                    + ", but only versions 0 to 3 are supported");
+            }
 
-        if(!is.good()) {
-            throw binary_io_error("can't read binary bitmap format header");
+            if(size < binary_header_size) {
+                throw binary_io_error("can't read binary bitmap format header");
+            }
+
+            std::uint64_t w_bytes;
+            std::uint64_t h_bytes;
+            std::memcpy(&w_bytes, data + 8, 8);
+            std::memcpy(&h_bytes, data + 16, 8);
+
+            return {
+                std::uint8_t(data[4]),
+                std::uint8_t(data[5]),
+                std::uint8_t(data[6]),
+                std::uint8_t(data[7]),
+                byteswap_on_little_endian(w_bytes),
+                byteswap_on_little_endian(h_bytes)};
         }
 
-        return {version, channel_size, channel_count, flags, w_bytes, h_bytes};
+
     }
 
-    /// \brief Read binary bitmap format data from std::istream
+    /// \brief Read binary bitmap format header from std::istream
     ///
     /// \throw binary_io_error
-    template <typename T>
-    void binary_read_data(
-        bitmap<T>& bitmap,
-        std::istream& is,
-        binary_header const& header,
-        bool ignore_signed = true) {
-        static_assert(
-            detail::is_valid_binary_format_v<T>,
-            "Your value_type is not supported by bmp::binary_read");
+    inline binary_header binary_read_header(std::istream& is) {
+        std::byte data[detail::binary_header_size];
+        is.read(reinterpret_cast<char*>(data), detail::binary_header_size);
+        return detail::binary_parse_header(data, static_cast<std::size_t>(is.gcount()));
+    }
 
-        using pixel::channel_count_v;
-        using value_type = pixel::channel_type_t<T>;
-        using detail::binary_endian_flags;
-        using detail::binary_type_flags;
+    namespace detail {
 
-        static_assert(sizeof(value_type) <= 256);
-        static_assert(sizeof(T) == sizeof(value_type) * channel_count_v<T>);
 
-        auto const fix_flag = [ignore_signed](binary_type_flags flag) {
-            if(!ignore_signed)
+        /// \brief Check that the header describes data readable as T
+        ///
+        /// \return true if the data must be byteswapped
+        /// \throw binary_io_error
+        template <typename T>
+        bool binary_check_format(binary_header const& header, bool const ignore_signed, bool const masked = false) {
+            static_assert(
+                detail::is_valid_binary_format_v<T>,
+                "Your value_type is not supported by bmp::binary_read");
+
+            using pixel::channel_count_v;
+            using value_type = pixel::channel_type_t<T>;
+            using detail::binary_endian_flags;
+            using detail::binary_type_flags;
+
+            static_assert(sizeof(value_type) <= 256);
+            static_assert(sizeof(T) == sizeof(value_type) * channel_count_v<T>);
+
+            auto const fix_flag = [ignore_signed](binary_type_flags flag) {
+                if(!ignore_signed)
+                    return flag;
+                if(flag == binary_type_flags::is_signed) {
+                    return binary_type_flags::is_unsigned;
+                }
                 return flag;
-            if(flag == binary_type_flags::is_signed) {
-                return binary_type_flags::is_unsigned;
+            };
+
+
+            std::uint8_t const ref_flags = detail::binary_io_flags_v<value_type>;
+
+            auto const ref_type_flag = fix_flag(binary_type_flags(ref_flags & 0x0F));
+            auto const ref_endian_flag = binary_endian_flags(ref_flags & binary_endian_flag_bits);
+
+            auto const test_type_flag = fix_flag(binary_type_flags(header.flags & 0x0F));
+            auto const test_endian_flag = binary_endian_flags(header.flags & binary_endian_flag_bits);
+
+            if((header.flags & binary_masked_flag) != 0 && !masked) {
+                throw binary_io_error("data is masked, read it into a masked_bitmap");
+            }
+            if((header.flags & binary_masked_flag) == 0 && masked) {
+                throw binary_io_error("data is not masked");
             }
-            return flag;
-        };
 
 
-        std::uint8_t const ref_flags = detail::binary_io_flags_v<value_type>;
+            if(test_type_flag != ref_type_flag) {
+                auto const print_type_flag = [ignore_signed](binary_type_flags flag) {
+                    switch(flag) {
+                    case binary_type_flags::is_unsigned:
+                        if(ignore_signed)
+                            return "integer";
+                        return "unsigned integer";
+                    case binary_type_flags::is_signed:
+                        if(ignore_signed)
+                            return "integer";
+                        return "signed integer";
+                    case binary_type_flags::is_floating_point:
+                        return "floating point";
+                    case binary_type_flags::is_bool:
+                        return "bool";
+                    case binary_type_flags::is_bfloat:
+                        return "bfloat";
+                    default:
+                        throw std::logic_error(
+                            "unknown binary_type_flags flag: " + std::to_string(std::uint32_t(flag)));
+                    }
+                };
 
-        auto const ref_type_flag = fix_flag(binary_type_flags(ref_flags & 0x0F));
-        auto const ref_endian_flag = binary_endian_flags(ref_flags & 0xF0);
+                std::ostringstream is;
+                is << "wrong type " << print_type_flag(test_type_flag) << ", expected "
+                   << print_type_flag(ref_type_flag);
+                throw binary_io_error(is.str());
+            }
 
-        auto const test_type_flag = fix_flag(binary_type_flags(header.flags & 0x0F));
-        auto const test_endian_flag = binary_endian_flags(header.flags & 0xF0);
 
+            if(header.channel_size != sizeof(value_type)) {
+                throw binary_io_error(
+                    "wrong value_type size " + std::to_string(header.channel_size) + ", expected "
+                    + std::to_string(sizeof(value_type)));
+            }
+
+            if(header.channel_count != channel_count_v<T>) {
+                throw binary_io_error(
+                    "wrong channel count " + std::to_string(header.channel_count) + ", expected "
+                    + std::to_string(channel_count_v<T>));
+            }
 
-        if(test_type_flag != ref_type_flag) {
-            auto const print_type_flag = [ignore_signed](binary_type_flags flag) {
+            auto const print_endian = [](binary_endian_flags flag) {
+                using namespace std::literals::string_literals;
                 switch(flag) {
-                case binary_type_flags::is_unsigned:
-                    if(ignore_signed)
-                        return "integer";
-                    return "unsigned integer";
-                case binary_type_flags::is_signed:
-                    if(ignore_signed)
-                        return "integer";
-                    return "signed integer";
-                case binary_type_flags::is_floating_point:
-                    return "floating point";
-                case binary_type_flags::is_bool:
-                    return "bool";
+                case binary_endian_flags::is_big_endian:
+                    return "big"s;
+                case binary_endian_flags::is_little_endian:
+                    return "little"s;
                 default:
                     throw std::logic_error(
-                        "unknown binary_type_flags flag: " + std::to_string(std::uint32_t(flag)));
+                        "unknown binary_endian_flags flag: " + std::to_string(std::uint32_t(flag)));
                 }
             };
 
-            std::ostringstream is;
-            is << "wrong type " << print_type_flag(test_type_flag) << ", expected "
-               << print_type_flag(ref_type_flag);
-            throw binary_io_error(is.str());
+            if constexpr(!detail::endian_supported<value_type>) {
+                if(test_endian_flag != ref_endian_flag) {
+                    throw std::runtime_error("data in "
+                        + print_endian(test_endian_flag) + " endian, expected "
+                        + print_endian(ref_endian_flag) + " endian, conversion is "
+                        "not supported for requested type");
+                }
+            } else {
+                print_endian(test_endian_flag); // throws if not valid
+            }
+
+            return test_endian_flag != ref_endian_flag;
         }
 
+        /// \brief Read the uncompressed pixel data of version 0 into the sized bitmap
+        template <typename T>
+        void binary_read_payload(bitmap<T>& bitmap, std::istream& is, bool const swap_endian) {
+            using pixel::channel_count_v;
+            using value_type = pixel::channel_type_t<T>;
+
+            auto const pixel_count = bitmap.point_count();
+            if constexpr(std::is_same_v<T, bool>) {
+                std::vector<char> buffer((pixel_count + 7) / 8);
+                is.read(buffer.data(), buffer.size());
+                for(std::size_t i = 0; i < pixel_count; ++i) {
+                    *(bitmap.begin() + i) = (buffer[i / 8] & (1 << (7 - (i % 8)))) != 0;
+                }
+            } else if(!swap_endian) {
+                is.read(reinterpret_cast<char*>(bitmap.data()), pixel_count * sizeof(T));
+            } else if constexpr(std::integral<value_type>) {
+                is.read(reinterpret_cast<char*>(bitmap.data()), pixel_count * sizeof(T));
 
-        if(header.channel_size != sizeof(value_type)) {
-            throw binary_io_error(
-                "wrong value_type size " + std::to_string(header.channel_size) + ", expected "
-                + std::to_string(sizeof(value_type)));
+                // fix endianness
+                for(auto& v: bitmap) {
+                    for(std::size_t i = 0; i < channel_count_v<T>; ++i) {
+                        auto& c = *(reinterpret_cast<value_type*>(&v) + i);
+                        c = std::byteswap(c);
+                    }
+                }
+            } else {
+                using buffer_value_type = detail::integer_type<value_type>;
+                using buffer_type = std::array<buffer_value_type, channel_count_v<T>>;
+                bmp::bitmap<buffer_type> buffer(bitmap.w(), bitmap.h());
+
+                is.read(reinterpret_cast<char*>(buffer.data()), pixel_count * sizeof(T));
+
+                // fix endianness
+                std::ranges::transform(buffer, bitmap.begin(),
+                    [](buffer_type const& channels){
+                        T pixel;
+                        for(std::size_t i = 0; i < channel_count_v<T>; ++i) {
+                            *(reinterpret_cast<value_type*>(&pixel) + i) = detail::byteswap_to<value_type>(channels[i]);
+                        }
+                        return pixel;
+                    });
+            }
         }
 
-        if(header.channel_count != channel_count_v<T>) {
-            throw binary_io_error(
-                "wrong channel count " + std::to_string(header.channel_count) + ", expected "
-                + std::to_string(channel_count_v<T>));
-        }
 
-        auto const print_endian = [](binary_endian_flags flag) {
-            using namespace std::literals::string_literals;
-            switch(flag) {
-            case binary_endian_flags::is_big_endian:
-                return "big"s;
-            case binary_endian_flags::is_little_endian:
-                return "little"s;
-            default:
-                throw std::logic_error(
-                    "unknown binary_endian_flags flag: " + std::to_string(std::uint32_t(flag)));
+        /// \brief Read the mask plane of a masked bitmap into the sized mask, see binary_write_mask
+        inline void binary_read_mask(bitmask& mask, std::istream& is) {
+            auto const word_count = mask.words_per_row() * mask.h();
+            is.read(reinterpret_cast<char*>(mask.data()), word_count * sizeof(bitmask::word_type));
+
+            if constexpr(std::endian::native != std::endian::little) {
+                for(std::size_t i = 0; i < word_count; ++i) {
+                    mask.data()[i] = std::byteswap(mask.data()[i]);
+                }
             }
-        };
-
-        if constexpr(!detail::endian_supported<value_type>) {
-            if(test_endian_flag != ref_endian_flag) {
-                throw std::runtime_error("data in "
-                    + print_endian(test_endian_flag) + " endian, expected "
-                    + print_endian(ref_endian_flag) + " endian, conversion is "
-                    "not supported for requested type");
+
+            // bits behind the width must be zero
+            auto const tail = mask.w() % bitmask::word_bits;
+            if(tail != 0) {
+                auto const last = (bitmask::word_type(1) << tail) - 1;
+                for(std::size_t y = 0; y < mask.h(); ++y) {
+                    mask.row(y)[mask.words_per_row() - 1] &= last;
+                }
             }
-        } else {
-            print_endian(test_endian_flag); // throws if not valid
         }
 
+        /// \brief The 24 bytes of the common header as stored in the file
+        inline std::array<std::byte, 24> binary_header_bytes(binary_header const& header) noexcept {
+            std::array<std::byte, 24> bytes;
+            std::memcpy(bytes.data(), &big_endian_io_magic, 4);
+            bytes[4] = std::byte{header.version};
+            bytes[5] = std::byte{header.channel_size};
+            bytes[6] = std::byte{header.channel_count};
+            bytes[7] = std::byte{header.flags};
+            write_u64_be(bytes.data() + 8, header.w);
+            write_u64_be(bytes.data() + 16, header.h);
+            return bytes;
+        }
 
-        bitmap.resize(header.w, header.h);
-        auto pixel_count = bitmap.point_count();
-        if constexpr(std::is_same_v<T, bool>) {
-            std::vector<char> buffer((pixel_count + 7) / 8);
-            is.read(buffer.data(), buffer.size());
-            for(std::size_t i = 0; i < pixel_count; ++i) {
-                *(bitmap.begin() + i) = (buffer[i / 8] & (1 << (7 - (i % 8)))) != 0;
+        /// \brief Read and verify the version 3 header behind the common header, returns the chunk size
+        ///
+        /// Called before the bitmap is resized, so a corrupt size is detected before allocation.
+        inline std::size_t binary_read_checksum_header(std::istream& is, binary_header const& header) {
+            std::byte checksum_header[binary_checksum_header_size];
+            is.read(reinterpret_cast<char*>(checksum_header), binary_checksum_header_size);
+            if(!is.good()) {
+                throw binary_io_error("can't read checksum header");
             }
-        } else if(test_endian_flag == ref_endian_flag) {
-            is.read(reinterpret_cast<char*>(bitmap.data()), pixel_count * sizeof(T));
-        } else if constexpr(std::integral<value_type>) {
-            is.read(reinterpret_cast<char*>(bitmap.data()), pixel_count * sizeof(T));
-
-            // fix endianness
-            for(auto& v: bitmap) {
-                for(std::size_t i = 0; i < channel_count_v<T>; ++i) {
-                    auto& c = *(reinterpret_cast<value_type*>(&v) + i);
-                    c = std::byteswap(c);
-                }
+
+            auto const header_bytes = binary_header_bytes(header);
+            auto const header_crc = crc32c(crc32c(0, header_bytes.data(), header_bytes.size()), checksum_header, 4);
+            if(header_crc != read_u32_be(checksum_header + 4)) {
+                throw binary_io_error("header checksum mismatch");
             }
-        } else {
-            using buffer_value_type = detail::integer_type<value_type>;
-            using buffer_type = std::array<buffer_value_type, channel_count_v<T>>;
-            bmp::bitmap<buffer_type> buffer(header.w, header.h);
 
-            is.read(reinterpret_cast<char*>(buffer.data()), pixel_count * sizeof(T));
+            auto const chunk_size = read_u32_be(checksum_header);
+            if(chunk_size == 0 || chunk_size > binary_max_chunk_size) {
+                throw binary_io_error("invalid chunk size " + std::to_string(chunk_size));
+            }
+            return chunk_size;
+        }
 
-            // fix endianness
-            std::ranges::transform(buffer, bitmap.begin(),
-                [](buffer_type const& channels){
-                    T pixel;
-                    for(std::size_t i = 0; i < channel_count_v<T>; ++i) {
-                        *(reinterpret_cast<value_type*>(&pixel) + i) = detail::byteswap_to<value_type>(channels[i]);
-                    }
-                    return pixel;
-                });
+        /// \brief Read the chunks of version 3 and verify their checksums while reading
+        template <typename T>
+        void binary_read_checksummed_data(
+            bitmap<T>& bitmap,
+            std::istream& is,
+            std::size_t const chunk_size,
+            bool const swap_endian) {
+            crc32c_istreambuf buffer(is.rdbuf(), chunk_size, binary_band_bytes<T>(bitmap.w(), bitmap.h()));
+            std::istream checked(&buffer);
+            checked.exceptions(std::ios_base::badbit);
+            binary_read_payload(bitmap, checked, swap_endian);
+
+            if(!checked.good()) {
+                throw binary_io_error("can't read binary bitmap format data");
+            }
+        }
+    }
+
+
+    /// \brief Read binary bitmap format data from std::istream
+    ///
+    /// Bands of compressed data (version 1) are decompressed on up to threads threads, 0 means
+    /// one per hardware thread. Of tiled data (version 2) the full resolution level is read, the
+    /// stream must be seekable then. Checksummed data (version 3) is verified chunk by chunk.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_read_data(
+        bitmap<T>& bitmap,
+        std::istream& is,
+        binary_header const& header,
+        bool ignore_signed = true,
+        std::size_t threads = 1) {
+        auto const swap_endian = detail::binary_check_format<T>(header, ignore_signed);
+        auto const chunk_size = header.version == 0x03 ? detail::binary_read_checksum_header(is, header) : 0;
+
+        bitmap.resize(header.w, header.h);
+        if(header.version == 0x01) {
+            detail::binary_read_compressed_data(bitmap, is, swap_endian, threads);
+        } else if(header.version == 0x02) {
+            detail::binary_read_tiled_data(bitmap, is, swap_endian);
+        } else if(header.version == 0x03) {
+            detail::binary_read_checksummed_data(bitmap, is, chunk_size, swap_endian);
+        } else {
+            detail::binary_read_payload(bitmap, is, swap_endian);
         }
 
         if(!is.good()) {
@@ -218,29 +359,84 @@ namespace bmp {
     ///
     /// \throw binary_io_error
     template <typename T>
-    bitmap<T>
-        binary_read_data(std::istream& is, binary_header const& header, bool ignore_signed = true) {
+    bitmap<T> binary_read_data(
+        std::istream& is,
+        binary_header const& header,
+        bool ignore_signed = true,
+        std::size_t threads = 1) {
         bitmap<T> bitmap;
-        binary_read_data(bitmap, is, header, ignore_signed);
+        binary_read_data(bitmap, is, header, ignore_signed, threads);
         return bitmap;
     }
 
-    /// \brief Read bitmap from std::istream
+    /// \brief Read masked binary bitmap format data from std::istream
     ///
     /// \throw binary_io_error
     template <typename T>
-    void binary_read(bitmap<T>& bitmap, std::istream& is, bool ignore_signed = true) {
+    void binary_read_data(
+        masked_bitmap<T>& bitmap,
+        std::istream& is,
+        binary_header const& header,
+        bool ignore_signed = true) {
+        auto const swap_endian = detail::binary_check_format<T>(header, ignore_signed, true);
+        if(header.version != 0x00) {
+            throw binary_io_error(
+                "masked data in version " + std::to_string(header.version) + ", only version 0 is supported");
+        }
+
+        bitmap.resize(header.w, header.h);
+        detail::binary_read_payload(bitmap.values(), is, swap_endian);
+        detail::binary_read_mask(bitmap.mask(), is);
+
+        if(!is.good()) {
+            throw binary_io_error("can't read binary bitmap format data");
+        }
+    }
+
+    /// \brief Read masked bitmap from std::istream
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_read(masked_bitmap<T>& bitmap, std::istream& is, bool ignore_signed = true) {
         auto const header = binary_read_header(is);
         binary_read_data(bitmap, is, header, ignore_signed);
     }
 
+    /// \brief Read masked bitmap into a bitmap of masked pixels from std::istream
+    ///
+    /// The unnamed last parameter is the thread count of the other overloads. Masked data is
+    /// only stored uncompressed (version 0), which is read on one thread, so it is ignored.
+    /// It exists so binary_read(bitmap, filename, ignore_signed, threads) selects this overload
+    /// for masked pixels too.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_read(
+        bitmap<pixel::basic_masked_pixel<T>>& bitmap,
+        std::istream& is,
+        bool ignore_signed = true,
+        std::size_t /* threads */ = 1) {
+        masked_bitmap<T> masked;
+        binary_read(masked, is, ignore_signed);
+        bitmap = combine_mask(masked);
+    }
+
     /// \brief Read bitmap from std::istream
     ///
     /// \throw binary_io_error
     template <typename T>
-    bitmap<T> binary_read(std::istream& is, bool ignore_signed = true) {
+    void binary_read(bitmap<T>& bitmap, std::istream& is, bool ignore_signed = true, std::size_t threads = 1) {
+        auto const header = binary_read_header(is);
+        binary_read_data(bitmap, is, header, ignore_signed, threads);
+    }
+
+    /// \brief Read bitmap from std::istream
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    bitmap<T> binary_read(std::istream& is, bool ignore_signed = true, std::size_t threads = 1) {
         bitmap<T> bitmap;
-        binary_read(bitmap, is, ignore_signed);
+        binary_read(bitmap, is, ignore_signed, threads);
         return bitmap;
     }
 
@@ -248,7 +444,11 @@ namespace bmp {
     ///
     /// \throw binary_io_error
     template <typename T>
-    void binary_read(bitmap<T>& bitmap, std::string const& filename, bool ignore_signed = true) {
+    void binary_read(
+        bitmap<T>& bitmap,
+        std::string const& filename,
+        bool ignore_signed = true,
+        std::size_t threads = 1) {
         std::ifstream is(filename.c_str(), std::ios_base::binary);
 
         if(!is.is_open()) {
@@ -256,7 +456,7 @@ namespace bmp {
         }
 
         try {
-            binary_read(bitmap, is, ignore_signed);
+            binary_read(bitmap, is, ignore_signed, threads);
         } catch(binary_io_error const& error) {
             throw binary_io_error(std::string(error.what()) + ": " + filename);
         }
@@ -266,11 +466,30 @@ namespace bmp {
     ///
     /// \throw binary_io_error
     template <typename T>
-    bitmap<T> binary_read(std::string const& filename, bool ignore_signed = true) {
+    bitmap<T> binary_read(std::string const& filename, bool ignore_signed = true, std::size_t threads = 1) {
         bitmap<T> bitmap;
-        binary_read(bitmap, filename, ignore_signed);
+        binary_read(bitmap, filename, ignore_signed, threads);
         return bitmap;
     }
 
 
+    /// \brief Read masked bitmap from disk by a given filename
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_read(masked_bitmap<T>& bitmap, std::string const& filename, bool ignore_signed = true) {
+        std::ifstream is(filename.c_str(), std::ios_base::binary);
+
+        if(!is.is_open()) {
+            throw binary_io_error("can't open file: " + filename);
+        }
+
+        try {
+            binary_read(bitmap, is, ignore_signed);
+        } catch(binary_io_error const& error) {
+            throw binary_io_error(std::string(error.what()) + ": " + filename);
+        }
+    }
+
+
 }
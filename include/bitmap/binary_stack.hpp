@@ -0,0 +1,372 @@
+#pragma once
+
+#include "binary_compression.hpp"
+#include "binary_read.hpp"
+#include "binary_write.hpp"
+#include "bitmap.hpp"
+#include "exception.hpp"
+#include "get_size.hpp"
+#include "size.hpp"
+
+#include "detail/binary_io_flags.hpp"
+#include "detail/binary_tile_layout.hpp"
+#include "detail/mapped_file.hpp"
+#include "detail/parallel.hpp"
+#include "detail/positional_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace bmp {
+
+
+    namespace detail {
+
+
+        /// \brief "bbs!" in big endian
+        constexpr auto big_endian_stack_magic = byteswap_on_little_endian(std::uint32_t(0x62627321));
+
+        /// \brief Size of the stack header including the frame header
+        constexpr std::size_t binary_stack_header_size = 48;
+
+        /// \brief Offset of the binary format header that describes every frame
+        constexpr std::size_t binary_stack_frame_header_offset = 24;
+
+        /// \brief Settings of a stack file
+        struct binary_stack_header {
+            binary_codec codec;
+            std::uint8_t filters;
+            std::uint64_t frame_count;
+            std::uint64_t index_offset;
+        };
+
+        inline void write_stack_header(std::byte* const out, binary_stack_header const& header) noexcept {
+            std::memcpy(out, &big_endian_stack_magic, 4);
+            out[4] = std::byte{0};
+            out[5] = static_cast<std::byte>(header.codec);
+            out[6] = static_cast<std::byte>(header.filters);
+            out[7] = std::byte{0};
+            write_u64_be(out + 8, header.frame_count);
+            write_u64_be(out + 16, header.index_offset);
+        }
+
+        /// \throw binary_io_error
+        inline binary_stack_header read_stack_header(std::byte const* const in) {
+            std::uint32_t magic;
+            std::memcpy(&magic, in, 4);
+            if(magic != big_endian_stack_magic) {
+                throw binary_io_error("wrong magic number");
+            }
+            if(in[4] != std::byte{0}) {
+                throw binary_io_error(
+                    "stack format version is " + std::to_string(std::uint32_t(in[4])) + ", but only version 0 is supported");
+            }
+
+            binary_stack_header const header{
+                static_cast<binary_codec>(in[5]), static_cast<std::uint8_t>(in[6]), read_u64_be(in + 8),
+                read_u64_be(in + 16)};
+
+            if(header.codec != binary_codec::none && header.codec != binary_codec::lz4) {
+                throw binary_io_error("unknown codec " + std::to_string(std::uint32_t(header.codec)));
+            }
+            if((header.filters & ~std::uint8_t(0x03)) != 0 || in[7] != std::byte{0}) {
+                throw binary_io_error("unknown compression flags");
+            }
+            return header;
+        }
+
+
+    }
+
+
+    /// \brief Appends equally sized frames to a stack file
+    ///
+    /// The stack file holds one header, the frames in the order they were appended and an index
+    /// with offset and size of every frame, which close() writes behind the last frame. Every
+    /// frame is compressed independently with the given settings (rows_per_band and threads are
+    /// not used). Frames of a stack that was never closed are still readable if the codec is
+    /// binary_codec::none, since all of them have the same size then.
+    template <typename T>
+    class binary_stack_writer {
+    public:
+        /// \throw binary_io_error
+        binary_stack_writer(
+            std::string filename,
+            std::size_t const w,
+            std::size_t const h,
+            binary_compression const& compression = {binary_codec::none, false},
+            std::endian const endianness = std::endian::native)
+            : file_(std::move(filename), detail::positional_file::mode::write)
+            , w_(w)
+            , h_(h)
+            , compression_(compression)
+            , endianness_(endianness) {
+            std::ostringstream os;
+            detail::binary_write_header<T>(os, w, h, endianness, 0x00);
+            auto const frame_header = os.str();
+
+            std::memcpy(header_ + detail::binary_stack_frame_header_offset, frame_header.data(), frame_header.size());
+            detail::write_stack_header(header_, stack_header());
+            file_.write(header_, sizeof(header_), 0);
+        }
+
+        binary_stack_writer(binary_stack_writer const&) = delete;
+        binary_stack_writer& operator=(binary_stack_writer const&) = delete;
+
+        /// \brief Calls close(), errors are ignored
+        ~binary_stack_writer() {
+            if(!closed_) {
+                try {
+                    close();
+                } catch(...) {
+                }
+            }
+        }
+
+        ::bmp::size<std::size_t> frame_size() const noexcept {
+            return {w_, h_};
+        }
+
+        /// \brief Number of frames appended so far
+        std::size_t frame_count() const {
+            std::lock_guard lock(mutex_);
+            return index_.size();
+        }
+
+        /// \brief Compress and append a frame, returns its position in the stack
+        ///
+        /// Thread safe, frames are stored in the order in which their compression finished.
+        ///
+        /// \throw binary_io_error
+        std::size_t append(bitmap<T> const& frame) {
+            if(frame.w() != w_ || frame.h() != h_) {
+                throw std::invalid_argument(
+                    "frame size " + std::to_string(frame.w()) + "x" + std::to_string(frame.h()) + " expected "
+                    + std::to_string(w_) + "x" + std::to_string(h_));
+            }
+
+            detail::binary_band_buffer buffer;
+            detail::compress_band(frame, 0, h_, endianness_, compression_, buffer);
+            auto const size = buffer.compressed.size();
+
+            std::unique_lock lock(mutex_);
+            if(closed_) {
+                throw std::logic_error("binary_stack_writer is closed");
+            }
+            auto const offset = next_offset_;
+            auto const position = index_.size();
+            next_offset_ += size;
+            index_.push_back({offset, size});
+            lock.unlock();
+
+            file_.write(buffer.compressed.data(), size, offset);
+            return position;
+        }
+
+        /// \brief Write index and final header and close the file, no frames can be appended afterwards
+        ///
+        /// \throw binary_io_error
+        void close() {
+            std::lock_guard lock(mutex_);
+            if(closed_) {
+                return;
+            }
+            closed_ = true;
+
+            std::vector<std::byte> index(index_.size() * detail::binary_tile_entry_size);
+            detail::write_tile_index(index.data(), index_);
+            file_.write(index.data(), index.size(), next_offset_);
+
+            // the header is written last, so it only points to a complete index
+            detail::write_stack_header(header_, stack_header());
+            file_.write(header_, sizeof(header_), 0);
+            file_.close();
+        }
+
+    private:
+        detail::binary_stack_header stack_header() const noexcept {
+            return {
+                compression_.codec, detail::binary_prefilter_flags<T>(compression_), index_.size(),
+                closed_ ? next_offset_ : 0};
+        }
+
+        detail::positional_file file_;
+        std::size_t const w_;
+        std::size_t const h_;
+        binary_compression const compression_;
+        std::endian const endianness_;
+        std::byte header_[detail::binary_stack_header_size] = {};
+
+        mutable std::mutex mutex_;
+        std::vector<detail::binary_tile_entry> index_;
+        std::uint64_t next_offset_ = detail::binary_stack_header_size;
+        bool closed_ = false;
+    };
+
+
+    /// \brief Random access to the frames of a stack file
+    ///
+    /// The file is memory mapped, the constructor only parses header and index. Every frame is
+    /// decoded straight from the mapping without touching the others. All read functions are
+    /// thread safe.
+    template <typename T>
+    class binary_stack_reader {
+    public:
+        /// \throw binary_io_error
+        explicit binary_stack_reader(std::string filename, bool const ignore_signed = true)
+            : file_(std::move(filename)) {
+            try {
+                auto const file_size = file_.size();
+                if(file_size < detail::binary_stack_header_size) {
+                    throw binary_io_error("can't read stack header");
+                }
+
+                header_ = detail::read_stack_header(file_.data());
+
+                std::istringstream is(std::string(
+                    reinterpret_cast<char const*>(file_.data() + detail::binary_stack_frame_header_offset), 24));
+                auto const frame_header = binary_read_header(is);
+                if(frame_header.version != 0x00) {
+                    throw binary_io_error("frame header version is " + std::to_string(frame_header.version) + ", expected 0");
+                }
+                swap_endian_ = detail::binary_check_format<T>(frame_header, ignore_signed);
+                w_ = static_cast<std::size_t>(frame_header.w);
+                h_ = static_cast<std::size_t>(frame_header.h);
+                if(w_ != 0 && h_ > file_size / w_) {
+                    throw binary_io_error("frame size " + std::to_string(w_) + "x" + std::to_string(h_) + " out of range");
+                }
+
+                auto const frame_bytes = detail::binary_band_bytes<T>(w_, h_);
+                if(header_.index_offset == 0) {
+                    read_unclosed(frame_bytes);
+                } else {
+                    read_index(frame_bytes);
+                }
+            } catch(binary_io_error const& error) {
+                throw binary_io_error(std::string(error.what()) + ": " + file_.filename());
+            }
+        }
+
+        ::bmp::size<std::size_t> frame_size() const noexcept {
+            return {w_, h_};
+        }
+
+        std::size_t frame_count() const noexcept {
+            return index_.size();
+        }
+
+        /// \brief Read frame k
+        ///
+        /// \throw std::out_of_range, binary_io_error
+        void read(bitmap<T>& frame, std::size_t const k) const {
+            if(k >= index_.size()) {
+                throw std::out_of_range(
+                    "frame " + std::to_string(k) + " out of range, stack has " + std::to_string(index_.size())
+                    + " frames");
+            }
+
+            auto const& entry = index_[k];
+            try {
+                frame.resize(w_, h_);
+                detail::binary_band_buffer buffer;
+                detail::decompress_band(
+                    frame, 0, h_, file_.data() + entry.offset, static_cast<std::size_t>(entry.size), swap_endian_,
+                    header_.codec, header_.filters, buffer);
+            } catch(binary_io_error const& error) {
+                throw binary_io_error(std::string(error.what()) + " in frame " + std::to_string(k) + ": " + file_.filename());
+            }
+        }
+
+        /// \brief Read frame k
+        ///
+        /// \throw std::out_of_range, binary_io_error
+        bitmap<T> read(std::size_t const k) const {
+            bitmap<T> frame;
+            read(frame, k);
+            return frame;
+        }
+
+        /// \brief Read all frames, threads frames are decoded in parallel, 0 means one per hardware thread
+        ///
+        /// \throw binary_io_error
+        bitmap_vector<T> read_all(std::size_t const threads = 1) const {
+            bitmap_vector<T> frames(index_.size());
+            detail::parallel_for(frames.size(), threads, [&](std::size_t const k) { read(frames[k], k); });
+            return frames;
+        }
+
+    private:
+        /// \brief Without index all frames must have the uncompressed size
+        void read_unclosed(std::size_t const frame_bytes) {
+            if(header_.codec != binary_codec::none) {
+                throw binary_io_error("compressed stack was not closed and has no index");
+            }
+
+            auto const count = frame_bytes == 0 ? 0 : (file_.size() - detail::binary_stack_header_size) / frame_bytes;
+            index_.resize(count);
+            for(std::size_t k = 0; k < count; ++k) {
+                index_[k] = {detail::binary_stack_header_size + k * frame_bytes, frame_bytes};
+            }
+        }
+
+        void read_index(std::size_t const frame_bytes) {
+            auto const index_offset = header_.index_offset;
+            if(index_offset < detail::binary_stack_header_size || index_offset > file_.size()
+               || header_.frame_count > (file_.size() - index_offset) / detail::binary_tile_entry_size) {
+                throw binary_io_error("can't read frame index");
+            }
+
+            index_ = detail::read_tile_index(file_.data() + index_offset, static_cast<std::size_t>(header_.frame_count));
+
+            auto const max_size = header_.codec == binary_codec::lz4 ? detail::lz4::compress_bound(frame_bytes) : frame_bytes;
+            for(auto const& entry: index_) {
+                if(entry.offset < detail::binary_stack_header_size || entry.offset > index_offset
+                   || entry.size > index_offset - entry.offset || entry.size > max_size) {
+                    throw binary_io_error("frame data out of range");
+                }
+            }
+        }
+
+        detail::mapped_file file_;
+        detail::binary_stack_header header_{};
+        std::size_t w_ = 0;
+        std::size_t h_ = 0;
+        std::vector<detail::binary_tile_entry> index_;
+        bool swap_endian_ = false;
+    };
+
+
+    /// \brief Write all frames into a stack file, all frames must have the same size
+    ///
+    /// \throw binary_io_error, std::logic_error if the frames have different sizes
+    template <typename T>
+    void binary_write_stack(
+        bitmap_vector<T> const& frames,
+        std::string const& filename,
+        binary_compression const& compression = {binary_codec::none, false},
+        std::endian const endianness = std::endian::native) {
+        auto const size = frames.empty() ? ::bmp::size<std::size_t>() : get_size(frames);
+        binary_stack_writer<T> writer(filename, size.w(), size.h(), compression, endianness);
+        for(auto const& frame: frames) {
+            writer.append(frame);
+        }
+        writer.close();
+    }
+
+    /// \brief Read all frames of a stack file
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    bitmap_vector<T> binary_read_stack(std::string const& filename, bool const ignore_signed = true, std::size_t const threads = 1) {
+        return binary_stack_reader<T>(filename, ignore_signed).read_all(threads);
+    }
+
+
+}
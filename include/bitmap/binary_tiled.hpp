@@ -0,0 +1,393 @@
+#pragma once
+
+#include "binary_compression.hpp"
+#include "binary_read.hpp"
+#include "binary_write.hpp"
+#include "bitmap.hpp"
+#include "exception.hpp"
+#include "pyramid.hpp"
+#include "rect.hpp"
+#include "size.hpp"
+#include "subbitmap.hpp"
+
+#include "detail/binary_tile_layout.hpp"
+#include "detail/parallel.hpp"
+#include "detail/positional_file.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Settings for writing the tiled binary format version 2
+    struct binary_tiling {
+        std::size_t tile_w = 256;
+        std::size_t tile_h = 256;
+
+        /// \brief Number of pyramid levels including the full resolution, each halves the size
+        std::size_t levels = 1;
+
+        /// \brief Compression of every tile, rows_per_band is not used, threads is used by
+        ///        binary_write_tiled
+        binary_compression compression{};
+    };
+
+
+    /// \brief Writes the tiled binary format version 2 tile by tile
+    ///
+    /// Tiles of all pyramid levels can be written in any order and from several threads at once.
+    /// Each tile is compressed independently and appended to the file, its position is recorded
+    /// in the tile index which close() writes behind the header. Tiles written twice keep the
+    /// last data, tiles never written read as default constructed values.
+    template <typename T>
+    class binary_tile_writer {
+    public:
+        /// \throw binary_io_error
+        binary_tile_writer(
+            std::string filename,
+            std::size_t const w,
+            std::size_t const h,
+            binary_tiling const& tiling = {},
+            std::endian const endianness = std::endian::native)
+            : file_(std::move(filename), detail::positional_file::mode::write)
+            , layout_(w, h, tiling.tile_w, tiling.tile_h, tiling.levels)
+            , compression_(tiling.compression)
+            , endianness_(endianness)
+            , index_(layout_.tile_count())
+            , next_offset_(layout_.data_offset()) {
+            std::ostringstream os;
+            detail::binary_write_header<T>(os, w, h, endianness, 0x02);
+            header_ = os.str();
+        }
+
+        binary_tile_writer(binary_tile_writer const&) = delete;
+        binary_tile_writer& operator=(binary_tile_writer const&) = delete;
+
+        /// \brief Calls close(), errors are ignored
+        ~binary_tile_writer() {
+            if(!closed_) {
+                try {
+                    close();
+                } catch(...) {
+                }
+            }
+        }
+
+        std::size_t levels() const noexcept {
+            return layout_.levels();
+        }
+
+        ::bmp::size<std::size_t> level_size(std::size_t const level) const {
+            return layout_.level_size(level);
+        }
+
+        ::bmp::size<std::size_t> tile_size() const noexcept {
+            return {layout_.tile_w(), layout_.tile_h()};
+        }
+
+        std::size_t tiles_x(std::size_t const level) const {
+            return layout_.tiles_x(level);
+        }
+
+        std::size_t tiles_y(std::size_t const level) const {
+            return layout_.tiles_y(level);
+        }
+
+        /// \brief Area of the tile in its level, tiles at the right and bottom border are smaller
+        rect<std::size_t> tile_rect(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            return layout_.tile_rect(level, tx, ty);
+        }
+
+        /// \brief Compress and write a tile, tile must have the size of tile_rect(level, tx, ty)
+        ///
+        /// Thread safe.
+        ///
+        /// \throw binary_io_error
+        void write_tile(std::size_t const level, std::size_t const tx, std::size_t const ty, bitmap<T> const& tile) {
+            auto const index = layout_.tile_index(level, tx, ty);
+            auto const area = layout_.tile_rect(level, tx, ty);
+            if(tile.w() != area.w() || tile.h() != area.h()) {
+                throw std::invalid_argument(
+                    "tile size " + std::to_string(tile.w()) + "x" + std::to_string(tile.h()) + " expected "
+                    + std::to_string(area.w()) + "x" + std::to_string(area.h()));
+            }
+
+            detail::binary_band_buffer buffer;
+            detail::compress_band(tile, 0, tile.h(), endianness_, compression_, buffer);
+            auto const size = buffer.compressed.size();
+
+            std::unique_lock lock(mutex_);
+            if(closed_) {
+                throw std::logic_error("binary_tile_writer is closed");
+            }
+            auto const offset = next_offset_;
+            next_offset_ += size;
+            lock.unlock();
+
+            file_.write(buffer.compressed.data(), size, offset);
+
+            lock.lock();
+            index_[index] = {offset, size};
+        }
+
+        /// \brief Write header and tile index and close the file, no tiles can be written afterwards
+        ///
+        /// \throw binary_io_error
+        void close() {
+            std::lock_guard lock(mutex_);
+            if(closed_) {
+                return;
+            }
+            closed_ = true;
+
+            std::vector<std::byte> data(layout_.data_offset());
+            std::memcpy(data.data(), header_.data(), header_.size());
+            detail::write_tiled_header(
+                data.data() + header_.size(),
+                {compression_.codec,
+                 detail::binary_prefilter_flags<T>(compression_),
+                 static_cast<std::uint32_t>(layout_.tile_w()),
+                 static_cast<std::uint32_t>(layout_.tile_h()),
+                 static_cast<std::uint32_t>(layout_.levels())});
+            detail::write_tile_index(data.data() + detail::binary_tile_index_offset, index_);
+
+            file_.write(data.data(), data.size(), 0);
+            file_.close();
+        }
+
+    private:
+        detail::positional_file file_;
+        detail::binary_tile_layout layout_;
+        binary_compression const compression_;
+        std::endian const endianness_;
+        std::string header_;
+
+        std::mutex mutex_;
+        std::vector<detail::binary_tile_entry> index_;
+        std::uint64_t next_offset_;
+        bool closed_ = false;
+    };
+
+
+    /// \brief Random access to tiles of the tiled binary format version 2
+    ///
+    /// The constructor reads header and tile index, afterwards every tile is read with a single
+    /// pread. All read functions are thread safe.
+    template <typename T>
+    class binary_tile_reader {
+    public:
+        /// \throw binary_io_error
+        explicit binary_tile_reader(std::string filename, bool const ignore_signed = true)
+            : file_(std::move(filename), detail::positional_file::mode::read) {
+            try {
+                auto const file_size = file_.size();
+
+                std::byte headers[detail::binary_tile_index_offset];
+                file_.read(headers, sizeof(headers), 0);
+
+                std::istringstream is(std::string(reinterpret_cast<char const*>(headers), 24));
+                auto const header = binary_read_header(is);
+                if(header.version != 0x02) {
+                    throw binary_io_error(
+                        "file format version is " + std::to_string(header.version) + ", expected tiled version 2");
+                }
+                swap_endian_ = detail::binary_check_format<T>(header, ignore_signed);
+
+                tiled_header_ = detail::read_tiled_header(headers + 24);
+                layout_ = detail::binary_tile_layout(
+                    static_cast<std::size_t>(header.w), static_cast<std::size_t>(header.h), tiled_header_.tile_w,
+                    tiled_header_.tile_h, tiled_header_.levels);
+
+                if(layout_.data_offset() > file_size) {
+                    throw binary_io_error("can't read tile index");
+                }
+
+                std::vector<std::byte> index_data(layout_.tile_count() * detail::binary_tile_entry_size);
+                file_.read(index_data.data(), index_data.size(), detail::binary_tile_index_offset);
+                index_ = detail::read_tile_index(index_data.data(), layout_.tile_count());
+
+                for(auto const& entry: index_) {
+                    if(entry.size != 0
+                       && (entry.offset < layout_.data_offset() || entry.offset > file_size
+                           || entry.size > file_size - entry.offset)) {
+                        throw binary_io_error("tile data out of range");
+                    }
+                }
+            } catch(binary_io_error const& error) {
+                throw binary_io_error(std::string(error.what()) + ": " + file_.filename());
+            }
+        }
+
+        std::size_t levels() const noexcept {
+            return layout_.levels();
+        }
+
+        ::bmp::size<std::size_t> level_size(std::size_t const level) const {
+            return layout_.level_size(level);
+        }
+
+        ::bmp::size<std::size_t> tile_size() const noexcept {
+            return {layout_.tile_w(), layout_.tile_h()};
+        }
+
+        std::size_t tiles_x(std::size_t const level) const {
+            return layout_.tiles_x(level);
+        }
+
+        std::size_t tiles_y(std::size_t const level) const {
+            return layout_.tiles_y(level);
+        }
+
+        /// \brief Area of the tile in its level, tiles at the right and bottom border are smaller
+        rect<std::size_t> tile_rect(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            return layout_.tile_rect(level, tx, ty);
+        }
+
+        /// \brief true if the tile was written
+        bool has_tile(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            return index_[layout_.tile_index(level, tx, ty)].size != 0;
+        }
+
+        /// \brief Read a single tile, missing tiles are default constructed values
+        ///
+        /// \throw binary_io_error
+        void read_tile(bitmap<T>& tile, std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            auto const& entry = index_[layout_.tile_index(level, tx, ty)];
+            auto const area = layout_.tile_rect(level, tx, ty);
+            if(entry.size == 0) {
+                tile = bitmap<T>(area.w(), area.h());
+                return;
+            }
+
+            try {
+                std::vector<std::byte> data;
+                detail::binary_band_buffer buffer;
+                detail::binary_decode_tile(
+                    tile,
+                    area,
+                    entry.size,
+                    [&](std::byte* const target, std::size_t const size) { file_.read(target, size, entry.offset); },
+                    swap_endian_,
+                    tiled_header_,
+                    data,
+                    buffer);
+            } catch(binary_io_error const& error) {
+                throw binary_io_error(std::string(error.what()) + ": " + file_.filename());
+            }
+        }
+
+        /// \brief Read a single tile, missing tiles are default constructed values
+        ///
+        /// \throw binary_io_error
+        bitmap<T> read_tile(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            bitmap<T> tile;
+            read_tile(tile, level, tx, ty);
+            return tile;
+        }
+
+        /// \brief Read area of level, only the tiles overlapping area are read
+        ///
+        /// threads tiles are read in parallel, 0 means one per hardware thread.
+        ///
+        /// \throw binary_io_error
+        bitmap<T> read(std::size_t const level, rect<std::size_t> const& area, std::size_t threads = 1) const {
+            auto const level_size = layout_.level_size(level);
+            if(area.x() + area.w() > level_size.w() || area.y() + area.h() > level_size.h()) {
+                throw std::out_of_range(detail::out_of_range_msg(level_size, area.pos(), area.size()));
+            }
+
+            bitmap<T> result(area.w(), area.h());
+            if(area.w() == 0 || area.h() == 0) {
+                return result;
+            }
+
+            auto const tx_begin = area.x() / layout_.tile_w();
+            auto const ty_begin = area.y() / layout_.tile_h();
+            auto const tx_count = (area.x() + area.w() - 1) / layout_.tile_w() + 1 - tx_begin;
+            auto const ty_count = (area.y() + area.h() - 1) / layout_.tile_h() + 1 - ty_begin;
+
+            if constexpr(std::is_same_v<T, bool>) {
+                // neighboring tiles share std::vector<bool> words
+                threads = 1;
+            }
+
+            detail::parallel_for(tx_count * ty_count, threads, [&](std::size_t const i) {
+                auto const tx = tx_begin + i % tx_count;
+                auto const ty = ty_begin + i / tx_count;
+                auto const tile_area = layout_.tile_rect(level, tx, ty);
+                auto const tile = read_tile(level, tx, ty);
+
+                auto const x_begin = std::max(tile_area.x(), area.x());
+                auto const y_begin = std::max(tile_area.y(), area.y());
+                auto const x_end = std::min(tile_area.x() + tile_area.w(), area.x() + area.w());
+                auto const y_end = std::min(tile_area.y() + tile_area.h(), area.y() + area.h());
+                detail::copy(
+                    result, tile,
+                    rect<std::size_t>(x_begin - tile_area.x(), y_begin - tile_area.y(), x_end - x_begin, y_end - y_begin),
+                    point<std::size_t>(x_begin - area.x(), y_begin - area.y()));
+            });
+
+            return result;
+        }
+
+        /// \brief Read a whole level
+        ///
+        /// \throw binary_io_error
+        bitmap<T> read(std::size_t const level = 0, std::size_t const threads = 1) const {
+            return read(level, rect<std::size_t>(layout_.level_size(level)), threads);
+        }
+
+    private:
+        detail::positional_file file_;
+        detail::binary_tile_layout layout_;
+        detail::binary_tiled_header tiled_header_{};
+        std::vector<detail::binary_tile_entry> index_;
+        bool swap_endian_ = false;
+    };
+
+
+    /// \brief Write bitmap in the tiled format version 2 with tiling.levels pyramid levels
+    ///
+    /// Every level is downsample_half of the previous one with the box filter, the same as the
+    /// levels of a pyramid. Levels and tiles are computed on tiling.compression.threads threads.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write_tiled(
+        bitmap<T> const& image,
+        std::string const& filename,
+        binary_tiling const& tiling = {},
+        std::endian const endianness = std::endian::native) {
+        binary_tile_writer<T> writer(filename, image.w(), image.h(), tiling, endianness);
+
+        bitmap<T> scaled;
+        for(std::size_t level = 0; level < writer.levels(); ++level) {
+            if(level > 0) {
+                scaled = downsample_half(level == 1 ? image : scaled, pyramid_filter::box, tiling.compression.threads);
+            }
+            auto const& level_image = level == 0 ? image : scaled;
+
+            auto const tiles_x = writer.tiles_x(level);
+            detail::parallel_for(tiles_x * writer.tiles_y(level), tiling.compression.threads, [&](std::size_t const i) {
+                auto const area = writer.tile_rect(level, i % tiles_x, i / tiles_x);
+                bitmap<T> tile(area.w(), area.h());
+                detail::copy(tile, level_image, area);
+                writer.write_tile(level, i % tiles_x, i / tiles_x, tile);
+            });
+        }
+
+        writer.close();
+    }
+
+
+}
@@ -1,102 +1,231 @@
 #pragma once
 
+#include "binary_checksum.hpp"
+#include "binary_compression.hpp"
 #include "bitmap.hpp"
 #include "exception.hpp"
+#include "masked_bitmap.hpp"
 
 #include "detail/binary_io_flags.hpp"
 #include "detail/valid_binary_format.hpp"
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cstdint>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 
 namespace bmp {
 
 
+    namespace detail {
+
+
+        /// \brief Write the binary bitmap format header of the given version
+        ///
+        /// \throw binary_io_error
+        template <typename T>
+        void binary_write_header(
+            std::ostream& os,
+            std::size_t const w,
+            std::size_t const h,
+            std::endian const endianness,
+            std::uint8_t const version,
+            bool const masked = false) {
+            static_assert(
+                detail::is_valid_binary_format_v<T>,
+                "Your value_type is not supported by bmp::binary_write");
+
+            using pixel::channel_count_v;
+            using value_type = pixel::channel_type_t<T>;
+
+            static_assert(sizeof(value_type) <= 256);
+            static_assert(sizeof(T) == sizeof(value_type) * channel_count_v<T>);
+            if constexpr(!detail::endian_supported<value_type>) {
+                if(endianness != std::endian::native) {
+                    throw std::runtime_error("endian conversion is not supported for requested type");
+                }
+            }
+
+            // header informations
+            std::uint8_t const size_in_byte = sizeof(value_type);
+            std::uint8_t const channel_count = channel_count_v<T>;
+            auto const endian_flag = [endianness] {
+                switch(endianness) {
+                case std::endian::little:
+                    return detail::binary_endian_flags::is_little_endian;
+                case std::endian::big:
+                    return detail::binary_endian_flags::is_big_endian;
+                default:
+                    throw std::logic_error(
+                        "unknown std::endian: " + std::to_string(std::uint32_t(endianness)));
+                }
+            }();
+            std::uint8_t const flags = [endian_flag, masked]() -> std::uint8_t {
+                return (detail::binary_io_flags_v<value_type> & 0x0F) | std::uint8_t(endian_flag)
+                    | (masked ? detail::binary_masked_flag : 0);
+            }();
+
+            std::uint64_t const w_bytes = detail::byteswap_on_little_endian(std::uint64_t(w));
+            std::uint64_t const h_bytes = detail::byteswap_on_little_endian(std::uint64_t(h));
+
+            // write the file header
+            os.write(reinterpret_cast<char const*>(&detail::big_endian_io_magic), 4);
+            os.write(reinterpret_cast<char const*>(&version), 1);
+            os.write(reinterpret_cast<char const*>(&size_in_byte), 1);
+            os.write(reinterpret_cast<char const*>(&channel_count), 1);
+            os.write(reinterpret_cast<char const*>(&flags), 1);
+            os.write(reinterpret_cast<char const*>(&w_bytes), 8);
+            os.write(reinterpret_cast<char const*>(&h_bytes), 8);
+
+            if(!os.good()) {
+                throw binary_io_error("can't write binary bitmap format header");
+            }
+        }
+
+        /// \brief Write the uncompressed pixel data of version 0
+        template <typename T>
+        void binary_write_payload(bitmap<T> const& bitmap, std::ostream& os, std::endian const endianness) {
+            using pixel::channel_count_v;
+            using value_type = pixel::channel_type_t<T>;
+
+            if constexpr(std::is_same_v<T, bool>) {
+                uint8_t data = 0;
+                std::size_t i = 0;
+                for(bool v: bitmap) {
+                    data <<= 1;
+                    data |= v ? 1 : 0;
+                    if(++i % 8 == 0) {
+                        os.write(reinterpret_cast<char const*>(&data), 1);
+                        data = 0;
+                    }
+                }
+                if(i % 8 != 0) {
+                    data <<= (8 - (i % 8));
+                    os.write(reinterpret_cast<char const*>(&data), 1);
+                }
+            } else if(endianness == std::endian::native) {
+                os.write(reinterpret_cast<char const*>(bitmap.data()), bitmap.point_count() * sizeof(T));
+            } else {
+                for(auto const v: bitmap) {
+                    std::array<detail::integer_type<value_type>, channel_count_v<T>> buffer;
+                    for(std::size_t i = 0; i < buffer.size(); ++i) {
+                        buffer[i] = detail::byteswap_to_integer(*(reinterpret_cast<value_type const*>(&v) + i));
+                    }
+                    os.write(reinterpret_cast<char const*>(buffer.data()), sizeof(T));
+                }
+            }
+        }
+
+
+        /// \brief Write the mask plane of a masked bitmap
+        ///
+        /// Every row is padded to whole 64 bit words, bit x of a row is bit x % 8 of byte x / 8.
+        /// On little endian machines this is the memory layout of bitmask, so it is written at once.
+        inline void binary_write_mask(bitmask const& mask, std::ostream& os) {
+            auto const word_count = mask.words_per_row() * mask.h();
+            if constexpr(std::endian::native == std::endian::little) {
+                os.write(reinterpret_cast<char const*>(mask.data()), word_count * sizeof(bitmask::word_type));
+            } else {
+                std::vector<bitmask::word_type> buffer(mask.data(), mask.data() + word_count);
+                for(auto& word: buffer) {
+                    word = std::byteswap(word);
+                }
+                os.write(reinterpret_cast<char const*>(buffer.data()), word_count * sizeof(bitmask::word_type));
+            }
+        }
+
+
+    }
+
+
     /// \brief Write bitmap to std::ostream
     ///
     /// \throw binary_io_error
     template <typename T>
     void binary_write(bitmap<T> const& bitmap, std::ostream& os, std::endian endianness = std::endian::native) {
-        static_assert(
-            detail::is_valid_binary_format_v<T>,
-            "Your value_type is not supported by bmp::binary_write");
-
-        using pixel::channel_count_v;
-        using value_type = pixel::channel_type_t<T>;
-
-        static_assert(sizeof(value_type) <= 256);
-        static_assert(sizeof(T) == sizeof(value_type) * channel_count_v<T>);
-        if constexpr(!detail::endian_supported<value_type>) {
-            if(endianness != std::endian::native) {
-                throw std::runtime_error("endian conversion is not supported for requested type");
-            }
+        detail::binary_write_header<T>(os, bitmap.w(), bitmap.h(), endianness, 0x00);
+        detail::binary_write_payload(bitmap, os, endianness);
+
+        if(!os.good()) {
+            throw binary_io_error("can't write binary bitmap format data");
+        }
+    }
+
+
+    /// \brief Write bitmap in the compressed format version 1 to std::ostream
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        bitmap<T> const& bitmap,
+        std::ostream& os,
+        binary_compression const& compression,
+        std::endian endianness = std::endian::native) {
+        detail::binary_write_header<T>(os, bitmap.w(), bitmap.h(), endianness, 0x01);
+        detail::binary_write_compressed_data(bitmap, os, endianness, compression);
+
+        if(!os.good()) {
+            throw binary_io_error("can't write binary bitmap format data");
         }
+    }
 
-        // header informations
-        std::uint8_t const version = 0x00;
-        std::uint8_t const size_in_byte = sizeof(value_type);
-        std::uint8_t const channel_count = channel_count_v<T>;
-        auto const endian_flag = [endianness] {
-            switch(endianness) {
-            case std::endian::little:
-                return detail::binary_endian_flags::is_little_endian;
-            case std::endian::big:
-                return detail::binary_endian_flags::is_big_endian;
-            default:
-                throw std::logic_error(
-                    "unknown std::endian: " + std::to_string(std::uint32_t(endianness)));
-            }
-        }();
-        std::uint8_t const flags = [endian_flag]() -> std::uint8_t {
-            return (detail::binary_io_flags_v<value_type> & 0x0F) | std::uint8_t(endian_flag);
-        }();
-
-        std::uint64_t const w_bytes = detail::byteswap_on_little_endian(bitmap.w());
-        std::uint64_t const h_bytes = detail::byteswap_on_little_endian(bitmap.h());
-
-        // write the file header
-        os.write(reinterpret_cast<char const*>(&detail::big_endian_io_magic), 4);
-        os.write(reinterpret_cast<char const*>(&version), 1);
-        os.write(reinterpret_cast<char const*>(&size_in_byte), 1);
-        os.write(reinterpret_cast<char const*>(&channel_count), 1);
-        os.write(reinterpret_cast<char const*>(&flags), 1);
-        os.write(reinterpret_cast<char const*>(&w_bytes), 8);
-        os.write(reinterpret_cast<char const*>(&h_bytes), 8);
 
+    /// \brief Write bitmap in the checksummed format version 3 to std::ostream
+    ///
+    /// The CRC32C of every chunk is computed while writing it.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        bitmap<T> const& bitmap,
+        std::ostream& os,
+        binary_checksum const& checksum,
+        std::endian endianness = std::endian::native) {
+        if(checksum.chunk_size == 0 || checksum.chunk_size > detail::binary_max_chunk_size) {
+            throw std::invalid_argument("invalid checksum chunk size " + std::to_string(checksum.chunk_size));
+        }
+
+        // the header checksum covers the common header and the chunk size
+        std::ostringstream header_os;
+        detail::binary_write_header<T>(header_os, bitmap.w(), bitmap.h(), endianness, 0x03);
+        auto header = header_os.str();
+        auto const chunk_size = detail::byteswap_on_little_endian(static_cast<std::uint32_t>(checksum.chunk_size));
+        header.append(reinterpret_cast<char const*>(&chunk_size), 4);
+        auto const header_crc = detail::byteswap_on_little_endian(detail::crc32c(0, header.data(), header.size()));
+        header.append(reinterpret_cast<char const*>(&header_crc), 4);
+
+        os.write(header.data(), static_cast<std::streamsize>(header.size()));
         if(!os.good()) {
             throw binary_io_error("can't write binary bitmap format header");
         }
 
-        if constexpr(std::is_same_v<T, bool>) {
-            uint8_t data = 0;
-            std::size_t i = 0;
-            for(bool v: bitmap) {
-                data <<= 1;
-                data |= v ? 1 : 0;
-                if(++i % 8 == 0) {
-                    os.write(reinterpret_cast<char const*>(&data), 1);
-                    data = 0;
-                }
-            }
-            if(i % 8 != 0) {
-                data <<= (8 - (i % 8));
-                os.write(reinterpret_cast<char const*>(&data), 1);
-            }
-        } else if(endianness == std::endian::native) {
-            os.write(reinterpret_cast<char const*>(bitmap.data()), bitmap.point_count() * sizeof(T));
-        } else {
-            for(auto const v: bitmap) {
-                std::array<detail::integer_type<value_type>, channel_count_v<T>> buffer;
-                for(std::size_t i = 0; i < buffer.size(); ++i) {
-                    buffer[i] = detail::byteswap_to_integer(*(reinterpret_cast<value_type const*>(&v) + i));
-                }
-                os.write(reinterpret_cast<char const*>(buffer.data()), sizeof(T));
-            }
+        detail::crc32c_ostreambuf buffer(os.rdbuf(), checksum.chunk_size);
+        std::ostream checked(&buffer);
+        detail::binary_write_payload(bitmap, checked, endianness);
+
+        if(!checked.good() || !buffer.finish()) {
+            throw binary_io_error("can't write binary bitmap format data");
         }
+    }
+
+
+    /// \brief Write masked bitmap to std::ostream
+    ///
+    /// The values are written as in version 0 with the masked flag, the bit packed mask plane
+    /// follows them.
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(masked_bitmap<T> const& bitmap, std::ostream& os, std::endian endianness = std::endian::native) {
+        detail::binary_write_header<T>(os, bitmap.w(), bitmap.h(), endianness, 0x00, true);
+        detail::binary_write_payload(bitmap.values(), os, endianness);
+        detail::binary_write_mask(bitmap.mask(), os);
 
         if(!os.good()) {
             throw binary_io_error("can't write binary bitmap format data");
@@ -104,6 +233,18 @@ namespace bmp {
     }
 
 
+    /// \brief Write bitmap of masked pixels as masked bitmap to std::ostream
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        bitmap<pixel::basic_masked_pixel<T>> const& bitmap,
+        std::ostream& os,
+        std::endian endianness = std::endian::native) {
+        binary_write(separate_mask(bitmap), os, endianness);
+    }
+
+
     /// \brief Write bitmap to disk by a given filename
     ///
     /// \throw binary_io_error
@@ -126,4 +267,72 @@ namespace bmp {
     }
 
 
+    /// \brief Write bitmap in the compressed format version 1 to disk by a given filename
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        bitmap<T> const& bitmap,
+        std::string const& filename,
+        binary_compression const& compression,
+        std::endian endianness = std::endian::native) {
+        std::ofstream os(filename.c_str(), std::ios_base::binary);
+
+        if(!os.is_open()) {
+            throw binary_io_error("can't open file: " + filename);
+        }
+
+        try {
+            binary_write(bitmap, os, compression, endianness);
+        } catch(binary_io_error const& e) {
+            throw binary_io_error(std::string(e.what()) + ": " + filename);
+        }
+    }
+
+
+    /// \brief Write bitmap in the checksummed format version 3 to disk by a given filename
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        bitmap<T> const& bitmap,
+        std::string const& filename,
+        binary_checksum const& checksum,
+        std::endian endianness = std::endian::native) {
+        std::ofstream os(filename.c_str(), std::ios_base::binary);
+
+        if(!os.is_open()) {
+            throw binary_io_error("can't open file: " + filename);
+        }
+
+        try {
+            binary_write(bitmap, os, checksum, endianness);
+        } catch(binary_io_error const& e) {
+            throw binary_io_error(std::string(e.what()) + ": " + filename);
+        }
+    }
+
+
+    /// \brief Write masked bitmap to disk by a given filename
+    ///
+    /// \throw binary_io_error
+    template <typename T>
+    void binary_write(
+        masked_bitmap<T> const& bitmap,
+        std::string const& filename,
+        std::endian endianness = std::endian::native) {
+        std::ofstream os(filename.c_str(), std::ios_base::binary);
+
+        if(!os.is_open()) {
+            throw binary_io_error("can't open file: " + filename);
+        }
+
+        try {
+            binary_write(bitmap, os, endianness);
+        } catch(binary_io_error const& e) {
+            throw binary_io_error(std::string(e.what()) + ": " + filename);
+        }
+    }
+
+
 }
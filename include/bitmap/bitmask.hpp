@@ -0,0 +1,230 @@
+#pragma once
+
+#include "bitmap.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief A bitmap of bools that stores one bit per point
+    ///
+    /// Every row starts at a word boundary, so rows can be processed independently. Bit x % 64
+    /// of word x / 64 in a row belongs to point x. Bits behind the width are always zero, so
+    /// whole words can be compared and counted.
+    class bitmask {
+    public:
+        /// \brief Type of a storage word
+        using word_type = std::uint64_t;
+
+        /// \brief Type of bitmap size
+        using size_type = ::bmp::size<std::size_t>;
+
+        /// \brief Number of bits in a word
+        static constexpr std::size_t word_bits = 64;
+
+
+        /// \brief Constructs a blank mask
+        bitmask() = default;
+
+        /// \brief Constructs a mask with size, initialize all bits with value
+        bitmask(size_type const& size, bool const value = false) {
+            resize(size, value);
+        }
+
+        /// \brief Constructs a mask with size w and h, initialize all bits with value
+        bitmask(std::size_t const w, std::size_t const h, bool const value = false)
+            : bitmask(size_type(w, h), value) {}
+
+        /// \brief Constructs a mask from a bitmap of bools
+        explicit bitmask(bitmap<bool> const& image)
+            : bitmask(image.size()) {
+            for(std::size_t y = 0; y < h(); ++y) {
+                auto const out = row(y);
+                for(std::size_t x = 0; x < w(); ++x) {
+                    out[x / word_bits] |= word_type(image(x, y)) << (x % word_bits);
+                }
+            }
+        }
+
+
+        /// \brief Resize the mask, initialize all bits with value
+        /// \attention All pointers to the data become invalid
+        void resize(size_type const& size, bool const value = false) {
+            size_ = size;
+            words_per_row_ = (size.w() + word_bits - 1) / word_bits;
+            words_.assign(words_per_row_ * size.h(), 0);
+            fill(value);
+        }
+
+        /// \brief Resize the mask, initialize all bits with value
+        /// \attention All pointers to the data become invalid
+        void resize(std::size_t const w, std::size_t const h, bool const value = false) {
+            resize(size_type(w, h), value);
+        }
+
+        /// \brief Resize to zero
+        void clear() noexcept {
+            size_ = size_type();
+            words_per_row_ = 0;
+            words_.clear();
+        }
+
+
+        /// \brief Get the width
+        std::size_t w() const noexcept {
+            return size_.w();
+        }
+
+        /// \brief Get the height
+        std::size_t h() const noexcept {
+            return size_.h();
+        }
+
+        /// \brief Get the size
+        size_type const size() const noexcept {
+            return size_;
+        }
+
+        /// \brief Get the number of points in the mask
+        std::size_t point_count() const noexcept {
+            return size_.area();
+        }
+
+        /// \brief true if mask is empty, false otherwise
+        bool empty() const noexcept {
+            return point_count() == 0;
+        }
+
+        /// \brief Number of words in every row
+        std::size_t words_per_row() const noexcept {
+            return words_per_row_;
+        }
+
+
+        /// \brief Get the bit by local coordinates
+        bool operator()(std::size_t const x, std::size_t const y) const noexcept {
+            return (row(y)[x / word_bits] >> (x % word_bits)) & 1;
+        }
+
+        /// \brief Set the bit by local coordinates
+        void set(std::size_t const x, std::size_t const y, bool const value) noexcept {
+            auto& word = row(y)[x / word_bits];
+            auto const bit = word_type(1) << (x % word_bits);
+            word = value ? word | bit : word & ~bit;
+        }
+
+        /// \brief Set all bits to value
+        void fill(bool const value) noexcept {
+            if(!value) {
+                std::fill(words_.begin(), words_.end(), word_type(0));
+                return;
+            }
+
+            std::fill(words_.begin(), words_.end(), ~word_type(0));
+            auto const tail = w() % word_bits;
+            if(tail != 0) {
+                auto const last = (word_type(1) << tail) - 1;
+                for(std::size_t y = 0; y < h(); ++y) {
+                    row(y)[words_per_row_ - 1] = last;
+                }
+            }
+        }
+
+        /// \brief Number of set bits
+        std::size_t count() const noexcept {
+            std::size_t result = 0;
+            for(auto const word: words_) {
+                result += static_cast<std::size_t>(std::popcount(word));
+            }
+            return result;
+        }
+
+
+        /// \brief Get the first word of row y
+        word_type* row(std::size_t const y) noexcept {
+            return words_.data() + y * words_per_row_;
+        }
+
+        /// \brief Get the first word of row y
+        word_type const* row(std::size_t const y) const noexcept {
+            return words_.data() + y * words_per_row_;
+        }
+
+        /// \brief Get all words, row by row
+        word_type* data() noexcept {
+            return words_.data();
+        }
+
+        /// \brief Get all words, row by row
+        word_type const* data() const noexcept {
+            return words_.data();
+        }
+
+        [[nodiscard]] bool operator==(bitmask const&) const = default;
+
+    private:
+        size_type size_;
+        std::size_t words_per_row_ = 0;
+        std::vector<word_type> words_;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Call fn(begin, end) for every run [begin, end) of set bits in row y
+        ///
+        /// Words without a change are skipped at once, so long runs and gaps are cheap.
+        template <typename Fn>
+        void for_each_run(bitmask const& mask, std::size_t const y, Fn&& fn) {
+            auto const row = mask.row(y);
+            auto const w = mask.w();
+            std::size_t x = 0;
+            // move x to the first bit >= x that is value, or to w
+            auto const next = [&](bool const value) {
+                while(x < w) {
+                    auto const index = x / bitmask::word_bits;
+                    auto const word = (value ? row[index] : ~row[index]) >> (x % bitmask::word_bits);
+                    if(word != 0) {
+                        x = std::min(w, x + static_cast<std::size_t>(std::countr_zero(word)));
+                        return;
+                    }
+                    x = (index + 1) * bitmask::word_bits;
+                }
+                x = w;
+            };
+            for(;;) {
+                next(true);
+                if(x >= w) {
+                    return;
+                }
+                auto const begin = x;
+                next(false);
+                fn(begin, x);
+            }
+        }
+
+
+    }
+
+
+    /// \brief Unpack a mask into a bitmap of bools
+    inline bitmap<bool> to_bitmap(bitmask const& mask) {
+        bitmap<bool> result(mask.size());
+        for(std::size_t y = 0; y < mask.h(); ++y) {
+            auto const in = mask.row(y);
+            for(std::size_t x = 0; x < mask.w(); ++x) {
+                result(x, y) = (in[x / bitmask::word_bits] >> (x % bitmask::word_bits)) & 1;
+            }
+        }
+        return result;
+    }
+
+
+}
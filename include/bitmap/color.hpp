@@ -0,0 +1,304 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "convert.hpp"
+#include "pixel.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+
+namespace bmp {
+
+
+    /// \brief Weights of red, green and blue in a gray value, they should sum up to 1
+    struct gray_weights {
+        double r;
+        double g;
+        double b;
+    };
+
+    /// \brief Luma weights of ITU-R BT.601
+    inline constexpr gray_weights bt601_weights{0.299, 0.587, 0.114};
+
+    /// \brief Luma weights of ITU-R BT.709
+    inline constexpr gray_weights bt709_weights{0.2126, 0.7152, 0.0722};
+
+
+    /// \brief Color filter array layout, named by the colors of the top left 2x2 pixels
+    enum class bayer_pattern : std::uint8_t { rggb, bggr, grbg, gbrg };
+
+
+    namespace detail {
+
+
+        /// \brief Round and clamp value to T, values of floating point T are just cast
+        template <typename T, typename Compute>
+        T color_round(Compute value) noexcept {
+            if constexpr(std::is_floating_point_v<T>) {
+                return static_cast<T>(value);
+            } else {
+                auto const min = static_cast<Compute>(std::numeric_limits<T>::min());
+                auto const max = convert_max<T, Compute>();
+                value += value >= 0 ? Compute(0.5) : Compute(-0.5);
+                value = value >= min ? value : min;
+                value = value <= max ? value : max;
+                return static_cast<T>(value);
+            }
+        }
+
+        template <typename T>
+        T weighted_gray(T const r, T const g, T const b, gray_weights const& weights) noexcept {
+            using compute = convert_compute_type<T, T>;
+            return color_round<T>(
+                static_cast<compute>(r) * static_cast<compute>(weights.r)
+                + static_cast<compute>(g) * static_cast<compute>(weights.g)
+                + static_cast<compute>(b) * static_cast<compute>(weights.b));
+        }
+
+        /// \brief Apply fn to every pixel, a simple loop the compiler can vectorize
+        template <typename R, typename T, typename Fn>
+        bitmap<R> color_map(bitmap<T> const& image, Fn const& fn) {
+            bitmap<R> result(image.size());
+            auto const in = image.data();
+            auto const out = result.data();
+            for(std::size_t i = 0; i < image.point_count(); ++i) {
+                out[i] = fn(in[i]);
+            }
+            return result;
+        }
+
+        template <typename T>
+        concept gray_value = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+
+    }
+
+
+    /// \brief Gray image of the weighted color channels
+    template <typename T>
+    bitmap<T> to_gray(bitmap<pixel::basic_rgb<T>> const& image, gray_weights const& weights = bt601_weights) {
+        return detail::color_map<T>(
+            image, [weights](auto const& v) { return detail::weighted_gray(v.r, v.g, v.b, weights); });
+    }
+
+    /// \brief Gray image of the weighted color channels, alpha is ignored
+    template <typename T>
+    bitmap<T> to_gray(bitmap<pixel::basic_rgba<T>> const& image, gray_weights const& weights = bt601_weights) {
+        return detail::color_map<T>(
+            image, [weights](auto const& v) { return detail::weighted_gray(v.r, v.g, v.b, weights); });
+    }
+
+    /// \brief Gray channel, alpha is ignored
+    template <typename T>
+    bitmap<T> to_gray(bitmap<pixel::basic_ga<T>> const& image) {
+        return detail::color_map<T>(image, [](auto const& v) { return v.g; });
+    }
+
+
+    /// \brief Gray value in all color channels
+    template <detail::gray_value T>
+    bitmap<pixel::basic_rgb<T>> to_rgb(bitmap<T> const& image) {
+        return detail::color_map<pixel::basic_rgb<T>>(image, [](T const v) { return pixel::basic_rgb<T>{v, v, v}; });
+    }
+
+    /// \brief Gray value in all color channels, alpha is ignored
+    template <typename T>
+    bitmap<pixel::basic_rgb<T>> to_rgb(bitmap<pixel::basic_ga<T>> const& image) {
+        return detail::color_map<pixel::basic_rgb<T>>(
+            image, [](auto const& v) { return pixel::basic_rgb<T>{v.g, v.g, v.g}; });
+    }
+
+    /// \brief Drop alpha
+    template <typename T>
+    bitmap<pixel::basic_rgb<T>> to_rgb(bitmap<pixel::basic_rgba<T>> const& image) {
+        return detail::color_map<pixel::basic_rgb<T>>(
+            image, [](auto const& v) { return pixel::basic_rgb<T>{v.r, v.g, v.b}; });
+    }
+
+
+    /// \brief Gray value in all color channels with constant alpha
+    template <detail::gray_value T>
+    bitmap<pixel::basic_rgba<T>> to_rgba(bitmap<T> const& image, T const alpha) {
+        return detail::color_map<pixel::basic_rgba<T>>(
+            image, [alpha](T const v) { return pixel::basic_rgba<T>{v, v, v, alpha}; });
+    }
+
+    /// \brief Gray value in all color channels, alpha is kept
+    template <typename T>
+    bitmap<pixel::basic_rgba<T>> to_rgba(bitmap<pixel::basic_ga<T>> const& image) {
+        return detail::color_map<pixel::basic_rgba<T>>(
+            image, [](auto const& v) { return pixel::basic_rgba<T>{v.g, v.g, v.g, v.a}; });
+    }
+
+    /// \brief Add constant alpha
+    template <typename T>
+    bitmap<pixel::basic_rgba<T>> to_rgba(bitmap<pixel::basic_rgb<T>> const& image, T const alpha) {
+        return detail::color_map<pixel::basic_rgba<T>>(
+            image, [alpha](auto const& v) { return pixel::basic_rgba<T>{v.r, v.g, v.b, alpha}; });
+    }
+
+
+    /// \brief Gray value with constant alpha
+    template <detail::gray_value T>
+    bitmap<pixel::basic_ga<T>> to_ga(bitmap<T> const& image, T const alpha) {
+        return detail::color_map<pixel::basic_ga<T>>(image, [alpha](T const v) { return pixel::basic_ga<T>{v, alpha}; });
+    }
+
+    /// \brief Gray image of the weighted color channels, alpha is kept
+    template <typename T>
+    bitmap<pixel::basic_ga<T>> to_ga(bitmap<pixel::basic_rgba<T>> const& image, gray_weights const& weights = bt601_weights) {
+        return detail::color_map<pixel::basic_ga<T>>(image, [weights](auto const& v) {
+            return pixel::basic_ga<T>{detail::weighted_gray(v.r, v.g, v.b, weights), v.a};
+        });
+    }
+
+
+    namespace detail {
+
+
+        /// \brief Channel index of red, green and blue in basic_rgb
+        enum bayer_color : std::size_t { bayer_red = 0, bayer_green = 1, bayer_blue = 2 };
+
+        template <typename T>
+        T bayer_average(T const a, T const b) noexcept {
+            if constexpr(std::is_floating_point_v<T>) {
+                return (a + b) / 2;
+            } else {
+                return static_cast<T>((std::int64_t(a) + b + 1) >> 1);
+            }
+        }
+
+        template <typename T>
+        T bayer_average(T const a, T const b, T const c, T const d) noexcept {
+            if constexpr(std::is_floating_point_v<T>) {
+                return (a + b + c + d) / 4;
+            } else {
+                return static_cast<T>((std::int64_t(a) + b + c + d + 2) >> 2);
+            }
+        }
+
+        /// \brief Bilinear interpolation of the missing colors at column x of color Color
+        template <std::size_t Color, typename T>
+        void demosaic_pixel(
+            T const* const up,
+            T const* const row,
+            T const* const down,
+            std::size_t const xm,
+            std::size_t const x,
+            std::size_t const xp,
+            bool const red_row,
+            pixel::basic_rgb<T>& out) noexcept {
+            if constexpr(Color == bayer_green) {
+                auto const horizontal = bayer_average(row[xm], row[xp]);
+                auto const vertical = bayer_average(up[x], down[x]);
+                out = red_row ? pixel::basic_rgb<T>{horizontal, row[x], vertical}
+                              : pixel::basic_rgb<T>{vertical, row[x], horizontal};
+            } else {
+                auto const green = bayer_average(row[xm], row[xp], up[x], down[x]);
+                auto const diagonal = bayer_average(up[xm], up[xp], down[xm], down[xp]);
+                out = Color == bayer_red ? pixel::basic_rgb<T>{row[x], green, diagonal}
+                                         : pixel::basic_rgb<T>{diagonal, green, row[x]};
+            }
+        }
+
+        /// \brief Demosaic a row with color Even at even and Odd at odd columns
+        ///
+        /// Columns -1 and w are mirrored to 1 and w - 2, so they have the right color.
+        template <std::size_t Even, std::size_t Odd, typename T>
+        void demosaic_row(
+            T const* const up,
+            T const* const row,
+            T const* const down,
+            pixel::basic_rgb<T>* const out,
+            std::size_t const w) noexcept {
+            constexpr bool red_row = Even == bayer_red || Odd == bayer_red;
+
+            demosaic_pixel<Even>(up, row, down, 1, 0, 1, red_row, out[0]);
+            std::size_t x = 1;
+            for(; x + 2 < w; x += 2) {
+                demosaic_pixel<Odd>(up, row, down, x - 1, x, x + 1, red_row, out[x]);
+                demosaic_pixel<Even>(up, row, down, x, x + 1, x + 2, red_row, out[x + 1]);
+            }
+            for(; x < w; ++x) {
+                auto const xp = x + 1 < w ? x + 1 : w - 2;
+                if(x % 2 == 0) {
+                    demosaic_pixel<Even>(up, row, down, x - 1, x, xp, red_row, out[x]);
+                } else {
+                    demosaic_pixel<Odd>(up, row, down, x - 1, x, xp, red_row, out[x]);
+                }
+            }
+        }
+
+        /// \brief Colors of the even and odd columns in even (index 0) and odd (index 1) rows
+        constexpr std::size_t bayer_colors[4][2][2] = {
+            {{bayer_red, bayer_green}, {bayer_green, bayer_blue}},
+            {{bayer_blue, bayer_green}, {bayer_green, bayer_red}},
+            {{bayer_green, bayer_red}, {bayer_blue, bayer_green}},
+            {{bayer_green, bayer_blue}, {bayer_red, bayer_green}}};
+
+        /// \brief Rows per band of demosaic, all three input rows of a band stay in cache
+        constexpr std::size_t demosaic_band_rows = 64;
+
+
+    }
+
+
+    /// \brief Bilinear demosaicing of a raw color filter array image
+    ///
+    /// Mirrors the image at the borders. Bands of rows are processed on threads threads, 0 means
+    /// one per hardware thread.
+    ///
+    /// \throw std::invalid_argument if the image is not empty but smaller than 2x2
+    template <typename T>
+    bitmap<pixel::basic_rgb<T>> demosaic(bitmap<T> const& raw, bayer_pattern const pattern, std::size_t const threads = 1) {
+        static_assert(
+            std::is_floating_point_v<T> || (std::is_integral_v<T> && sizeof(T) <= 4 && !std::is_same_v<T, bool>),
+            "demosaic needs a floating point or up to 32 bit integer type");
+
+        bitmap<pixel::basic_rgb<T>> result(raw.size());
+        if(raw.empty()) {
+            return result;
+        }
+
+        auto const w = raw.w();
+        auto const h = raw.h();
+        if(w < 2 || h < 2) {
+            throw std::invalid_argument(
+                "demosaic needs at least 2x2 pixels, got " + std::to_string(w) + "x" + std::to_string(h));
+        }
+
+        auto const& colors = detail::bayer_colors[static_cast<std::size_t>(pattern)];
+        auto const bands = (h + detail::demosaic_band_rows - 1) / detail::demosaic_band_rows;
+        detail::parallel_for(bands, threads, [&](std::size_t const band) {
+            auto const y_end = std::min(h, (band + 1) * detail::demosaic_band_rows);
+            for(auto y = band * detail::demosaic_band_rows; y < y_end; ++y) {
+                auto const row = raw.data() + y * w;
+                auto const up = raw.data() + (y > 0 ? y - 1 : 1) * w;
+                auto const down = raw.data() + (y + 1 < h ? y + 1 : h - 2) * w;
+                auto const out = result.data() + y * w;
+
+                using namespace detail;
+                auto const& row_colors = colors[y % 2];
+                if(row_colors[0] == bayer_red) {
+                    demosaic_row<bayer_red, bayer_green>(up, row, down, out, w);
+                } else if(row_colors[0] == bayer_blue) {
+                    demosaic_row<bayer_blue, bayer_green>(up, row, down, out, w);
+                } else if(row_colors[1] == bayer_red) {
+                    demosaic_row<bayer_green, bayer_red>(up, row, down, out, w);
+                } else {
+                    demosaic_row<bayer_green, bayer_blue>(up, row, down, out, w);
+                }
+            }
+        });
+        return result;
+    }
+
+
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "bitmask.hpp"
+#include "point.hpp"
+#include "rect.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Neighborhood of connected pixels
+    enum class connectivity : std::uint8_t {
+        /// \brief Left, right, top and bottom neighbors
+        four,
+
+        /// \brief Also the diagonal neighbors
+        eight
+    };
+
+    /// \brief Settings of connected_components
+    struct component_options {
+        connectivity neighbors = connectivity::eight;
+
+        /// \brief Threads for every pass, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+    /// \brief Statistics of one connected component
+    struct component_stats {
+        /// \brief Label of the component in component_labels::labels, starting with 1
+        std::uint32_t label = 0;
+
+        /// \brief Number of pixels
+        std::size_t area = 0;
+
+        /// \brief Smallest rect that contains all pixels
+        rect<std::size_t> bounds;
+
+        /// \brief Mean position of all pixels
+        point<double> centroid;
+    };
+
+    /// \brief Result of connected_components
+    struct component_labels {
+        /// \brief Label of every pixel, 0 for background
+        bitmap<std::uint32_t> labels;
+
+        /// \brief Statistics of every component, components[i].label is i + 1
+        std::vector<component_stats> components;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Minimum number of rows per thread band
+        constexpr std::size_t component_min_band_rows = 32;
+
+        /// \brief Foreground pixels [begin, end) of a row
+        struct component_run {
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        /// \brief Union-find over run indices that can be modified concurrently without locks
+        ///
+        /// Roots are always linked to the smaller root with a compare-and-swap, so the root of
+        /// a set is its smallest index and a failed link is just retried. find halves paths.
+        class concurrent_union_find {
+        public:
+            explicit concurrent_union_find(std::size_t const count)
+                : parent_(count) {
+                for(std::size_t i = 0; i < count; ++i) {
+                    parent_[i].store(static_cast<std::uint32_t>(i), std::memory_order_relaxed);
+                }
+            }
+
+            std::uint32_t find(std::uint32_t i) noexcept {
+                for(;;) {
+                    auto parent = parent_[i].load(std::memory_order_relaxed);
+                    if(parent == i) {
+                        return i;
+                    }
+                    auto const grandparent = parent_[parent].load(std::memory_order_relaxed);
+                    if(grandparent != parent) {
+                        // another thread may have changed i, then the halving is just skipped
+                        parent_[i].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                    }
+                    i = grandparent;
+                }
+            }
+
+            void unite(std::uint32_t a, std::uint32_t b) noexcept {
+                for(;;) {
+                    a = find(a);
+                    b = find(b);
+                    if(a == b) {
+                        return;
+                    }
+                    if(a < b) {
+                        std::swap(a, b);
+                    }
+                    auto expected = a;
+                    if(parent_[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) {
+                        return;
+                    }
+                }
+            }
+
+        private:
+            std::vector<std::atomic<std::uint32_t>> parent_;
+        };
+
+        /// \brief Runs of a row of a bitmask, found word by word
+        inline void component_row_runs(
+            bitmask const& mask,
+            std::size_t const y,
+            std::vector<component_run>& runs) {
+            for_each_run(mask, y, [&](std::size_t const begin, std::size_t const end) {
+                runs.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+            });
+        }
+
+        /// \brief Runs of a row of nonzero pixels
+        template <typename T>
+        void component_row_runs(bitmap<T> const& image, std::size_t const y, std::vector<component_run>& runs) {
+            auto const w = image.w();
+            std::size_t x = 0;
+            for(;;) {
+                while(x < w && image(x, y) == T(0)) {
+                    ++x;
+                }
+                if(x >= w) {
+                    return;
+                }
+                auto const begin = x;
+                while(x < w && image(x, y) != T(0)) {
+                    ++x;
+                }
+                runs.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(x)});
+            }
+        }
+
+        /// \brief Unite all overlapping runs of two neighboring rows
+        ///
+        /// Both rows are sorted, so one merge-like scan finds all pairs. With eight neighbors
+        /// runs that touch diagonally overlap too.
+        inline void component_unite_rows(
+            component_run const* const upper,
+            std::uint32_t const upper_first,
+            std::size_t const upper_count,
+            component_run const* const lower,
+            std::uint32_t const lower_first,
+            std::size_t const lower_count,
+            std::uint32_t const reach,
+            concurrent_union_find& sets) noexcept {
+            std::size_t i = 0;
+            std::size_t j = 0;
+            while(i < upper_count && j < lower_count) {
+                auto const& a = upper[i];
+                auto const& b = lower[j];
+                if(a.begin < b.end + reach && b.begin < a.end + reach) {
+                    sets.unite(upper_first + static_cast<std::uint32_t>(i), lower_first + static_cast<std::uint32_t>(j));
+                }
+                if(a.end < b.end) {
+                    ++i;
+                } else {
+                    ++j;
+                }
+            }
+        }
+
+        /// \brief Label the foreground of a bitmask or bitmap
+        ///
+        /// 1. Every band of rows collects the runs of its rows in parallel.
+        /// 2. Every band unites overlapping runs of its neighboring rows in parallel.
+        /// 3. The first row of every band is united with the last row of the band before, also
+        ///    in parallel, the union-find needs no locks.
+        /// 4. One pass over all runs in raster order numbers the roots and sums up the
+        ///    statistics, the roots are the first runs of their components.
+        /// 5. The label image is filled by bands in parallel.
+        template <typename Image>
+        component_labels connected_components(Image const& image, component_options const& options) {
+            auto const w = image.w();
+            auto const h = image.h();
+            component_labels result{bitmap<std::uint32_t>(w, h), {}};
+            if(w == 0 || h == 0) {
+                return result;
+            }
+            if(w > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::length_error("connected_components: width does not fit into 32 bit");
+            }
+
+            auto const bands = std::clamp<std::size_t>(h / component_min_band_rows, 1, thread_count(options.threads));
+            std::vector<std::vector<component_run>> band_runs(bands);
+            std::vector<std::size_t> row_begin(h + 1);
+            parallel_for(bands, bands, [&](std::size_t const band) {
+                auto const end = band_begin(band + 1, bands, h);
+                for(auto y = band_begin(band, bands, h); y < end; ++y) {
+                    row_begin[y] = band_runs[band].size();
+                    component_row_runs(image, y, band_runs[band]);
+                }
+            });
+
+            std::vector<component_run> runs;
+            for(std::size_t band = 0; band < bands; ++band) {
+                auto const offset = runs.size();
+                auto const end = band_begin(band + 1, bands, h);
+                for(auto y = band_begin(band, bands, h); y < end; ++y) {
+                    row_begin[y] += offset;
+                }
+                runs.insert(runs.end(), band_runs[band].begin(), band_runs[band].end());
+                band_runs[band] = {};
+            }
+            row_begin[h] = runs.size();
+            if(runs.size() >= std::numeric_limits<std::uint32_t>::max()) {
+                throw std::length_error("connected_components: more runs than fit into 32 bit");
+            }
+
+            concurrent_union_find sets(runs.size());
+            std::uint32_t const reach = options.neighbors == connectivity::eight ? 1 : 0;
+            auto const unite_rows = [&](std::size_t const y) {
+                component_unite_rows(
+                    runs.data() + row_begin[y - 1],
+                    static_cast<std::uint32_t>(row_begin[y - 1]),
+                    row_begin[y] - row_begin[y - 1],
+                    runs.data() + row_begin[y],
+                    static_cast<std::uint32_t>(row_begin[y]),
+                    row_begin[y + 1] - row_begin[y],
+                    reach,
+                    sets);
+            };
+            parallel_for(bands, bands, [&](std::size_t const band) {
+                auto const end = band_begin(band + 1, bands, h);
+                for(auto y = band_begin(band, bands, h) + 1; y < end; ++y) {
+                    unite_rows(y);
+                }
+            });
+            parallel_for(bands - 1, bands - 1, [&](std::size_t const index) { unite_rows(band_begin(index + 1, bands, h)); });
+
+            struct accumulator {
+                std::size_t l, t, r, b;
+                double sum_x, sum_y;
+            };
+            std::vector<std::uint32_t> run_labels(runs.size());
+            std::vector<accumulator> sums;
+            for(std::size_t y = 0; y < h; ++y) {
+                for(auto i = row_begin[y]; i < row_begin[y + 1]; ++i) {
+                    auto const root = sets.find(static_cast<std::uint32_t>(i));
+                    auto const& run = runs[i];
+                    if(root == i) {
+                        sums.push_back({run.begin, y, run.end, y + 1, 0, 0});
+                        result.components.push_back({static_cast<std::uint32_t>(sums.size()), 0, {}, {}});
+                    }
+                    auto const label = root == i ? static_cast<std::uint32_t>(sums.size()) : run_labels[root];
+                    run_labels[i] = label;
+
+                    auto& sum = sums[label - 1];
+                    auto const length = std::size_t(run.end - run.begin);
+                    sum.l = std::min<std::size_t>(sum.l, run.begin);
+                    sum.r = std::max<std::size_t>(sum.r, run.end);
+                    sum.b = y + 1;
+                    sum.sum_x += static_cast<double>(length) * (static_cast<double>(run.begin + run.end - 1) / 2);
+                    sum.sum_y += static_cast<double>(length * y);
+                    result.components[label - 1].area += length;
+                }
+            }
+
+            for(std::size_t i = 0; i < sums.size(); ++i) {
+                auto& component = result.components[i];
+                auto const& sum = sums[i];
+                auto const area = static_cast<double>(component.area);
+                component.bounds = rect<std::size_t>(sum.l, sum.t, sum.r - sum.l, sum.b - sum.t);
+                component.centroid = point<double>(sum.sum_x / area, sum.sum_y / area);
+            }
+
+            auto const out = result.labels.data();
+            parallel_for(bands, bands, [&](std::size_t const band) {
+                auto const end = band_begin(band + 1, bands, h);
+                for(auto y = band_begin(band, bands, h); y < end; ++y) {
+                    auto const row = out + y * w;
+                    for(auto i = row_begin[y]; i < row_begin[y + 1]; ++i) {
+                        std::fill(row + runs[i].begin, row + runs[i].end, run_labels[i]);
+                    }
+                }
+            });
+
+            return result;
+        }
+
+
+    }
+
+
+    /// \brief Label the connected set bits of mask and compute their statistics
+    ///
+    /// Rows are run-length encoded word by word, so large uniform areas are cheap. Components
+    /// are numbered from 1 in the raster order of their first pixel.
+    ///
+    /// \throw std::length_error if the runs do not fit into 32 bit indices
+    inline component_labels connected_components(bitmask const& mask, component_options const& options = {}) {
+        return detail::connected_components(mask, options);
+    }
+
+    /// \brief Label the connected nonzero pixels of image and compute their statistics
+    ///
+    /// See connected_components of a bitmask.
+    template <typename T>
+    component_labels connected_components(bitmap<T> const& image, component_options const& options = {}) {
+        static_assert(std::is_arithmetic_v<T>, "connected_components needs a bool or arithmetic type");
+        return detail::connected_components(image, options);
+    }
+
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "float16.hpp"
+#include "pixel.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+
+namespace bmp {
+
+
+    /// \brief Settings of convert, every channel value becomes value * scale + offset
+    struct convert_options {
+        double scale = 1;
+        double offset = 0;
+
+        /// \brief Round to nearest (half away from zero) for integral targets, truncate otherwise
+        bool round = true;
+
+        /// \brief Clamp to the range of integral targets, NaN becomes the minimum
+        ///
+        /// Without saturation values outside of the target range are undefined.
+        bool saturate = true;
+
+        /// \brief Threads for the conversion, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        template <typename V>
+        constexpr bool convert_fits_float = sizeof(V) <= 2 || std::is_same_v<V, float>;
+
+        /// \brief float if it represents all values of V and U exactly, double otherwise
+        template <typename V, typename U>
+        using convert_compute_type = std::conditional_t<convert_fits_float<V> && convert_fits_float<U>, float, double>;
+
+        /// \brief true if every value of V is a value of U
+        template <typename V, typename U>
+        constexpr bool convert_is_lossless() noexcept {
+            if constexpr(is_floating_channel_v<U>) {
+                if constexpr(is_floating_channel_v<V>) {
+                    return std::numeric_limits<V>::digits <= std::numeric_limits<U>::digits
+                        && std::numeric_limits<V>::max_exponent <= std::numeric_limits<U>::max_exponent;
+                } else {
+                    return std::numeric_limits<V>::digits <= std::numeric_limits<U>::digits;
+                }
+            } else if constexpr(is_floating_channel_v<V>) {
+                return false;
+            } else {
+                return std::cmp_greater_equal(std::numeric_limits<V>::min(), std::numeric_limits<U>::min())
+                    && std::cmp_less_equal(std::numeric_limits<V>::max(), std::numeric_limits<U>::max());
+            }
+        }
+
+        /// \brief Largest value of the integral type U that is exact in Compute
+        template <typename U, typename Compute>
+        constexpr Compute convert_max() noexcept {
+            constexpr auto lost_digits = std::numeric_limits<U>::digits - std::numeric_limits<Compute>::digits;
+            if constexpr(lost_digits > 0) {
+                return static_cast<Compute>(std::numeric_limits<U>::max() >> lost_digits << lost_digits);
+            } else {
+                return static_cast<Compute>(std::numeric_limits<U>::max());
+            }
+        }
+
+        /// \brief Convert count channel values
+        ///
+        /// Every path is a branch free loop the compiler vectorizes, all decisions are made
+        /// before the loop.
+        template <typename V, typename U>
+        void convert_values(V const* const in, U* const out, std::size_t const count, convert_options const& options) {
+            using compute = convert_compute_type<V, U>;
+
+            auto const unscaled = options.scale == 1 && options.offset == 0;
+            if constexpr(std::is_same_v<V, float16> && std::is_same_v<U, float>) {
+                if(unscaled) {
+                    float16_to_float(in, out, count);
+                    return;
+                }
+            } else if constexpr(std::is_same_v<V, float> && std::is_same_v<U, float16>) {
+                if(unscaled) {
+                    float_to_float16(in, out, count);
+                    return;
+                }
+            }
+
+            if constexpr(convert_is_lossless<V, U>()) {
+                if(unscaled) {
+                    for(std::size_t i = 0; i < count; ++i) {
+                        out[i] = static_cast<U>(in[i]);
+                    }
+                    return;
+                }
+            }
+
+            // value * 1 + 0 is exact, so unscaled data takes the same loop
+            auto const scale = static_cast<compute>(options.scale);
+            auto const offset = static_cast<compute>(options.offset);
+
+            if constexpr(is_floating_channel_v<U>) {
+                for(std::size_t i = 0; i < count; ++i) {
+                    out[i] = static_cast<U>(static_cast<compute>(in[i]) * scale + offset);
+                }
+            } else {
+                auto const min = static_cast<compute>(std::numeric_limits<U>::min());
+                auto const max = convert_max<U, compute>();
+                auto const half = static_cast<compute>(options.round ? 0.5 : 0);
+
+                if(options.saturate) {
+                    for(std::size_t i = 0; i < count; ++i) {
+                        auto value = static_cast<compute>(in[i]) * scale + offset;
+                        value += value >= 0 ? half : -half;
+                        value = value >= min ? value : min;
+                        value = value <= max ? value : max;
+                        out[i] = static_cast<U>(value);
+                    }
+                } else {
+                    for(std::size_t i = 0; i < count; ++i) {
+                        auto const value = static_cast<compute>(in[i]) * scale + offset;
+                        out[i] = static_cast<U>(value + (value >= 0 ? half : -half));
+                    }
+                }
+            }
+        }
+
+
+    }
+
+
+    /// \brief Convert every channel value of image into target, which is resized to the size of image
+    ///
+    /// A preallocated target of the right size is reused without allocation.
+    template <typename T, typename R>
+    void convert(bitmap<T> const& image, bitmap<R>& target, convert_options const& options = {}) {
+        using value_type = pixel::channel_type_t<T>;
+        using result_value_type = pixel::channel_type_t<R>;
+        constexpr auto channels = pixel::channel_count_v<T>;
+
+        static_assert(channels == pixel::channel_count_v<R>, "convert needs the same channel count");
+        static_assert(
+            (std::is_arithmetic_v<value_type> || is_half_float_v<value_type>)
+                && (std::is_arithmetic_v<result_value_type> || is_half_float_v<result_value_type>)
+                && !std::is_same_v<value_type, bool> && !std::is_same_v<result_value_type, bool>,
+            "convert needs arithmetic or half precision channel types");
+        static_assert(sizeof(T) == sizeof(value_type) * channels && sizeof(R) == sizeof(result_value_type) * channels);
+
+        if(target.size() != image.size()) {
+            target.resize(image.size());
+        }
+
+        auto const in = reinterpret_cast<value_type const*>(image.data());
+        auto const out = reinterpret_cast<result_value_type*>(target.data());
+        auto const count = image.point_count() * channels;
+
+        auto const threads = std::min(detail::thread_count(options.threads), count / 65536 + 1);
+        detail::parallel_for(threads, threads, [&](std::size_t const i) {
+            auto const begin = detail::band_begin(i, threads, count);
+            auto const end = detail::band_begin(i + 1, threads, count);
+            detail::convert_values(in + begin, out + begin, end - begin, options);
+        });
+    }
+
+    /// \brief Convert every channel value of image to U
+    template <typename U, typename T>
+    bitmap<pixel::with_channel_type_t<T, U>> convert(bitmap<T> const& image, convert_options const& options = {}) {
+        bitmap<pixel::with_channel_type_t<T, U>> result(image.size());
+        convert(image, result, options);
+        return result;
+    }
+
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../float16.hpp"
+
 #include <bit>
 #include <concepts>
 #include <cstdint>
@@ -10,7 +12,7 @@ namespace bmp::detail {
 
 
     template <typename T>
-    concept endian_supported = std::integral<T> || std::same_as<T, float> || std::same_as<T, double>;
+    concept endian_supported = std::integral<T> || std::same_as<T, float> || std::same_as<T, double> || is_half_float_v<T>;
 
     template <endian_supported T>
     struct integer_type_t{
@@ -27,6 +29,16 @@ namespace bmp::detail {
         using type = std::uint64_t;
     };
 
+    template <>
+    struct integer_type_t<float16>{
+        using type = std::uint16_t;
+    };
+
+    template <>
+    struct integer_type_t<bfloat16>{
+        using type = std::uint16_t;
+    };
+
     template <endian_supported T>
     using integer_type = integer_type_t<T>::type;
 
@@ -64,17 +76,26 @@ namespace bmp::detail {
         is_unsigned = 0x00,
         is_signed = 0x01,
         is_floating_point = 0x02,
-        is_bool = 0x03
+        is_bool = 0x03,
+        is_bfloat = 0x04
     };
 
     enum class binary_endian_flags : std::uint8_t { is_big_endian = 0x00, is_little_endian = 0x10 };
 
+    /// \brief Bit of the endian flag in the flags byte
+    constexpr std::uint8_t binary_endian_flag_bits = 0x10;
+
+    /// \brief Flag of masked data, a bit packed mask plane follows the values
+    constexpr std::uint8_t binary_masked_flag = 0x20;
+
     // clang-format off
     template <typename T>
     constexpr std::uint8_t binary_io_flags_v
         = static_cast<std::uint8_t>(std::is_same_v<T, bool>
             ? binary_type_flags::is_bool
-            : std::is_floating_point_v<T>
+            : std::is_same_v<T, bfloat16>
+            ? binary_type_flags::is_bfloat
+            : std::is_floating_point_v<T> || std::is_same_v<T, float16>
             ? binary_type_flags::is_floating_point
             : std::is_signed_v<T>
             ? binary_type_flags::is_signed
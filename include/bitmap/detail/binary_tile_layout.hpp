@@ -0,0 +1,317 @@
+#pragma once
+
+#include "../binary_compression.hpp"
+#include "../bitmap.hpp"
+#include "../exception.hpp"
+#include "../rect.hpp"
+#include "../subbitmap.hpp"
+
+#include "binary_io_flags.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace bmp::detail {
+
+
+    /// \brief Size of the version 2 header behind the common header
+    constexpr std::size_t binary_tiled_header_size = 16;
+
+    /// \brief Size of one tile index entry (offset and size)
+    constexpr std::size_t binary_tile_entry_size = 16;
+
+    /// \brief Offset of the tile index in a version 2 file
+    constexpr std::size_t binary_tile_index_offset = 24 + binary_tiled_header_size;
+
+    /// \brief Maximum number of pyramid levels
+    constexpr std::size_t binary_max_levels = 64;
+
+
+    /// \brief Position of a tile in the file, size 0 means the tile was never written
+    struct binary_tile_entry {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    /// \brief Settings of a version 2 file behind the common header
+    struct binary_tiled_header {
+        binary_codec codec;
+        std::uint8_t filters;
+        std::uint32_t tile_w;
+        std::uint32_t tile_h;
+        std::uint32_t levels;
+    };
+
+
+    /// \brief Level sizes and tile grid of the tiled format version 2
+    ///
+    /// Level 0 is the full resolution image, every further level has half width and height
+    /// (rounded up). The index lists the tiles of all levels in level then row major order.
+    class binary_tile_layout {
+    public:
+        binary_tile_layout() = default;
+
+        /// \throw binary_io_error if tile size or level count are invalid
+        binary_tile_layout(
+            std::size_t w,
+            std::size_t h,
+            std::size_t const tile_w,
+            std::size_t const tile_h,
+            std::size_t const levels)
+            : tile_w_(tile_w)
+            , tile_h_(tile_h) {
+            if(tile_w == 0 || tile_h == 0 || tile_w > 0xFFFFFFFF || tile_h > 0xFFFFFFFF) {
+                throw binary_io_error(
+                    "invalid tile size " + std::to_string(tile_w) + "x" + std::to_string(tile_h));
+            }
+            if(levels == 0 || levels > binary_max_levels) {
+                throw binary_io_error("invalid level count " + std::to_string(levels));
+            }
+
+            levels_.reserve(levels);
+            std::size_t first = 0;
+            for(std::size_t i = 0; i < levels; ++i) {
+                auto const tiles_x = (w + tile_w - 1) / tile_w;
+                auto const tiles_y = (h + tile_h - 1) / tile_h;
+                levels_.push_back({w, h, tiles_x, tiles_y, first});
+                first += tiles_x * tiles_y;
+                w = (w + 1) / 2;
+                h = (h + 1) / 2;
+            }
+            tile_count_ = first;
+        }
+
+        std::size_t levels() const noexcept {
+            return levels_.size();
+        }
+
+        std::size_t tile_w() const noexcept {
+            return tile_w_;
+        }
+
+        std::size_t tile_h() const noexcept {
+            return tile_h_;
+        }
+
+        /// \brief Size of the image in level
+        ::bmp::size<std::size_t> level_size(std::size_t const level) const {
+            auto const& data = get(level);
+            return {data.w, data.h};
+        }
+
+        std::size_t tiles_x(std::size_t const level) const {
+            return get(level).tiles_x;
+        }
+
+        std::size_t tiles_y(std::size_t const level) const {
+            return get(level).tiles_y;
+        }
+
+        /// \brief Number of tiles in all levels
+        std::size_t tile_count() const noexcept {
+            return tile_count_;
+        }
+
+        /// \brief Position of the tile in the index
+        ///
+        /// \throw std::out_of_range
+        std::size_t tile_index(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            auto const& data = get(level);
+            if(tx >= data.tiles_x || ty >= data.tiles_y) {
+                throw std::out_of_range(
+                    "tile (" + std::to_string(tx) + ", " + std::to_string(ty) + ") out of range in level "
+                    + std::to_string(level));
+            }
+            return data.first + ty * data.tiles_x + tx;
+        }
+
+        /// \brief Area of the tile in its level, tiles at the right and bottom border are smaller
+        ///
+        /// \throw std::out_of_range
+        rect<std::size_t> tile_rect(std::size_t const level, std::size_t const tx, std::size_t const ty) const {
+            tile_index(level, tx, ty);
+            auto const& data = get(level);
+            auto const x = tx * tile_w_;
+            auto const y = ty * tile_h_;
+            return {x, y, std::min(tile_w_, data.w - x), std::min(tile_h_, data.h - y)};
+        }
+
+        /// \brief Offset of the first tile data byte
+        std::uint64_t data_offset() const noexcept {
+            return binary_tile_index_offset + tile_count_ * binary_tile_entry_size;
+        }
+
+    private:
+        struct level_data {
+            std::size_t w;
+            std::size_t h;
+            std::size_t tiles_x;
+            std::size_t tiles_y;
+            std::size_t first;
+        };
+
+        level_data const& get(std::size_t const level) const {
+            if(level >= levels_.size()) {
+                throw std::out_of_range(
+                    "level " + std::to_string(level) + " out of range, file has " + std::to_string(levels_.size())
+                    + " levels");
+            }
+            return levels_[level];
+        }
+
+        std::vector<level_data> levels_;
+        std::size_t tile_w_ = 1;
+        std::size_t tile_h_ = 1;
+        std::size_t tile_count_ = 0;
+    };
+
+
+    inline void write_u32_be(std::byte* const out, std::uint32_t const value) noexcept {
+        auto const data = byteswap_on_little_endian(value);
+        std::memcpy(out, &data, 4);
+    }
+
+    inline std::uint32_t read_u32_be(std::byte const* const in) noexcept {
+        std::uint32_t value;
+        std::memcpy(&value, in, 4);
+        return byteswap_on_little_endian(value);
+    }
+
+    inline void write_u64_be(std::byte* const out, std::uint64_t const value) noexcept {
+        auto const data = byteswap_on_little_endian(value);
+        std::memcpy(out, &data, 8);
+    }
+
+    inline void write_tiled_header(std::byte* const out, binary_tiled_header const& header) noexcept {
+        out[0] = static_cast<std::byte>(header.codec);
+        out[1] = static_cast<std::byte>(header.filters);
+        out[2] = std::byte{0};
+        out[3] = std::byte{0};
+        write_u32_be(out + 4, header.tile_w);
+        write_u32_be(out + 8, header.tile_h);
+        write_u32_be(out + 12, header.levels);
+    }
+
+    /// \throw binary_io_error
+    inline binary_tiled_header read_tiled_header(std::byte const* const in) {
+        binary_tiled_header const header{
+            static_cast<binary_codec>(in[0]),
+            static_cast<std::uint8_t>(in[1]),
+            read_u32_be(in + 4),
+            read_u32_be(in + 8),
+            read_u32_be(in + 12)};
+
+        if(header.codec != binary_codec::none && header.codec != binary_codec::lz4) {
+            throw binary_io_error("unknown codec " + std::to_string(std::uint32_t(header.codec)));
+        }
+        if((header.filters & ~std::uint8_t(0x03)) != 0 || in[2] != std::byte{0} || in[3] != std::byte{0}) {
+            throw binary_io_error("unknown compression flags");
+        }
+        return header;
+    }
+
+    inline void write_tile_index(std::byte* out, std::vector<binary_tile_entry> const& index) noexcept {
+        for(auto const& entry: index) {
+            write_u64_be(out, entry.offset);
+            write_u64_be(out + 8, entry.size);
+            out += binary_tile_entry_size;
+        }
+    }
+
+    inline std::vector<binary_tile_entry> read_tile_index(std::byte const* in, std::size_t const count) {
+        std::vector<binary_tile_entry> index(count);
+        for(auto& entry: index) {
+            entry.offset = read_u64_be(in);
+            entry.size = read_u64_be(in + 8);
+            in += binary_tile_entry_size;
+        }
+        return index;
+    }
+
+    /// \brief Decode a stored tile of size bytes into tile, which is resized to area
+    ///
+    /// The size is checked against the largest possible tile before read(data, size) fills
+    /// data with the stored bytes, so a corrupt index can't cause a huge allocation.
+    ///
+    /// \throw binary_io_error
+    template <typename T, typename ReadFn>
+    void binary_decode_tile(
+        bitmap<T>& tile,
+        rect<std::size_t> const& area,
+        std::uint64_t const size,
+        ReadFn const& read,
+        bool const swap_endian,
+        binary_tiled_header const& header,
+        std::vector<std::byte>& data,
+        binary_band_buffer& buffer) {
+        if(size > lz4::compress_bound(binary_band_bytes<T>(area.w(), area.h()))) {
+            throw binary_io_error("tile size " + std::to_string(size) + " out of range");
+        }
+
+        data.resize(static_cast<std::size_t>(size));
+        read(data.data(), data.size());
+
+        tile.resize(area.w(), area.h());
+        decompress_band(tile, 0, area.h(), data.data(), data.size(), swap_endian, header.codec, header.filters, buffer);
+    }
+
+    /// \brief Reads level 0 of the version 2 data behind the common header
+    ///
+    /// The stream must be seekable since tiles can be stored in any order.
+    template <typename T>
+    void binary_read_tiled_data(bitmap<T>& image, std::istream& is, bool const swap_endian) {
+        auto const header_end = is.tellg();
+        if(header_end < 24) {
+            throw binary_io_error("tiled binary format needs a seekable stream");
+        }
+        auto const begin = header_end - std::streamoff(24);
+
+        std::byte tiled_header_data[binary_tiled_header_size];
+        is.read(reinterpret_cast<char*>(tiled_header_data), binary_tiled_header_size);
+        if(!is.good()) {
+            throw binary_io_error("can't read tiled header");
+        }
+        auto const header = read_tiled_header(tiled_header_data);
+        binary_tile_layout const layout(image.w(), image.h(), header.tile_w, header.tile_h, header.levels);
+
+        auto const tile_count = layout.tiles_x(0) * layout.tiles_y(0);
+        std::vector<std::byte> index_data(tile_count * binary_tile_entry_size);
+        is.read(reinterpret_cast<char*>(index_data.data()), static_cast<std::streamsize>(index_data.size()));
+        if(!is.good()) {
+            throw binary_io_error("can't read tile index");
+        }
+        auto const index = read_tile_index(index_data.data(), tile_count);
+
+        bitmap<T> tile;
+        binary_band_buffer buffer;
+        std::vector<std::byte> data;
+        for(std::size_t ty = 0; ty < layout.tiles_y(0); ++ty) {
+            for(std::size_t tx = 0; tx < layout.tiles_x(0); ++tx) {
+                auto const area = layout.tile_rect(0, tx, ty);
+                auto const& entry = index[ty * layout.tiles_x(0) + tx];
+                if(entry.size == 0) {
+                    tile = bitmap<T>(area.w(), area.h());
+                } else {
+                    auto const read = [&](std::byte* const target, std::size_t const size) {
+                        is.seekg(begin + static_cast<std::streamoff>(entry.offset));
+                        is.read(reinterpret_cast<char*>(target), static_cast<std::streamsize>(size));
+                        if(!is.good()) {
+                            throw binary_io_error("can't read tile data");
+                        }
+                    };
+                    binary_decode_tile(tile, area, entry.size, read, swap_endian, header, data, buffer);
+                }
+
+                copy(image, tile, rect<std::size_t>(area.w(), area.h()), area.pos());
+            }
+        }
+    }
+
+
+}
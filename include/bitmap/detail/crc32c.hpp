@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#    include <nmmintrin.h>
+#endif
+
+
+namespace bmp::detail {
+
+
+    namespace crc32c_impl {
+
+
+        constexpr std::uint32_t polynomial = 0x82F63B78; // reflected Castagnoli
+
+        using table_type = std::array<std::array<std::uint32_t, 256>, 8>;
+
+        constexpr table_type make_tables() noexcept {
+            table_type tables{};
+            for(std::uint32_t i = 0; i < 256; ++i) {
+                auto crc = i;
+                for(int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) != 0 ? polynomial : 0);
+                }
+                tables[0][i] = crc;
+            }
+            for(std::size_t t = 1; t < 8; ++t) {
+                for(std::size_t i = 0; i < 256; ++i) {
+                    auto const previous = tables[t - 1][i];
+                    tables[t][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+                }
+            }
+            return tables;
+        }
+
+        inline constexpr table_type tables = make_tables();
+
+        /// \brief Slicing by 8 software implementation on the inverted crc
+        inline std::uint32_t software(std::uint32_t crc, std::byte const* data, std::size_t size) noexcept {
+            for(; size >= 8; size -= 8, data += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, data, 8);
+                if constexpr(std::endian::native == std::endian::big) {
+                    word = std::byteswap(word);
+                }
+                word ^= crc;
+                crc = tables[7][word & 0xFF] ^ tables[6][(word >> 8) & 0xFF] ^ tables[5][(word >> 16) & 0xFF]
+                    ^ tables[4][(word >> 24) & 0xFF] ^ tables[3][(word >> 32) & 0xFF] ^ tables[2][(word >> 40) & 0xFF]
+                    ^ tables[1][(word >> 48) & 0xFF] ^ tables[0][word >> 56];
+            }
+            for(; size > 0; --size, ++data) {
+                crc = (crc >> 8) ^ tables[0][(crc ^ static_cast<std::uint32_t>(*data)) & 0xFF];
+            }
+            return crc;
+        }
+
+#if defined(__SSE4_2__) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#    define BMP_HAS_CRC32C_SSE42 1
+
+        /// \brief SSE4.2 crc32 instruction on the inverted crc
+#    ifndef __SSE4_2__
+        __attribute__((target("sse4.2")))
+#    endif
+        inline std::uint32_t
+            sse42(std::uint32_t crc, std::byte const* data, std::size_t size) noexcept {
+#    ifdef __x86_64__
+            std::uint64_t crc64 = crc;
+            for(; size >= 8; size -= 8, data += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, data, 8);
+                crc64 = _mm_crc32_u64(crc64, word);
+            }
+            crc = static_cast<std::uint32_t>(crc64);
+#    endif
+            for(; size >= 4; size -= 4, data += 4) {
+                std::uint32_t word;
+                std::memcpy(&word, data, 4);
+                crc = _mm_crc32_u32(crc, word);
+            }
+            for(; size > 0; --size, ++data) {
+                crc = _mm_crc32_u8(crc, static_cast<std::uint8_t>(*data));
+            }
+            return crc;
+        }
+
+        inline bool has_sse42() noexcept {
+#    ifdef __SSE4_2__
+            return true;
+#    else
+            static bool const result = __builtin_cpu_supports("sse4.2");
+            return result;
+#    endif
+        }
+#endif
+
+
+    }
+
+
+    /// \brief Continue the CRC32C (Castagnoli) crc with size bytes of data, start with crc 0
+    ///
+    /// Uses the SSE4.2 crc32 instruction if the CPU supports it, a table based implementation
+    /// otherwise.
+    inline std::uint32_t crc32c(std::uint32_t const crc, void const* const data, std::size_t const size) noexcept {
+        auto const bytes = static_cast<std::byte const*>(data);
+#ifdef BMP_HAS_CRC32C_SSE42
+        if(crc32c_impl::has_sse42()) {
+            return ~crc32c_impl::sse42(~crc, bytes, size);
+        }
+#endif
+        return ~crc32c_impl::software(~crc, bytes, size);
+    }
+
+
+}
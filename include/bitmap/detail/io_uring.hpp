@@ -0,0 +1,184 @@
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#    define BMP_HAS_IO_URING 1
+
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+#    include <algorithm>
+#    include <atomic>
+#    include <cerrno>
+#    include <cstdint>
+#    include <cstring>
+#    include <system_error>
+
+
+namespace bmp::detail {
+
+
+    /// \brief Minimal io_uring for batches of read and write requests
+    ///
+    /// Uses the raw system calls, liburing is not required.
+    class io_uring {
+    public:
+        /// \brief Create a ring with at least entries submission queue entries
+        /// \throw std::system_error if io_uring is not available
+        explicit io_uring(unsigned const entries) {
+            ::io_uring_params params{};
+            fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if(fd_ < 0) {
+                throw std::system_error(errno, std::system_category(), "io_uring_setup");
+            }
+
+            entries_ = params.sq_entries;
+
+            sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+            bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if(single_mmap) {
+                sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+            }
+
+            sq_ = map(sq_size_, IORING_OFF_SQ_RING);
+            cq_ = single_mmap ? sq_ : map(cq_size_, IORING_OFF_CQ_RING);
+            sqes_size_ = params.sq_entries * sizeof(::io_uring_sqe);
+            sqes_ = static_cast<::io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+            auto const sq = static_cast<char*>(sq_);
+            sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+            auto const cq = static_cast<char*>(cq_);
+            cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<::io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        io_uring(io_uring const&) = delete;
+        io_uring& operator=(io_uring const&) = delete;
+
+        ~io_uring() {
+            release();
+        }
+
+        /// \brief Number of submission queue entries
+        unsigned entries() const noexcept {
+            return entries_;
+        }
+
+        /// \brief Queue a read or write, returns false if the submission queue is full
+        bool prepare(
+            bool const write,
+            int const fd,
+            void* const data,
+            unsigned const size,
+            std::uint64_t const offset,
+            std::uint64_t const user_data) noexcept {
+            auto const tail = *sq_tail_;
+            if(tail - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) == entries_) {
+                return false;
+            }
+
+            auto const index = tail & sq_mask_;
+            auto& sqe = sqes_[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(data);
+            sqe.len = size;
+            sqe.off = offset;
+            sqe.user_data = user_data;
+
+            sq_array_[index] = index;
+            std::atomic_ref(*sq_tail_).store(tail + 1, std::memory_order_release);
+            ++to_submit_;
+            return true;
+        }
+
+        /// \brief Submit all prepared requests and wait for at least wait_count completions
+        /// \throw std::system_error
+        void submit(unsigned const wait_count) {
+            for(;;) {
+                auto const result = ::syscall(
+                    __NR_io_uring_enter, fd_, to_submit_, wait_count, wait_count > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if(result >= 0) {
+                    to_submit_ -= static_cast<unsigned>(result);
+                    return;
+                }
+                if(errno != EINTR) {
+                    throw std::system_error(errno, std::system_category(), "io_uring_enter");
+                }
+            }
+        }
+
+        /// \brief Call fn(user_data, result) for every available completion
+        template <typename Fn>
+        std::size_t reap(Fn&& fn) {
+            auto head = *cq_head_;
+            auto const tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+            std::size_t count = 0;
+            for(; head != tail; ++head, ++count) {
+                auto const& cqe = cqes_[head & cq_mask_];
+                fn(cqe.user_data, cqe.res);
+            }
+            std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+            return count;
+        }
+
+    private:
+        void release() noexcept {
+            if(sqes_) {
+                ::munmap(sqes_, sqes_size_);
+            }
+            if(cq_ && cq_ != sq_) {
+                ::munmap(cq_, cq_size_);
+            }
+            if(sq_) {
+                ::munmap(sq_, sq_size_);
+            }
+            ::close(fd_);
+        }
+
+        void* map(std::size_t const size, std::uint64_t const offset) {
+            auto const result
+                = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, static_cast<off_t>(offset));
+            if(result == MAP_FAILED) {
+                auto const error = errno;
+                release();
+                throw std::system_error(error, std::system_category(), "io_uring mmap");
+            }
+            return result;
+        }
+
+        int fd_ = -1;
+        unsigned entries_ = 0;
+        unsigned to_submit_ = 0;
+
+        void* sq_ = nullptr;
+        void* cq_ = nullptr;
+        ::io_uring_sqe* sqes_ = nullptr;
+        std::size_t sq_size_ = 0;
+        std::size_t cq_size_ = 0;
+        std::size_t sqes_size_ = 0;
+
+        unsigned* sq_head_ = nullptr;
+        unsigned* sq_tail_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned* sq_array_ = nullptr;
+
+        unsigned* cq_head_ = nullptr;
+        unsigned* cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        ::io_uring_cqe* cqes_ = nullptr;
+    };
+
+
+}
+
+#endif
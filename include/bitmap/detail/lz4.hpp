@@ -0,0 +1,229 @@
+#pragma once
+
+#include "../exception.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace bmp::detail::lz4 {
+
+
+    /// \brief Largest input of a single LZ4 block
+    constexpr std::size_t max_input_size = 0x7E000000;
+
+    /// \brief Largest possible compressed size of size input bytes
+    constexpr std::size_t compress_bound(std::size_t const size) noexcept {
+        return size + size / 255 + 16;
+    }
+
+
+    namespace impl {
+
+
+        constexpr std::size_t min_match = 4;
+        constexpr std::size_t last_literals = 5;
+        constexpr std::size_t match_find_limit = 12;
+        constexpr std::size_t max_offset = 65535;
+        constexpr unsigned hash_bits = 14;
+
+        inline std::uint32_t read32(std::byte const* const data) noexcept {
+            std::uint32_t value;
+            std::memcpy(&value, data, 4);
+            return value;
+        }
+
+        inline std::uint32_t hash(std::uint32_t const value) noexcept {
+            return (value * 2654435761u) >> (32 - hash_bits);
+        }
+
+        inline std::byte* write_length(std::byte* out, std::size_t length) noexcept {
+            for(; length >= 255; length -= 255) {
+                *out++ = std::byte{255};
+            }
+            *out++ = static_cast<std::byte>(length);
+            return out;
+        }
+
+        inline std::byte* write_sequence(
+            std::byte* out,
+            std::byte const* const literals,
+            std::size_t const literal_length,
+            std::size_t const offset,
+            std::size_t const match_length) noexcept {
+            auto const token = out++;
+            auto const literal_token = std::min<std::size_t>(literal_length, 15);
+            if(literal_length >= 15) {
+                out = write_length(out, literal_length - 15);
+            }
+            std::memcpy(out, literals, literal_length);
+            out += literal_length;
+
+            if(match_length == 0) {
+                *token = static_cast<std::byte>(literal_token << 4);
+                return out;
+            }
+
+            *out++ = static_cast<std::byte>(offset & 0xFF);
+            *out++ = static_cast<std::byte>(offset >> 8);
+
+            auto const match_code = match_length - min_match;
+            *token = static_cast<std::byte>(literal_token << 4 | std::min<std::size_t>(match_code, 15));
+            if(match_code >= 15) {
+                out = write_length(out, match_code - 15);
+            }
+            return out;
+        }
+
+        inline std::size_t read_length(std::byte const* const in, std::size_t& pos, std::size_t const size) {
+            std::size_t length = 0;
+            for(;;) {
+                if(pos >= size) {
+                    throw binary_io_error("corrupt LZ4 block: truncated length");
+                }
+                auto const value = static_cast<std::size_t>(in[pos++]);
+                length += value;
+                if(value != 255) {
+                    return length;
+                }
+            }
+        }
+
+
+    }
+
+
+    /// \brief Compress into the LZ4 block format, returns the compressed size
+    ///
+    /// out must have room for compress_bound(size) bytes, size must not exceed max_input_size.
+    /// table is a reusable work buffer.
+    inline std::size_t compress(
+        std::byte const* const in,
+        std::size_t const size,
+        std::byte* const out,
+        std::vector<std::uint32_t>& table) {
+        using namespace impl;
+
+        auto op = out;
+        std::size_t anchor = 0;
+
+        if(size > match_find_limit) {
+            table.assign(std::size_t(1) << hash_bits, 0);
+
+            auto const match_limit = size - last_literals;
+            std::size_t pos = 1;
+            table[hash(read32(in))] = 0;
+
+            while(pos < size - match_find_limit) {
+                auto const value = read32(in + pos);
+                auto& entry = table[hash(value)];
+                std::size_t candidate = entry;
+                entry = static_cast<std::uint32_t>(pos);
+
+                if(candidate >= pos || pos - candidate > max_offset || read32(in + candidate) != value) {
+                    // skip faster through incompressible data
+                    pos += 1 + ((pos - anchor) >> 6);
+                    continue;
+                }
+
+                while(pos > anchor && candidate > 0 && in[pos - 1] == in[candidate - 1]) {
+                    --pos;
+                    --candidate;
+                }
+
+                auto length = min_match;
+                while(pos + length < match_limit && in[candidate + length] == in[pos + length]) {
+                    ++length;
+                }
+
+                op = write_sequence(op, in + anchor, pos - anchor, pos - candidate, length);
+                pos += length;
+                anchor = pos;
+
+                if(pos < size - match_find_limit) {
+                    table[hash(read32(in + pos - 2))] = static_cast<std::uint32_t>(pos - 2);
+                }
+            }
+        }
+
+        op = write_sequence(op, in + anchor, size - anchor, 0, 0);
+        return static_cast<std::size_t>(op - out);
+    }
+
+    /// \brief Decompress a LZ4 block that must decode to exactly out_size bytes
+    ///
+    /// \throw binary_io_error if the block is corrupt
+    inline void decompress(
+        std::byte const* const in,
+        std::size_t const size,
+        std::byte* const out,
+        std::size_t const out_size) {
+        using namespace impl;
+
+        std::size_t ip = 0;
+        std::size_t op = 0;
+        for(;;) {
+            if(ip >= size) {
+                throw binary_io_error("corrupt LZ4 block: truncated sequence");
+            }
+            auto const token = static_cast<std::size_t>(in[ip++]);
+
+            auto literal_length = token >> 4;
+            if(literal_length == 15) {
+                literal_length += read_length(in, ip, size);
+            }
+            if(literal_length > size - ip || literal_length > out_size - op) {
+                throw binary_io_error("corrupt LZ4 block: literals out of range");
+            }
+            std::memcpy(out + op, in + ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+
+            if(ip == size) {
+                break;
+            }
+
+            if(size - ip < 2) {
+                throw binary_io_error("corrupt LZ4 block: truncated offset");
+            }
+            auto const offset = static_cast<std::size_t>(in[ip]) | static_cast<std::size_t>(in[ip + 1]) << 8;
+            ip += 2;
+            if(offset == 0 || offset > op) {
+                throw binary_io_error("corrupt LZ4 block: offset out of range");
+            }
+
+            auto match_length = token & 15;
+            if(match_length == 15) {
+                match_length += read_length(in, ip, size);
+            }
+            match_length += min_match;
+            if(match_length > out_size - op) {
+                throw binary_io_error("corrupt LZ4 block: match out of range");
+            }
+
+            if(offset == 1) {
+                std::memset(out + op, static_cast<int>(out[op - 1]), match_length);
+                op += match_length;
+            } else {
+                // the pattern repeats with period offset, so the copy can double in each step
+                // without source and destination overlapping
+                auto const source = out + op - offset;
+                auto const begin = op;
+                for(auto const end = op + match_length; op < end;) {
+                    auto const count = std::min(op - begin + offset, end - op);
+                    std::memcpy(out + op, source, count);
+                    op += count;
+                }
+            }
+        }
+
+        if(op != out_size) {
+            throw binary_io_error("corrupt LZ4 block: wrong decompressed size");
+        }
+    }
+
+
+}
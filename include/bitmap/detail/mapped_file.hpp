@@ -0,0 +1,120 @@
+#pragma once
+
+#include "../exception.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    include <cerrno>
+#endif
+
+
+namespace bmp::detail {
+
+
+    /// \brief Read only memory map of a whole file
+    ///
+    /// Uses mmap on POSIX systems. If the file can't be mapped or on other systems, the file is
+    /// read into memory instead.
+    class mapped_file {
+    public:
+        /// \throw binary_io_error if the file can't be opened
+        explicit mapped_file(std::string filename)
+            : filename_(std::move(filename)) {
+#if defined(__unix__) || defined(__APPLE__)
+            auto const fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) {
+                throw binary_io_error("can't open file: " + filename_);
+            }
+
+            struct stat status;
+            if(::fstat(fd, &status) != 0) {
+                auto const error = errno;
+                ::close(fd);
+                throw binary_io_error("can't stat file (" + std::string(std::strerror(error)) + "): " + filename_);
+            }
+
+            size_ = static_cast<std::size_t>(status.st_size);
+            if(size_ > 0) {
+                auto const data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(data != MAP_FAILED) {
+                    mapping_ = data;
+                    data_ = static_cast<std::byte const*>(data);
+                }
+            }
+            ::close(fd);
+
+            if(size_ == 0 || mapping_ != nullptr) {
+                return;
+            }
+#endif
+            read_all();
+        }
+
+        mapped_file(mapped_file const&) = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+
+        ~mapped_file() {
+#if defined(__unix__) || defined(__APPLE__)
+            if(mapping_ != nullptr) {
+                ::munmap(mapping_, size_);
+            }
+#endif
+        }
+
+        /// \brief Name of the file
+        std::string const& filename() const noexcept {
+            return filename_;
+        }
+
+        /// \brief true if the file is memory mapped, false if it was read into memory
+        bool mapped() const noexcept {
+            return mapping_ != nullptr;
+        }
+
+        std::byte const* data() const noexcept {
+            return data_;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+    private:
+        void read_all() {
+            std::ifstream is(filename_.c_str(), std::ios_base::binary);
+            if(!is.is_open()) {
+                throw binary_io_error("can't open file: " + filename_);
+            }
+
+            is.seekg(0, std::ios_base::end);
+            buffer_.resize(static_cast<std::size_t>(is.tellg()));
+            is.seekg(0);
+            is.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+            if(!is.good() && !buffer_.empty()) {
+                throw binary_io_error("can't read file: " + filename_);
+            }
+
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+
+        std::string filename_;
+        void* mapping_ = nullptr;
+        std::byte const* data_ = nullptr;
+        std::size_t size_ = 0;
+        std::vector<std::byte> buffer_;
+    };
+
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace bmp::detail {
+
+
+    /// \brief Number of threads to use, 0 means one per hardware thread
+    inline std::size_t thread_count(std::size_t const requested) noexcept {
+        if(requested != 0) {
+            return requested;
+        }
+
+        auto const hardware = std::thread::hardware_concurrency();
+        return hardware != 0 ? hardware : 1;
+    }
+
+    /// \brief First element of band index if length elements are split into count bands
+    constexpr std::size_t band_begin(std::size_t const index, std::size_t const count, std::size_t const length) noexcept {
+        return length / count * index + length % count * index / count;
+    }
+
+    /// \brief Calls fn(index) for every index in [0, count) on up to threads threads
+    ///
+    /// The calling thread works too. The first exception thrown by fn is rethrown after all
+    /// threads are joined, remaining indices are skipped then.
+    template <typename Fn>
+    void parallel_for(std::size_t const count, std::size_t const threads, Fn const& fn) {
+        auto const thread_count = std::min(detail::thread_count(threads), count);
+        if(thread_count <= 1) {
+            for(std::size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto const work = [&] {
+            for(auto i = next++; i < count; i = next++) {
+                try {
+                    fn(i);
+                } catch(...) {
+                    std::lock_guard lock(error_mutex);
+                    if(!error) {
+                        error = std::current_exception();
+                    }
+                    next = count;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for(std::size_t i = 1; i < thread_count; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for(auto& worker: workers) {
+            worker.join();
+        }
+
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+
+}
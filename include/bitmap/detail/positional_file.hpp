@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../exception.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    include <cerrno>
+#else
+#    include <fstream>
+#    include <mutex>
+#endif
+
+
+namespace bmp::detail {
+
+
+    /// \brief File with thread safe reads and writes at explicit offsets
+    ///
+    /// Uses pread/pwrite on POSIX systems and a std::fstream behind a mutex otherwise.
+    class positional_file {
+    public:
+        enum class mode {
+            /// \brief Open an existing file for reading
+            read,
+
+            /// \brief Create or truncate a file for writing
+            write
+        };
+
+        /// \throw binary_io_error if the file can't be opened
+        positional_file(std::string filename, mode const open_mode)
+            : filename_(std::move(filename)) {
+#if defined(__unix__) || defined(__APPLE__)
+            fd_ = open_mode == mode::read ? ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC)
+                                          : ::open(filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if(fd_ < 0) {
+                throw binary_io_error("can't open file: " + filename_);
+            }
+#else
+            file_.open(
+                filename_,
+                open_mode == mode::read ? std::ios_base::in | std::ios_base::binary
+                                        : std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+            if(!file_.is_open()) {
+                throw binary_io_error("can't open file: " + filename_);
+            }
+#endif
+        }
+
+        positional_file(positional_file const&) = delete;
+        positional_file& operator=(positional_file const&) = delete;
+
+        ~positional_file() {
+#if defined(__unix__) || defined(__APPLE__)
+            if(fd_ >= 0) {
+                ::close(fd_);
+            }
+#endif
+        }
+
+        /// \brief Name of the file
+        std::string const& filename() const noexcept {
+            return filename_;
+        }
+
+        /// \brief Current size of the file in bytes
+        std::uint64_t size() const {
+#if defined(__unix__) || defined(__APPLE__)
+            struct stat status;
+            if(::fstat(fd_, &status) != 0) {
+                fail("can't stat file");
+            }
+            return static_cast<std::uint64_t>(status.st_size);
+#else
+            std::lock_guard lock(mutex_);
+            file_.seekg(0, std::ios_base::end);
+            return static_cast<std::uint64_t>(file_.tellg());
+#endif
+        }
+
+        /// \brief Read exactly size bytes at offset
+        ///
+        /// \throw binary_io_error
+        void read(std::byte* data, std::size_t size, std::uint64_t offset) const {
+#if defined(__unix__) || defined(__APPLE__)
+            while(size > 0) {
+                auto const result = ::pread(fd_, data, size, static_cast<off_t>(offset));
+                if(result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(result < 0) {
+                    fail("can't read file");
+                }
+                if(result == 0) {
+                    throw binary_io_error("unexpected end of file: " + filename_);
+                }
+                data += result;
+                size -= static_cast<std::size_t>(result);
+                offset += static_cast<std::uint64_t>(result);
+            }
+#else
+            std::lock_guard lock(mutex_);
+            file_.seekg(static_cast<std::streamoff>(offset));
+            file_.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+            if(!file_.good()) {
+                file_.clear();
+                throw binary_io_error("can't read file: " + filename_);
+            }
+#endif
+        }
+
+        /// \brief Write size bytes at offset
+        ///
+        /// \throw binary_io_error
+        void write(std::byte const* data, std::size_t size, std::uint64_t offset) {
+#if defined(__unix__) || defined(__APPLE__)
+            while(size > 0) {
+                auto const result = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+                if(result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(result <= 0) {
+                    fail("can't write file");
+                }
+                data += result;
+                size -= static_cast<std::size_t>(result);
+                offset += static_cast<std::uint64_t>(result);
+            }
+#else
+            std::lock_guard lock(mutex_);
+            file_.seekp(static_cast<std::streamoff>(offset));
+            file_.write(reinterpret_cast<char const*>(data), static_cast<std::streamsize>(size));
+            if(!file_.good()) {
+                file_.clear();
+                throw binary_io_error("can't write file: " + filename_);
+            }
+#endif
+        }
+
+        /// \brief Close the file, reports errors of buffered writes
+        ///
+        /// \throw binary_io_error
+        void close() {
+#if defined(__unix__) || defined(__APPLE__)
+            auto const fd = fd_;
+            fd_ = -1;
+            if(fd >= 0 && ::close(fd) != 0) {
+                fail("can't write file");
+            }
+#else
+            std::lock_guard lock(mutex_);
+            file_.close();
+            if(file_.fail()) {
+                throw binary_io_error("can't write file: " + filename_);
+            }
+#endif
+        }
+
+    private:
+#if defined(__unix__) || defined(__APPLE__)
+        [[noreturn]] void fail(char const* const message) const {
+            throw binary_io_error(std::string(message) + " (" + std::strerror(errno) + "): " + filename_);
+        }
+
+        int fd_ = -1;
+#else
+        mutable std::fstream file_;
+        mutable std::mutex mutex_;
+#endif
+        std::string filename_;
+    };
+
+
+}
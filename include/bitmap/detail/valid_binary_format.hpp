@@ -10,14 +10,15 @@ namespace bmp::detail {
 
     template <typename T, bool = ::bmp::pixel::is_pixel_type_v<T>>
     struct is_valid_binary_format
-        : std::bool_constant<std::is_arithmetic_v<T> && !std::is_same_v<T, long double>> {};
+        : std::bool_constant<(std::is_arithmetic_v<T> && !std::is_same_v<T, long double>) || is_half_float_v<T>> {};
 
     // clang-format off
     template <typename T>
     struct is_valid_binary_format<T, true>
-        : std::bool_constant<std::is_arithmetic_v<typename T::value_type>
+        : std::bool_constant<(std::is_arithmetic_v<typename T::value_type>
         && !std::is_same_v<typename T::value_type, long double>
-        && !std::is_same_v<typename T::value_type, bool>> {};
+        && !std::is_same_v<typename T::value_type, bool>)
+        || is_half_float_v<typename T::value_type>> {};
     // clang-format on
 
 
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__F16C__) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#    include <immintrin.h>
+#endif
+
+
+namespace bmp {
+
+
+    namespace detail {
+
+
+        /// \brief IEEE 754 binary32 to binary16 with round to nearest even
+        constexpr std::uint16_t float_to_half_bits(float const value) noexcept {
+            auto const bits = std::bit_cast<std::uint32_t>(value);
+            auto const sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+            auto const abs = bits & 0x7FFFFFFF;
+
+            if(abs >= 0x7F800000) {
+                // infinity or NaN, NaNs stay quiet NaNs
+                return static_cast<std::uint16_t>(sign | (abs > 0x7F800000 ? 0x7E00 | ((abs >> 13) & 0x3FF) : 0x7C00));
+            }
+            if(abs >= 0x477FF000) {
+                // rounds to 65520 or more
+                return static_cast<std::uint16_t>(sign | 0x7C00);
+            }
+            if(abs < 0x38800000) {
+                // subnormal result, the smallest subnormal is 2^-24
+                if(abs < 0x33000000) {
+                    return sign;
+                }
+                auto const shift = 126 - (abs >> 23);
+                auto const mantissa = (abs & 0x7FFFFF) | 0x800000;
+                auto const result = mantissa >> shift;
+                auto const rest = mantissa & ((1u << shift) - 1);
+                auto const halfway = 1u << (shift - 1);
+                auto const round_up = rest > halfway || (rest == halfway && (result & 1) != 0);
+                return static_cast<std::uint16_t>(sign | (result + (round_up ? 1 : 0)));
+            }
+
+            auto const rounded = abs + 0xFFF + ((abs >> 13) & 1);
+            return static_cast<std::uint16_t>(sign | ((rounded - 0x38000000) >> 13));
+        }
+
+        /// \brief IEEE 754 binary16 to binary32, exact
+        constexpr float half_bits_to_float(std::uint16_t const bits) noexcept {
+            auto const sign = std::uint32_t(bits & 0x8000) << 16;
+            auto const exponent = std::uint32_t(bits >> 10) & 0x1F;
+            auto const mantissa = std::uint32_t(bits) & 0x3FF;
+
+            if(exponent == 0x1F) {
+                return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+            }
+            if(exponent == 0) {
+                auto const value = static_cast<float>(mantissa) * 5.9604644775390625e-8f; // 2^-24
+                return sign != 0 ? -value : value;
+            }
+            return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+        }
+
+        /// \brief binary32 to bfloat16 with round to nearest even
+        constexpr std::uint16_t float_to_bfloat_bits(float const value) noexcept {
+            auto const bits = std::bit_cast<std::uint32_t>(value);
+            if((bits & 0x7FFFFFFF) > 0x7F800000) {
+                return static_cast<std::uint16_t>((bits >> 16) | 0x40);
+            }
+            return static_cast<std::uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+        }
+
+        constexpr float bfloat_bits_to_float(std::uint16_t const bits) noexcept {
+            return std::bit_cast<float>(std::uint32_t(bits) << 16);
+        }
+
+
+    }
+
+
+    /// \brief IEEE 754 half precision floating point channel value
+    ///
+    /// Stored as 16 bit pattern, computations convert to float. Conversions use the F16C
+    /// instructions if the compiler targets them.
+    class float16 {
+    public:
+        constexpr float16() noexcept = default;
+
+        /// \brief Round value to the nearest half precision value
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        explicit constexpr float16(T const value) noexcept
+            : bits_(from_float(static_cast<float>(value))) {}
+
+        constexpr operator float() const noexcept {
+#ifdef __F16C__
+            if(!std::is_constant_evaluated()) {
+                return _cvtsh_ss(bits_);
+            }
+#endif
+            return detail::half_bits_to_float(bits_);
+        }
+
+        /// \brief Value with the given bit pattern
+        static constexpr float16 from_bits(std::uint16_t const bits) noexcept {
+            float16 result;
+            result.bits_ = bits;
+            return result;
+        }
+
+        constexpr std::uint16_t bits() const noexcept {
+            return bits_;
+        }
+
+        /// \brief Compares the values, so NaN is unequal and +0 equals -0
+        [[nodiscard]] constexpr bool operator==(float16 const other) const noexcept {
+            return static_cast<float>(*this) == static_cast<float>(other);
+        }
+
+    private:
+        static constexpr std::uint16_t from_float(float const value) noexcept {
+#ifdef __F16C__
+            if(!std::is_constant_evaluated()) {
+                return static_cast<std::uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+            }
+#endif
+            return detail::float_to_half_bits(value);
+        }
+
+        std::uint16_t bits_ = 0;
+    };
+
+    /// \brief Brain floating point channel value, the upper half of a float
+    class bfloat16 {
+    public:
+        constexpr bfloat16() noexcept = default;
+
+        /// \brief Round value to the nearest bfloat16 value
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        explicit constexpr bfloat16(T const value) noexcept
+            : bits_(detail::float_to_bfloat_bits(static_cast<float>(value))) {}
+
+        constexpr operator float() const noexcept {
+            return detail::bfloat_bits_to_float(bits_);
+        }
+
+        /// \brief Value with the given bit pattern
+        static constexpr bfloat16 from_bits(std::uint16_t const bits) noexcept {
+            bfloat16 result;
+            result.bits_ = bits;
+            return result;
+        }
+
+        constexpr std::uint16_t bits() const noexcept {
+            return bits_;
+        }
+
+        /// \brief Compares the values, so NaN is unequal and +0 equals -0
+        [[nodiscard]] constexpr bool operator==(bfloat16 const other) const noexcept {
+            return static_cast<float>(*this) == static_cast<float>(other);
+        }
+
+    private:
+        std::uint16_t bits_ = 0;
+    };
+
+
+    template <typename T>
+    struct is_half_float: std::false_type {};
+
+    template <>
+    struct is_half_float<float16>: std::true_type {};
+
+    template <>
+    struct is_half_float<bfloat16>: std::true_type {};
+
+    /// \brief true for float16 and bfloat16
+    template <typename T>
+    constexpr bool is_half_float_v = is_half_float<T>::value;
+
+
+    namespace detail {
+
+
+        /// \brief Floating point channel types including the half precision ones
+        template <typename T>
+        constexpr bool is_floating_channel_v = std::is_floating_point_v<T> || is_half_float_v<T>;
+
+
+        namespace float16_impl {
+
+
+            inline void software_to_float(float16 const* const in, float* const out, std::size_t const count) noexcept {
+                for(std::size_t i = 0; i < count; ++i) {
+                    out[i] = half_bits_to_float(in[i].bits());
+                }
+            }
+
+            inline void software_from_float(float const* const in, float16* const out, std::size_t const count) noexcept {
+                for(std::size_t i = 0; i < count; ++i) {
+                    out[i] = float16::from_bits(float_to_half_bits(in[i]));
+                }
+            }
+
+#if defined(__F16C__) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#    define BMP_HAS_F16C 1
+
+#    ifndef __F16C__
+            __attribute__((target("avx,f16c")))
+#    endif
+            inline void
+                f16c_to_float(float16 const* const in, float* const out, std::size_t const count) noexcept {
+                std::size_t i = 0;
+                for(; i + 8 <= count; i += 8) {
+                    auto const half = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+                    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+                }
+                software_to_float(in + i, out + i, count - i);
+            }
+
+#    ifndef __F16C__
+            __attribute__((target("avx,f16c")))
+#    endif
+            inline void
+                f16c_from_float(float const* const in, float16* const out, std::size_t const count) noexcept {
+                std::size_t i = 0;
+                for(; i + 8 <= count; i += 8) {
+                    auto const half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+                }
+                software_from_float(in + i, out + i, count - i);
+            }
+
+            inline bool has_f16c() noexcept {
+#    ifdef __F16C__
+                return true;
+#    else
+                static bool const result = __builtin_cpu_supports("f16c");
+                return result;
+#    endif
+            }
+#endif
+
+
+        }
+
+
+        /// \brief Convert count half precision values to float, 8 at once with F16C
+        inline void float16_to_float(float16 const* const in, float* const out, std::size_t const count) noexcept {
+#ifdef BMP_HAS_F16C
+            if(float16_impl::has_f16c()) {
+                float16_impl::f16c_to_float(in, out, count);
+                return;
+            }
+#endif
+            float16_impl::software_to_float(in, out, count);
+        }
+
+        /// \brief Convert count floats to half precision with round to nearest even, 8 at once with F16C
+        inline void float_to_float16(float const* const in, float16* const out, std::size_t const count) noexcept {
+#ifdef BMP_HAS_F16C
+            if(float16_impl::has_f16c()) {
+                float16_impl::f16c_from_float(in, out, count);
+                return;
+            }
+#endif
+            float16_impl::software_from_float(in, out, count);
+        }
+
+
+    }
+
+
+}
+
+
+template <>
+class std::numeric_limits<bmp::float16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr bool is_iec559 = true;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = 11;
+    static constexpr int digits10 = 3;
+    static constexpr int max_digits10 = 5;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -13;
+    static constexpr int min_exponent10 = -4;
+    static constexpr int max_exponent = 16;
+    static constexpr int max_exponent10 = 4;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+
+    static constexpr bmp::float16 min() noexcept {
+        return bmp::float16::from_bits(0x0400);
+    }
+
+    static constexpr bmp::float16 lowest() noexcept {
+        return bmp::float16::from_bits(0xFBFF);
+    }
+
+    static constexpr bmp::float16 max() noexcept {
+        return bmp::float16::from_bits(0x7BFF);
+    }
+
+    static constexpr bmp::float16 epsilon() noexcept {
+        return bmp::float16::from_bits(0x1400);
+    }
+
+    static constexpr bmp::float16 round_error() noexcept {
+        return bmp::float16::from_bits(0x3800);
+    }
+
+    static constexpr bmp::float16 infinity() noexcept {
+        return bmp::float16::from_bits(0x7C00);
+    }
+
+    static constexpr bmp::float16 quiet_NaN() noexcept {
+        return bmp::float16::from_bits(0x7E00);
+    }
+
+    static constexpr bmp::float16 signaling_NaN() noexcept {
+        return bmp::float16::from_bits(0x7D00);
+    }
+
+    static constexpr bmp::float16 denorm_min() noexcept {
+        return bmp::float16::from_bits(0x0001);
+    }
+};
+
+template <>
+class std::numeric_limits<bmp::bfloat16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr bool is_iec559 = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = 8;
+    static constexpr int digits10 = 2;
+    static constexpr int max_digits10 = 4;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -125;
+    static constexpr int min_exponent10 = -37;
+    static constexpr int max_exponent = 128;
+    static constexpr int max_exponent10 = 38;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+
+    static constexpr bmp::bfloat16 min() noexcept {
+        return bmp::bfloat16::from_bits(0x0080);
+    }
+
+    static constexpr bmp::bfloat16 lowest() noexcept {
+        return bmp::bfloat16::from_bits(0xFF7F);
+    }
+
+    static constexpr bmp::bfloat16 max() noexcept {
+        return bmp::bfloat16::from_bits(0x7F7F);
+    }
+
+    static constexpr bmp::bfloat16 epsilon() noexcept {
+        return bmp::bfloat16::from_bits(0x3C00);
+    }
+
+    static constexpr bmp::bfloat16 round_error() noexcept {
+        return bmp::bfloat16::from_bits(0x3F00);
+    }
+
+    static constexpr bmp::bfloat16 infinity() noexcept {
+        return bmp::bfloat16::from_bits(0x7F80);
+    }
+
+    static constexpr bmp::bfloat16 quiet_NaN() noexcept {
+        return bmp::bfloat16::from_bits(0x7FC0);
+    }
+
+    static constexpr bmp::bfloat16 signaling_NaN() noexcept {
+        return bmp::bfloat16::from_bits(0x7FA0);
+    }
+
+    static constexpr bmp::bfloat16 denorm_min() noexcept {
+        return bmp::bfloat16::from_bits(0x0001);
+    }
+};
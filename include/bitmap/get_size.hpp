@@ -1,9 +1,12 @@
 #pragma once
 
 #include "bitmap.hpp"
+#include "size_io.hpp"
 
+#include <algorithm>
 #include <functional>
-#include <numeric>
+#include <sstream>
+#include <stdexcept>
 
 
 namespace bmp {
@@ -14,28 +17,24 @@ namespace bmp {
     size<std::size_t> get_size(std::vector<Bitmap> const& vec, GetSizeFunction&& f) {
         if(vec.empty())
             throw std::logic_error("bitmap vector is empty");
-        return std::reduce(
-            vec.cbegin() + 1,
-            vec.cend(),
-            f(*vec.cbegin()),
-            [&vec, &f](auto& ref, auto& test) {
-                if(ref == f(test))
-                    return ref;
-
-                std::ostringstream os;
-                os << "different image sizes (";
-                bool first = true;
-                for(auto& img: vec) {
-                    if(first) {
-                        first = false;
-                    } else {
-                        os << ", ";
-                    }
-                    os << f(img);
-                }
-                os << ") image";
-                throw std::logic_error(os.str());
-            });
+
+        auto const ref = f(vec.front());
+        if(std::all_of(vec.cbegin() + 1, vec.cend(), [&ref, &f](auto const& test) { return f(test) == ref; }))
+            return ref;
+
+        std::ostringstream os;
+        os << "different image sizes (";
+        bool first = true;
+        for(auto& img: vec) {
+            if(first) {
+                first = false;
+            } else {
+                os << ", ";
+            }
+            os << f(img);
+        }
+        os << ") image";
+        throw std::logic_error(os.str());
     }
 
     template <typename T>
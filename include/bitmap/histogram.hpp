@@ -1,46 +1,55 @@
 #pragma once
 
 #include "bitmap.hpp"
+#include "float16.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
 
 
 namespace bmp::detail {
 
 
-    template <typename T>
+    /// \brief Count the values for_each_value(fn) passes to fn in the bin calc_index(value)
+    template <typename T, typename ForEachValue>
     struct histogram_counter {
         std::vector<std::size_t>& histogram;
-        bitmap<T> const& image;
+        ForEachValue const& for_each_value;
         T const min;
         T const max;
 
         template <typename IndexFn>
         void operator()(IndexFn const& calc_index) noexcept {
             auto const min_check_fn = [min = min](auto const& fn) noexcept {
-                return [&fn, min](auto v) { return fn(std::max(v, min)); };
+                return [fn, min](auto v) { return fn(std::max(v, min)); };
             };
             auto const max_check_fn = [max = max](auto const& fn) noexcept {
-                return [&fn, max](auto v) { return fn(std::min(v, max)); };
+                return [fn, max](auto v) { return fn(std::min(v, max)); };
             };
             auto const minmax_check_fn = [&min_check_fn, &max_check_fn](auto const& fn) noexcept {
                 return max_check_fn(min_check_fn(fn));
             };
 
             bool need_min_check
-                = std::is_floating_point_v<T> ? true : std::numeric_limits<T>::min() < min;
+                = is_floating_channel_v<T> ? true : std::numeric_limits<T>::min() < min;
             bool need_max_check
-                = std::is_floating_point_v<T> ? true : std::numeric_limits<T>::max() > max;
+                = is_floating_channel_v<T> ? true : std::numeric_limits<T>::max() > max;
 
             auto const count = [this](auto const& calc_index) noexcept {
-                for(auto v: image) {
-                    if constexpr(std::is_floating_point_v<T>) {
+                for_each_value([this, &calc_index](T const v) noexcept {
+                    if constexpr(is_half_float_v<T>) {
+                        if(std::isnan(static_cast<float>(v)))
+                            return;
+                    } else if constexpr(std::is_floating_point_v<T>) {
                         if(std::isnan(v))
-                            continue;
+                            return;
                     }
 
                     ++histogram[calc_index(v)];
-                }
+                });
             };
 
             if(need_min_check && need_max_check) {
@@ -66,33 +75,44 @@ namespace bmp::detail {
         using type = std::make_unsigned_t<T>;
     };
 
-    template <typename T>
-    using make_diff_type_t = typename make_diff_type<T>::type;
-
-
-}
+    template <>
+    struct make_diff_type<float16, false> {
+        using type = float;
+    };
 
+    template <>
+    struct make_diff_type<bfloat16, false> {
+        using type = float;
+    };
 
-namespace bmp {
+    template <typename T>
+    using make_diff_type_t = typename make_diff_type<T>::type;
 
 
-    template <typename T>
-    std::vector<std::size_t> histogram(
-        bitmap<T> const& image,
+    /// \brief Histogram of the values for_each_value(fn) passes to fn, see bmp::histogram
+    template <typename T, typename ForEachValue>
+    std::vector<std::size_t> histogram_of_values(
+        ForEachValue const& for_each_value,
         T const min,
         T const max,
         std::size_t const bin_count,
-        bool const cumulative = false) {
+        bool const cumulative) {
         // for signed integer types diff may not fit in singed range but it
         // fits in ever in the corresponding unsigned range
-        using diff_type = detail::make_diff_type_t<T>;
+        using diff_type = make_diff_type_t<T>;
 
         auto const diff = static_cast<diff_type>(max - min);
         auto const max_index = bin_count - 1;
 
         std::vector<std::size_t> result(bin_count);
-        detail::histogram_counter<T> calc{result, image, min, max};
-        if(min == 0 && diff == max_index) {
+        histogram_counter<T, ForEachValue> calc{result, for_each_value, min, max};
+        if constexpr(is_floating_channel_v<T>) {
+            auto const scale = static_cast<diff_type>(max_index);
+            calc([min, scale, diff](auto v) noexcept {
+                auto const v0 = static_cast<diff_type>(v - min);
+                return static_cast<std::size_t>(v0 * scale / diff);
+            });
+        } else if(min == 0 && diff == max_index) {
             calc([](auto v) noexcept { return static_cast<std::size_t>(v); });
         } else {
             calc([min, max_index, diff](auto v) noexcept {
@@ -114,3 +134,29 @@ namespace bmp {
 
 
 }
+
+
+namespace bmp {
+
+
+    template <typename T>
+    std::vector<std::size_t> histogram(
+        bitmap<T> const& image,
+        T const min,
+        T const max,
+        std::size_t const bin_count,
+        bool const cumulative = false) {
+        return detail::histogram_of_values(
+            [&image](auto const& fn) {
+                for(auto const v: image) {
+                    fn(v);
+                }
+            },
+            min,
+            max,
+            bin_count,
+            cumulative);
+    }
+
+
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "rect.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Settings of an integral_image
+    struct integral_options {
+        /// \brief Also build the table of squared values for rect_square_sum and rect_variance
+        bool squares = false;
+
+        /// \brief Threads to build the tables, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Default accumulator of an integral_image of T
+        ///
+        /// 64 bit integers hold the sum of 2^40 values with 24 bit or the squares of 2^32 values
+        /// with 16 bit, so 8 and 16 bit images of any practical size can not overflow.
+        template <typename T>
+        using integral_sum_t = std::conditional_t<
+            std::is_floating_point_v<T>,
+            double,
+            std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>>;
+
+        /// \brief Minimum number of rows per thread band
+        constexpr std::size_t integral_min_band_rows = 64;
+
+        /// \brief Fill table rows [y_begin + 1, y_end + 1) with the sums of image rows [y_begin, y_end)
+        ///
+        /// The rows are summed up starting at zero, the sums of the rows above y_begin are added
+        /// later. The running row sum is sequential, the addition of the row above is a
+        /// contiguous loop the compiler vectorizes.
+        template <typename Sum, typename T, typename Fn>
+        void integral_band(
+            T const* const in,
+            Sum* const table,
+            std::size_t const w,
+            std::size_t const y_begin,
+            std::size_t const y_end,
+            Fn const& fn) noexcept {
+            auto const stride = w + 1;
+            std::vector<Sum> row(w);
+            for(auto y = y_begin; y < y_end; ++y) {
+                auto const source = in + y * w;
+                Sum sum = 0;
+                for(std::size_t x = 0; x < w; ++x) {
+                    sum += fn(source[x]);
+                    row[x] = sum;
+                }
+
+                auto const target = table + (y + 1) * stride + 1;
+                if(y == y_begin) {
+                    std::copy(row.begin(), row.end(), target);
+                } else {
+                    auto const above = target - stride;
+                    for(std::size_t x = 0; x < w; ++x) {
+                        target[x] = above[x] + row[x];
+                    }
+                }
+            }
+        }
+
+        /// \brief Build the (w + 1) x (h + 1) table of fn(value) sums, first row and column are zero
+        ///
+        /// Bands of rows are summed up in parallel, then the last row of every band is carried
+        /// into the next band.
+        template <typename Sum, typename T, typename Fn>
+        std::vector<Sum> integral_table(
+            T const* const in,
+            std::size_t const w,
+            std::size_t const h,
+            std::size_t const threads,
+            Fn const& fn) {
+            auto const stride = w + 1;
+            std::vector<Sum> table(stride * (h + 1));
+            auto const bands = std::clamp<std::size_t>(h / integral_min_band_rows, 1, thread_count(threads));
+            auto const data = table.data();
+
+            parallel_for(bands, bands, [&](std::size_t const band) {
+                integral_band(in, data, w, band_begin(band, bands, h), band_begin(band + 1, bands, h), fn);
+            });
+
+            for(std::size_t band = 1; band < bands; ++band) {
+                auto const carry = data + band_begin(band, bands, h) * stride;
+                auto const last = data + band_begin(band + 1, bands, h) * stride;
+                for(std::size_t x = 1; x < stride; ++x) {
+                    last[x] += carry[x];
+                }
+            }
+
+            parallel_for(bands - 1, bands - 1, [&](std::size_t const index) {
+                auto const band = index + 1;
+                auto const carry = data + band_begin(band, bands, h) * stride;
+                auto const end = band_begin(band + 1, bands, h);
+                for(auto y = band_begin(band, bands, h) + 1; y < end; ++y) {
+                    auto const target = data + y * stride;
+                    for(std::size_t x = 1; x < stride; ++x) {
+                        target[x] += carry[x];
+                    }
+                }
+            });
+
+            return table;
+        }
+
+
+    }
+
+
+    /// \brief Summed-area table for O(1) sums, means and variances of rectangles
+    ///
+    /// Entry (x, y) is the sum of all pixels left of x and above y, so the table has one more
+    /// row and column than the image. Sum is the accumulator type, its arithmetic must not
+    /// overflow for the sum (and the sum of squares) of all pixels, see detail::integral_sum_t.
+    /// Unsigned accumulators may wrap around in the table as long as the sums of the queried
+    /// rectangles fit.
+    template <typename T, typename Sum = detail::integral_sum_t<T>>
+    class integral_image {
+        static_assert(
+            std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+            "integral_image needs an arithmetic single channel type");
+        static_assert(std::is_arithmetic_v<Sum>, "integral_image needs an arithmetic accumulator type");
+
+    public:
+        /// \brief Type of the image values
+        using value_type = T;
+
+        /// \brief Type of the sums
+        using sum_type = Sum;
+
+        /// \brief Type of image size
+        using size_type = typename bitmap<T>::size_type;
+
+
+        /// \brief Constructs an empty table
+        integral_image() = default;
+
+        /// \brief Builds the table of sums and, if requested, of squared sums of image
+        explicit integral_image(bitmap<T> const& image, integral_options const& options = {})
+            : size_(image.size()) {
+            sums_ = detail::integral_table<Sum>(
+                image.data(), image.w(), image.h(), options.threads, [](T const v) { return static_cast<Sum>(v); });
+            if(options.squares) {
+                squares_ = detail::integral_table<Sum>(image.data(), image.w(), image.h(), options.threads, [](T const v) {
+                    auto const s = static_cast<Sum>(v);
+                    return static_cast<Sum>(s * s);
+                });
+            }
+        }
+
+
+        /// \brief Width of the image
+        std::size_t w() const noexcept {
+            return size_.w();
+        }
+
+        /// \brief Height of the image
+        std::size_t h() const noexcept {
+            return size_.h();
+        }
+
+        /// \brief Size of the image
+        size_type const size() const noexcept {
+            return size_;
+        }
+
+        /// \brief true if the image was empty
+        bool empty() const noexcept {
+            return size_.area() == 0;
+        }
+
+        /// \brief true if the table of squared sums was built
+        bool has_squares() const noexcept {
+            return !squares_.empty();
+        }
+
+
+        /// \brief Sum of all pixels left of x and above y, x <= w() and y <= h()
+        Sum operator()(std::size_t const x, std::size_t const y) const noexcept {
+            return sums_[y * (size_.w() + 1) + x];
+        }
+
+        /// \brief Sum of the pixels in rect
+        /// \throw std::out_of_range if rect is not inside of the image
+        Sum rect_sum(rect<std::size_t> const& rect) const {
+            throw_if_outside(rect);
+            return lookup(sums_, rect);
+        }
+
+        /// \brief Sum of the squared pixels in rect
+        /// \throw std::logic_error if the squares were not built
+        /// \throw std::out_of_range if rect is not inside of the image
+        Sum rect_square_sum(rect<std::size_t> const& rect) const {
+            throw_if_no_squares();
+            throw_if_outside(rect);
+            return lookup(squares_, rect);
+        }
+
+        /// \brief Mean of the pixels in rect, NaN for an empty rect
+        /// \throw std::out_of_range if rect is not inside of the image
+        double rect_mean(rect<std::size_t> const& rect) const {
+            return static_cast<double>(rect_sum(rect)) / static_cast<double>(rect.area());
+        }
+
+        /// \brief Population variance of the pixels in rect, NaN for an empty rect
+        /// \throw std::logic_error if the squares were not built
+        /// \throw std::out_of_range if rect is not inside of the image
+        double rect_variance(rect<std::size_t> const& rect) const {
+            auto const area = static_cast<double>(rect.area());
+            auto const mean = static_cast<double>(rect_sum(rect)) / area;
+            auto const square_mean = static_cast<double>(rect_square_sum(rect)) / area;
+            // cancellation can make the difference slightly negative
+            return std::max(square_mean - mean * mean, 0.0);
+        }
+
+    private:
+        Sum lookup(std::vector<Sum> const& table, rect<std::size_t> const& rect) const noexcept {
+            if(rect.area() == 0) {
+                return 0;
+            }
+
+            auto const stride = size_.w() + 1;
+            auto const top = table.data() + rect.y() * stride;
+            auto const bottom = table.data() + (rect.y() + rect.h()) * stride;
+            auto const l = rect.x();
+            auto const r = rect.x() + rect.w();
+            return static_cast<Sum>(bottom[r] - bottom[l] - top[r] + top[l]);
+        }
+
+        void throw_if_outside(rect<std::size_t> const& rect) const {
+            if(rect.x() + rect.w() > size_.w() || rect.y() + rect.h() > size_.h()) {
+                throw std::out_of_range(
+                    "integral_image: rect (" + std::to_string(rect.x()) + ", " + std::to_string(rect.y()) + ", "
+                    + std::to_string(rect.w()) + ", " + std::to_string(rect.h()) + ") is outside of "
+                    + std::to_string(size_.w()) + "x" + std::to_string(size_.h()));
+            }
+        }
+
+        void throw_if_no_squares() const {
+            if(!has_squares()) {
+                throw std::logic_error("integral_image: squares were not built, set integral_options::squares");
+            }
+        }
+
+        size_type size_;
+        std::vector<Sum> sums_;
+        std::vector<Sum> squares_;
+    };
+
+
+}
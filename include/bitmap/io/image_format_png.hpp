@@ -2,15 +2,30 @@
 
 #include <bitmap/bitmap.hpp>
 #include <bitmap/pixel.hpp>
+#include <bitmap/masked_bitmap.hpp>
 #include <bitmap/masked_pixel.hpp>
+#include <bitmap/rect.hpp>
+#include <bitmap/detail/binary_io_flags.hpp>
+#include <bitmap/detail/parallel.hpp>
 
 #include <png.h>
+#include <zlib.h>
 
-#include <limits>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
 #include <concepts>
+#include <csetjmp>
+#include <cstring>
 #include <filesystem>
-#include <iomanip>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
 
 
 namespace bmp::png{
@@ -120,74 +135,133 @@ namespace bmp::png{
     concept rgba_pixel = is_same_as_any_of<T, rgba8, rgba16>;
 
 
+    /// \brief Converts between a bitmap value and a PNG gray pixel
     template <g_pixel To>
     struct access_g{
         using target_type = To;
 
         template <typename From>
         constexpr To operator()(From const& pixel)const{
-            return To(static_cast<typename To::value_type const&>(pixel));
+            return To{static_cast<typename To::value_type>(pixel)};
         }
-    }
 
+        template <typename Into>
+        constexpr void load(To const& pixel, Into& target)const{
+            target = static_cast<Into>(pixel.g);
+        }
+    };
+
+    /// \brief Converts between a bitmap value and a PNG gray alpha pixel
+    ///
+    /// Masked pixels are mapped to an opaque alpha if valid and to a transparent one otherwise.
     template <ga_pixel To>
     struct access_ga{
         using target_type = To;
 
         template <typename From>
         constexpr To operator()(From const& pixel)const{
-            return To(
-                static_cast<typename To::value_type const&>(pixel.g),
-                static_cast<typename To::value_type const&>(pixel.a));
+            return To{
+                static_cast<typename To::value_type>(pixel.g),
+                static_cast<typename To::value_type>(pixel.a)};
         }
-    }
 
-    template <ga_pixel To> template <typename From>
-    constexpr To access_ga<To>::operator()<basic_masked_pixel<From>>(basic_masked_pixel<From> const& pixel)const{
-        return To(
-            static_cast<typename To::value_type const&>(pixel.v),
-            pixel.m ? 0 : std::numeric_limits<typename To::value_type>::max());
-    }
+        template <typename From>
+        constexpr To operator()(pixel::basic_masked_pixel<From> const& pixel)const{
+            return To{
+                static_cast<typename To::value_type>(pixel.v),
+                pixel.m ? std::numeric_limits<typename To::value_type>::max() : typename To::value_type(0)};
+        }
 
+        template <typename Into>
+        constexpr void load(To const& pixel, Into& target)const{
+            using value_type = typename Into::value_type;
+            target = Into{static_cast<value_type>(pixel.g), static_cast<value_type>(pixel.a)};
+        }
+
+        template <typename Into>
+        constexpr void load(To const& pixel, pixel::basic_masked_pixel<Into>& target)const{
+            target = {static_cast<Into>(pixel.g), pixel.a != 0};
+        }
+    };
+
+    /// \brief Converts between a bitmap value and a PNG RGB pixel
     template <rgb_pixel To>
     struct access_rgb{
         using target_type = To;
 
         template <typename From>
         constexpr To operator()(From const& pixel)const{
-            return To(
-                static_cast<typename To::value_type const&>(pixel.r),
-                static_cast<typename To::value_type const&>(pixel.g),
-                static_cast<typename To::value_type const&>(pixel.b));
+            return To{
+                static_cast<typename To::value_type>(pixel.r),
+                static_cast<typename To::value_type>(pixel.g),
+                static_cast<typename To::value_type>(pixel.b)};
         }
-    }
 
+        template <typename Into>
+        constexpr void load(To const& pixel, Into& target)const{
+            using value_type = typename Into::value_type;
+            target = Into{
+                static_cast<value_type>(pixel.r),
+                static_cast<value_type>(pixel.g),
+                static_cast<value_type>(pixel.b)};
+        }
+    };
+
+    /// \brief Converts between a bitmap value and a PNG RGBA pixel
+    ///
+    /// Masked pixels are mapped to an opaque alpha if valid and to a transparent one otherwise.
     template <rgba_pixel To>
     struct access_rgba{
         using target_type = To;
 
         template <typename From>
         constexpr To operator()(From const& pixel)const{
-            return To(
-                static_cast<typename To::value_type const&>(pixel.r),
-                static_cast<typename To::value_type const&>(pixel.g),
-                static_cast<typename To::value_type const&>(pixel.b),
-                static_cast<typename To::value_type const&>(pixel.a));
+            return To{
+                static_cast<typename To::value_type>(pixel.r),
+                static_cast<typename To::value_type>(pixel.g),
+                static_cast<typename To::value_type>(pixel.b),
+                static_cast<typename To::value_type>(pixel.a)};
         }
-    }
 
-    template <rgba_pixel To> template <typename From>
-    constexpr To access_rgba<To>::operator()<basic_masked_pixel<From>>(basic_masked_pixel<From> const& pixel)const{
-        return To(
-            static_cast<typename To::value_type const&>(pixel.v),
-            pixel.m ? 0 : std::numeric_limits<typename To::value_type>::max());
-    }
+        template <typename From>
+        constexpr To operator()(pixel::basic_masked_pixel<From> const& pixel)const{
+            return To{
+                static_cast<typename To::value_type>(pixel.v.r),
+                static_cast<typename To::value_type>(pixel.v.g),
+                static_cast<typename To::value_type>(pixel.v.b),
+                pixel.m ? std::numeric_limits<typename To::value_type>::max() : typename To::value_type(0)};
+        }
+
+        template <typename Into>
+        constexpr void load(To const& pixel, Into& target)const{
+            using value_type = typename Into::value_type;
+            target = Into{
+                static_cast<value_type>(pixel.r),
+                static_cast<value_type>(pixel.g),
+                static_cast<value_type>(pixel.b),
+                static_cast<value_type>(pixel.a)};
+        }
 
+        template <typename Into>
+        constexpr void load(To const& pixel, pixel::basic_masked_pixel<Into>& target)const{
+            using value_type = typename Into::value_type;
+            target = {
+                Into{
+                    static_cast<value_type>(pixel.r),
+                    static_cast<value_type>(pixel.g),
+                    static_cast<value_type>(pixel.b)},
+                pixel.a != 0};
+        }
+    };
 
-    struct pixel_type_not_supported_by_png;
 
+    template <typename Pixel>
+    struct pixel_type_not_supported_by_png{
+        static_assert(sizeof(Pixel) == 0, "Your value_type is not supported by bmp::png");
+    };
 
-    template <typename Pixel> inline constexpr auto pixel_access = pixel_type_not_supported_by_png{};
+
+    template <typename Pixel> inline constexpr auto pixel_access = pixel_type_not_supported_by_png<Pixel>{};
 
     template <> inline constexpr auto pixel_access<bool> = access_g<g1>{};
 
@@ -196,48 +270,662 @@ namespace bmp::png{
     template <> inline constexpr auto pixel_access<std::int16_t> = access_g<g16>{};
     template <> inline constexpr auto pixel_access<std::uint16_t> = access_g<g16>{};
 
-    template <> inline constexpr auto pixel_access<pixel::ga8> = access_ga<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::ga8u> = access_ga<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::ga16> = access_ga<g16>{};
-    template <> inline constexpr auto pixel_access<pixel::ga16u> = access_ga<g16>{};
+    template <> inline constexpr auto pixel_access<pixel::ga8> = access_ga<ga8>{};
+    template <> inline constexpr auto pixel_access<pixel::ga8u> = access_ga<ga8>{};
+    template <> inline constexpr auto pixel_access<pixel::ga16> = access_ga<ga16>{};
+    template <> inline constexpr auto pixel_access<pixel::ga16u> = access_ga<ga16>{};
+
+    template <> inline constexpr auto pixel_access<pixel::rgb8> = access_rgb<rgb8>{};
+    template <> inline constexpr auto pixel_access<pixel::rgb8u> = access_rgb<rgb8>{};
+    template <> inline constexpr auto pixel_access<pixel::rgb16> = access_rgb<rgb16>{};
+    template <> inline constexpr auto pixel_access<pixel::rgb16u> = access_rgb<rgb16>{};
+
+    template <> inline constexpr auto pixel_access<pixel::rgba8> = access_rgba<rgba8>{};
+    template <> inline constexpr auto pixel_access<pixel::rgba8u> = access_rgba<rgba8>{};
+    template <> inline constexpr auto pixel_access<pixel::rgba16> = access_rgba<rgba16>{};
+    template <> inline constexpr auto pixel_access<pixel::rgba16u> = access_rgba<rgba16>{};
+
+    template <> inline constexpr auto pixel_access<pixel::masked_g8> = access_ga<ga8>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_g8u> = access_ga<ga8>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_g16> = access_ga<ga16>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_g16u> = access_ga<ga16>{};
+
+    template <> inline constexpr auto pixel_access<pixel::masked_rgb8> = access_rgba<rgba8>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_rgb8u> = access_rgba<rgba8>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_rgb16> = access_rgba<rgba16>{};
+    template <> inline constexpr auto pixel_access<pixel::masked_rgb16u> = access_rgba<rgba16>{};
+
+
+    /// \brief PNG pixel type used for a bitmap value type
+    template <typename Pixel>
+    using png_pixel_t = typename std::remove_cvref_t<decltype(pixel_access<Pixel>)>::target_type;
+
+    /// \brief true if bitmap<Pixel> memory is exactly the PNG row layout of png_pixel_t<Pixel>
+    ///
+    /// This is the case for all supported types except bool (bit packed in PNG, std::vector<bool>
+    /// in bitmap) and masked pixels (bool mask instead of an alpha channel). Signed types share
+    /// the bit pattern of their unsigned PNG counterpart. 16 bit channels are in native byte order
+    /// and swapped by libpng on little endian machines.
+    template <typename Pixel>
+    constexpr bool is_png_layout_v = !std::is_same_v<Pixel, bool> && !pixel::is_masked_pixel_type_v<Pixel>
+        && sizeof(Pixel) == sizeof(png_pixel_t<Pixel>);
+
+
+    namespace detail{
+
+
+        /// \brief Shared libpng error handling of reader and writer
+        class png_base{
+        public:
+            png_base() = default;
 
-    template <> inline constexpr auto pixel_access<pixel::rgb8> = access_rgb<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::rgb8u> = access_rgb<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::rgb16> = access_rgb<g16>{};
-    template <> inline constexpr auto pixel_access<pixel::rgb16u> = access_rgb<g16>{};
+            png_base(png_base const&) = delete;
+            png_base& operator=(png_base const&) = delete;
 
-    template <> inline constexpr auto pixel_access<pixel::rgba8> = access_rgba<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::rgba8u> = access_rgba<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::rgba16> = access_rgba<g16>{};
-    template <> inline constexpr auto pixel_access<pixel::rgba16u> = access_rgba<g16>{};
+            /// \brief Set the callable that receives libpng error messages
+            ///
+            /// It is called from a noexcept libpng callback, so it must not throw, an exception
+            /// calls std::terminate. The failed operation returns false afterwards.
+            void on_error(std::function<void(std::string_view)> callable)noexcept{
+                error_callable_ = std::move(callable);
+            }
+
+            /// \brief Set the callable that receives libpng warning messages
+            ///
+            /// It is called from a noexcept libpng callback, so it must not throw, an exception
+            /// calls std::terminate.
+            void on_warning(std::function<void(std::string_view)> callable)noexcept{
+                warning_callable_ = std::move(callable);
+            }
+
+        protected:
+            ~png_base() = default;
+
+            void report_error(std::string_view message)const noexcept{
+                if(error_callable_){
+                    error_callable_(message);
+                }
+            }
+
+            [[noreturn]] static void error(::png_struct* main, char const* message)noexcept{
+                static_cast<png_base const*>(::png_get_error_ptr(main))->report_error(message);
+
+                // libpng requires the error handler to jump back to our routine
+                std::longjmp(png_jmpbuf(main), -1);
+            }
+
+            static void warn(::png_struct* main, char const* message)noexcept{
+                auto const& callable = static_cast<png_base const*>(::png_get_error_ptr(main))->warning_callable_;
+                if(callable){
+                    callable(std::string_view(message));
+                }
+            }
+
+            /// \brief Calls fn, returns false if libpng reported an error via longjmp
+            ///
+            /// All objects with non-trivial destructors must live outside of fn, because longjmp
+            /// does not unwind the stack.
+            template <typename Fn>
+            static bool guarded(::png_struct* main, Fn&& fn)noexcept{
+                if(setjmp(png_jmpbuf(main))){
+                    return false;
+                }
+
+                fn();
+                return true;
+            }
 
-    template <> inline constexpr auto pixel_access<pixel::masked_g8> = access_ga<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_g8u> = access_ga<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_g16> = access_ga<g16>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_g16u> = access_ga<g16>{};
+            std::function<void(std::string_view)> error_callable_;
+            std::function<void(std::string_view)> warning_callable_;
+        };
 
-    template <> inline constexpr auto pixel_access<pixel::masked_rgb8> = access_rgba<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_rgb8u> = access_rgba<g8>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_rgb16> = access_rgba<g16>{};
-    template <> inline constexpr auto pixel_access<pixel::masked_rgb16u> = access_rgba<g16>{};
+
+    }
 
 
-    class writer{
+    /// \brief Decodes PNG files row by row into bitmaps
+    ///
+    /// The PNG is converted by libpng to the layout of png_pixel_t<T> (palette expansion, bit depth
+    /// scaling, adding or stripping alpha, gray/RGB conversion) and stored directly into the rows
+    /// of the target bitmap if is_png_layout_v<T>. Otherwise a single row buffer is used. Only
+    /// interlaced images need a buffer for the requested region, because Adam7 passes are spread
+    /// over the whole image.
+    ///
+    /// If a region is requested, rows below it are not decoded at all.
+    class reader: public detail::png_base{
+    public:
+        reader() = default;
+
+        ~reader()noexcept{
+            reset();
+        }
+
+        /// \brief Read the whole image, image is resized and its memory reused if large enough
+        template <typename T>
+        bool read(bitmap<T>& image, std::filesystem::path const& filepath){
+            auto is = open(filepath);
+            return read(image, is);
+        }
+
+        /// \brief Read the pixels inside region, image is resized to region.size()
+        template <typename T>
+        bool read(bitmap<T>& image, std::filesystem::path const& filepath, rect<std::size_t> const& region){
+            auto is = open(filepath);
+            return read(image, is, region);
+        }
+
+        /// \brief Read the whole image, image is resized and its memory reused if large enough
+        template <typename T>
+        bool read(bitmap<T>& image, std::istream& is)noexcept{
+            return read_impl(image, is, nullptr);
+        }
+
+        /// \brief Read the pixels inside region, image is resized to region.size()
+        template <typename T>
+        bool read(bitmap<T>& image, std::istream& is, rect<std::size_t> const& region)noexcept{
+            return read_impl(image, is, &region);
+        }
+
+        /// \brief Read row_count full rows starting at first_row
+        template <typename T>
+        bool read_rows(bitmap<T>& image, std::istream& is, std::size_t first_row, std::size_t row_count)noexcept{
+            // width is filled in after the header is known
+            rect<std::size_t> const region(0, first_row, std::numeric_limits<std::size_t>::max(), row_count);
+            return read_impl(image, is, &region);
+        }
+
+    private:
+        static std::ifstream open(std::filesystem::path const& filepath){
+            std::ifstream is(filepath, std::ios::binary);
+            if(!is.is_open()){
+                throw std::runtime_error("can not open file \"" + filepath.string() + "\"");
+            }
+            return is;
+        }
+
+        template <typename T>
+        bool read_impl(bitmap<T>& image, std::istream& is, rect<std::size_t> const* requested_region)noexcept{
+            using pixel_type = png_pixel_t<T>;
+
+            reset();
+
+            main_ = ::png_create_read_struct(PNG_LIBPNG_VER_STRING, this, &error, &warn);
+            if(!main_){
+                report_error("failed to allocate png struct");
+                return false;
+            }
+
+            info_ = ::png_create_info_struct(main_);
+            if(!info_){
+                report_error("failed to allocate png info struct");
+                return false;
+            }
+
+            ::png_set_read_fn(main_, &is, &read_data);
+
+            bool const header_ok = guarded(main_, [this]{
+                ::png_read_info(main_, info_);
+                set_transforms<pixel_type>();
+                passes_ = ::png_set_interlace_handling(main_);
+                ::png_read_update_info(main_, info_);
+            });
+            if(!header_ok){
+                return false;
+            }
+
+            std::size_t const w = ::png_get_image_width(main_, info_);
+            std::size_t const h = ::png_get_image_height(main_, info_);
+
+            // bool is decoded like g8 and set if gray is not 0
+            using row_pixel_type = std::conditional_t<std::is_same_v<T, bool>, g8, pixel_type>;
+            if(::png_get_rowbytes(main_, info_) != w * sizeof(row_pixel_type)){
+                report_error("unexpected row size after png transformations");
+                return false;
+            }
+
+            region_ = requested_region ? *requested_region : rect<std::size_t>(w, h);
+            if(region_.w() == std::numeric_limits<std::size_t>::max()){
+                region_.set_w(w);
+            }
+
+            if(region_.x() > w || region_.w() > w - region_.x() || region_.y() > h || region_.h() > h - region_.y()){
+                report_error("requested region is outside of the png image");
+                return false;
+            }
+
+            image.resize(region_.size());
+
+            bool const interlaced = passes_ > 1;
+            bool const direct = is_png_layout_v<T> && region_.x() == 0 && region_.w() == w;
+            if(!direct){
+                buffer_.resize(w * sizeof(row_pixel_type) * (interlaced ? region_.h() : 1));
+            }
+
+            return guarded(main_, [&]{
+                auto const row = [&](std::size_t y)->::png_byte*{
+                    if(y < region_.y() || y >= region_.y() + region_.h()){
+                        return nullptr;
+                    }
+
+                    auto const ry = y - region_.y();
+                    if constexpr(is_png_layout_v<T>){
+                        if(direct){
+                            return reinterpret_cast<::png_byte*>(image.data() + ry * image.w());
+                        }
+                    }
+
+                    return buffer_.data() + (interlaced ? ry * w * sizeof(row_pixel_type) : 0);
+                };
+
+                for(int pass = 0; pass < passes_; ++pass){
+                    // rows below the region are only needed by following passes
+                    auto const end = pass + 1 < passes_ ? h : region_.y() + region_.h();
+                    for(std::size_t y = 0; y < end; ++y){
+                        auto const data = row(y);
+                        ::png_read_row(main_, data, nullptr);
+
+                        if(!direct && !interlaced && data){
+                            store<row_pixel_type>(image, data, y - region_.y());
+                        }
+                    }
+                }
+
+                if(!direct && interlaced){
+                    for(std::size_t y = 0; y < region_.h(); ++y){
+                        store<row_pixel_type>(image, buffer_.data() + y * w * sizeof(row_pixel_type), y);
+                    }
+                }
+            });
+        }
+
+        template <typename PixelType>
+        void set_transforms()noexcept{
+            auto const color_type = ::png_get_color_type(main_, info_);
+            auto const bit_depth = ::png_get_bit_depth(main_, info_);
+            bool const has_trns = ::png_get_valid(main_, info_, PNG_INFO_tRNS) != 0;
+            bool const has_alpha = (color_type & PNG_COLOR_MASK_ALPHA) != 0;
+            bool const is_color = (color_type & PNG_COLOR_MASK_COLOR) != 0;
+
+            constexpr bool want_alpha = ga_pixel<PixelType> || rgba_pixel<PixelType>;
+            constexpr bool want_color = rgb_pixel<PixelType> || rgba_pixel<PixelType>;
+            constexpr bool want_16 = PixelType::bit_depth == 16;
+
+            if(color_type == PNG_COLOR_TYPE_PALETTE){
+                ::png_set_palette_to_rgb(main_);
+            }
+
+            if(color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8){
+                ::png_set_expand_gray_1_2_4_to_8(main_);
+            }
+
+            if(has_trns && want_alpha){
+                ::png_set_tRNS_to_alpha(main_);
+            }
+
+            if constexpr(want_16){
+                if(bit_depth < 16){
+                    ::png_set_expand_16(main_);
+                }
+            }else{
+                if(bit_depth == 16){
+                    ::png_set_scale_16(main_);
+                }
+            }
+
+            if constexpr(want_alpha){
+                if(!has_alpha && !has_trns){
+                    ::png_set_add_alpha(main_, 0xFFFF, PNG_FILLER_AFTER);
+                }
+            }else{
+                if(has_alpha || (has_trns && color_type == PNG_COLOR_TYPE_PALETTE)){
+                    ::png_set_strip_alpha(main_);
+                }
+            }
+
+            if constexpr(want_color){
+                if(!is_color){
+                    ::png_set_gray_to_rgb(main_);
+                }
+            }else{
+                if(is_color || color_type == PNG_COLOR_TYPE_PALETTE){
+                    ::png_set_rgb_to_gray_fixed(main_, 1, -1, -1);
+                }
+            }
+
+            if constexpr(want_16 && std::endian::native == std::endian::little){
+                ::png_set_swap(main_);
+            }
+        }
+
+        template <typename RowPixel, typename T>
+        void store(bitmap<T>& image, ::png_byte const* data, std::size_t y)const noexcept{
+            auto const* const row = reinterpret_cast<RowPixel const*>(data) + region_.x();
+            auto target = image.begin() + static_cast<std::ptrdiff_t>(y * image.w());
+            for(std::size_t x = 0; x < image.w(); ++x, ++target){
+                if constexpr(std::is_same_v<T, bool>){
+                    *target = row[x].g != 0;
+                }else{
+                    pixel_access<T>.load(row[x], *target);
+                }
+            }
+        }
+
+        void reset()noexcept{
+            ::png_destroy_read_struct(&main_, &info_, nullptr);
+
+            main_ = nullptr;
+            info_ = nullptr;
+        }
+
+        static void read_data(::png_struct* png, ::png_byte* data, ::png_size_t length)noexcept{
+            char const* message = nullptr;
+            try{
+                auto& is = *static_cast<std::istream*>(::png_get_io_ptr(png));
+                is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(length));
+                if(!is.good()){
+                    message = "std::istream::read() failed";
+                }
+            }catch(std::exception const& e){
+                message = e.what();
+            }catch(...){
+                message = "read_data: unknown error";
+            }
+
+            if(message){
+                error(png, message);
+            }
+        }
+
+        ::png_struct* main_ = nullptr;
+        ::png_info* info_ = nullptr;
+
+        int passes_ = 1;
+        rect<std::size_t> region_;
+        std::vector<::png_byte> buffer_;
+    };
+
+
+    /// \brief Row filter applied before compression
+    enum class filter: std::uint8_t{
+        /// \brief Fastest, best for noisy images
+        none,
+        /// \brief Difference to the left pixel, cheap and good for horizontal gradients
+        sub,
+        /// \brief Difference to the pixel above, cheap and good for vertical gradients
+        up,
+        /// \brief Difference to the mean of left and above pixel
+        average,
+        /// \brief Paeth predictor, best single filter for natural images
+        paeth,
+        /// \brief libpng chooses per row from all filters, smallest files but slowest
+        adaptive
+    };
+
+    /// \brief zlib strategy used for the deflate stream
+    enum class compression_strategy: std::uint8_t{
+        /// \brief Z_DEFAULT_STRATEGY
+        standard,
+        /// \brief Z_FILTERED, libpng default for filtered rows
+        filtered,
+        /// \brief Z_HUFFMAN_ONLY, no string matching, very fast
+        huffman_only,
+        /// \brief Z_RLE, match distance 1 only, fast and good for flat regions
+        rle,
+        /// \brief Z_FIXED, no dynamic Huffman trees
+        fixed
+    };
+
+    /// \brief Encoder settings of png::writer
+    ///
+    /// Encode time is dominated by deflate. Compression levels 1 to 3 are several times faster
+    /// than the default 6 while files grow only by some percent, level 0 stores uncompressed.
+    /// filter::none or filter::up with compression_strategy::rle is usually the fastest
+    /// combination with reasonable size, filter::adaptive gives the smallest files but runs
+    /// deflate on the rows and tests all five filters per row. Adam7 interlacing costs extra
+    /// time for writing and reading and makes files larger, it is only useful for progressive
+    /// display. See benchmark/png_write.cpp.
+    struct write_options{
+        /// \brief Write an Adam7 interlaced image
+        bool interlace = false;
+
+        /// \brief zlib compression level from 0 (store) to 9 (best), -1 is the zlib default (6)
+        int compression_level = -1;
+
+        /// \brief zlib strategy
+        compression_strategy strategy = compression_strategy::filtered;
+
+        /// \brief Row filter
+        png::filter filter = png::filter::adaptive;
+
+        /// \brief Number of encoder threads, 0 means one per hardware thread
+        ///
+        /// Non interlaced images are filtered and deflated by the writer itself. With more than
+        /// one thread, they are split into row bands which are encoded independently. The bands
+        /// are joined by zlib sync flushes and the Adler-32 checksums are combined, so the result
+        /// is a single standard zlib stream. Every band is primed with the last 32 KiB of its
+        /// predecessor, so the file size is nearly the same as with one thread. Interlaced images
+        /// are always written by libpng in the calling thread.
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail{
+
+
+        /// \brief Writes a PNG chunk whose data consists of the given parts
+        inline void write_chunk(std::ostream& os, char const (&type)[5], std::initializer_list<std::span<::png_byte const>> parts){
+            std::size_t length = 0;
+            for(auto const& part: parts){
+                length += part.size();
+            }
+
+            auto const write_uint32 = [&os](std::uint32_t value){
+                value = ::bmp::detail::byteswap_on_little_endian(value);
+                os.write(reinterpret_cast<char const*>(&value), 4);
+            };
+
+            write_uint32(static_cast<std::uint32_t>(length));
+            os.write(type, 4);
+
+            auto crc = ::crc32_z(0, reinterpret_cast<::png_byte const*>(type), 4);
+            for(auto const& part: parts){
+                os.write(reinterpret_cast<char const*>(part.data()), static_cast<std::streamsize>(part.size()));
+                crc = ::crc32_z(crc, part.data(), part.size());
+            }
+
+            write_uint32(static_cast<std::uint32_t>(crc));
+        }
+
+        constexpr ::png_byte paeth_predictor(int const a, int const b, int const c)noexcept{
+            auto const p = a + b - c;
+            auto const pa = p > a ? p - a : a - p;
+            auto const pb = p > b ? p - b : b - p;
+            auto const pc = p > c ? p - c : c - p;
+            if(pa <= pb && pa <= pc){
+                return static_cast<::png_byte>(a);
+            }
+            return static_cast<::png_byte>(pb <= pc ? b : c);
+        }
+
+        /// \brief Writes filter type byte and filtered row to out, prev is nullptr for the first row
+        inline void filter_row(
+            ::png_byte const type,
+            ::png_byte const* row,
+            ::png_byte const* prev,
+            std::size_t const size,
+            std::size_t const bpp,
+            ::png_byte* out
+        )noexcept{
+            *out++ = type;
+
+            auto const left = [&](std::size_t i)->int{ return i < bpp ? 0 : row[i - bpp]; };
+            auto const up = [&](std::size_t i)->int{ return prev ? prev[i] : 0; };
+            auto const up_left = [&](std::size_t i)->int{ return prev && i >= bpp ? prev[i - bpp] : 0; };
+
+            switch(type){
+                case PNG_FILTER_VALUE_NONE:
+                    std::copy(row, row + size, out);
+                    break;
+                case PNG_FILTER_VALUE_SUB:
+                    for(std::size_t i = 0; i < size; ++i){
+                        out[i] = static_cast<::png_byte>(row[i] - left(i));
+                    }
+                    break;
+                case PNG_FILTER_VALUE_UP:
+                    for(std::size_t i = 0; i < size; ++i){
+                        out[i] = static_cast<::png_byte>(row[i] - up(i));
+                    }
+                    break;
+                case PNG_FILTER_VALUE_AVG:
+                    for(std::size_t i = 0; i < size; ++i){
+                        out[i] = static_cast<::png_byte>(row[i] - (left(i) + up(i)) / 2);
+                    }
+                    break;
+                default:
+                    for(std::size_t i = 0; i < size; ++i){
+                        out[i] = static_cast<::png_byte>(row[i] - paeth_predictor(left(i), up(i), up_left(i)));
+                    }
+                    break;
+            }
+        }
+
+        /// \brief Filters a row, filter::adaptive selects the type with the smallest sum of
+        ///        absolute signed bytes like libpng does
+        inline void filter_row(
+            png::filter const filter,
+            ::png_byte const* row,
+            ::png_byte const* prev,
+            std::size_t const size,
+            std::size_t const bpp,
+            ::png_byte* out,
+            ::png_byte* candidate
+        )noexcept{
+            if(filter != png::filter::adaptive){
+                filter_row(static_cast<::png_byte>(filter), row, prev, size, bpp, out);
+                return;
+            }
+
+            auto const cost = [size](::png_byte const* data){
+                std::size_t sum = 0;
+                for(std::size_t i = 1; i <= size; ++i){
+                    sum += static_cast<std::size_t>(std::abs(static_cast<int>(static_cast<std::int8_t>(data[i]))));
+                }
+                return sum;
+            };
+
+            filter_row(PNG_FILTER_VALUE_NONE, row, prev, size, bpp, out);
+            auto best = cost(out);
+            for(::png_byte type = PNG_FILTER_VALUE_SUB; type <= PNG_FILTER_VALUE_PAETH; ++type){
+                filter_row(type, row, prev, size, bpp, candidate);
+                if(auto const c = cost(candidate); c < best){
+                    best = c;
+                    std::copy(candidate, candidate + size + 1, out);
+                }
+            }
+        }
+
+
+        /// \brief Buffers and deflate state of one row band of the encoder
+        ///
+        /// Kept by png::writer between images, so writing many images of equal size and type
+        /// does not allocate.
+        class deflate_band{
+        public:
+            deflate_band() = default;
+
+            deflate_band(deflate_band const&) = delete;
+            deflate_band& operator=(deflate_band const&) = delete;
+
+            ~deflate_band()noexcept{
+                if(initialized_){
+                    ::deflateEnd(&stream);
+                }
+            }
+
+            /// \brief Prepare a new raw deflate stream, the zlib state is reused if possible
+            void start(int const level, int const strategy){
+                if(initialized_ && level == level_ && strategy == strategy_ && ::deflateReset(&stream) == Z_OK){
+                    return;
+                }
+
+                if(initialized_){
+                    ::deflateEnd(&stream);
+                    initialized_ = false;
+                }
+
+                stream = {};
+                if(::deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy) != Z_OK){
+                    throw std::runtime_error("deflateInit2 failed");
+                }
+
+                initialized_ = true;
+                level_ = level;
+                strategy_ = strategy;
+            }
+
+            ::z_stream stream{};
+
+            std::vector<::png_byte> convert;
+            std::vector<::png_byte> raw[2];
+            std::vector<::png_byte> filtered;
+            std::vector<::png_byte> candidate;
+            std::vector<::png_byte> dictionary;
+
+            /// \brief Compressed band
+            std::vector<::png_byte> data;
+
+            /// \brief Adler-32 of the uncompressed band
+            ::uLong adler = 0;
+
+            /// \brief Size of the uncompressed band
+            std::size_t length = 0;
+
+        private:
+            bool initialized_ = false;
+            int level_ = 0;
+            int strategy_ = 0;
+        };
+
+
+    }
+
+
+    /// \brief Encodes bitmaps as PNG files
+    ///
+    /// A writer keeps its conversion buffers and deflate states between calls. Use one writer
+    /// for a sequence of images to avoid allocations if image size and pixel type do not change.
+    /// libpng itself can not reuse its structs, they are recreated for every interlaced image.
+    class writer: public detail::png_base{
     public:
         writer() = default;
 
-        writer(writer const&) = delete;
-        writer& operator=(writer const&) = delete;
+        explicit writer(write_options const& options)
+            : options_(options) {}
+
+        /// \brief Settings used for following writes
+        void set_options(write_options const& options)noexcept{
+            options_ = options;
+        }
+
+        /// \brief Settings used for following writes
+        write_options const& options()const noexcept{
+            return options_;
+        }
 
         ~writer()noexcept{
             reset();
         }
 
+        /// \brief Encoder states of the row bands, kept for following writes
+        std::span<std::unique_ptr<detail::deflate_band> const> bands()const noexcept{
+            return bands_;
+        }
+
         template <typename T>
         bool write(bitmap<T> const& image, std::filesystem::path const& filepath){
             std::ofstream os(filepath, std::ios::binary);
-            if(!os.open()){
-                throw std::runtime_error(std::format("can not open file {:s}", std::quoted(filepath.string())));
+            if(!os.is_open()){
+                throw std::runtime_error("can not open file \"" + filepath.string() + "\"");
             }
 
             return write(image, os);
@@ -246,138 +934,432 @@ namespace bmp::png{
         template <typename T>
         bool write(bitmap<T> const& image, std::ostream& os)noexcept{
             static constexpr auto max_size = static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max());
-            if(image.h() > max_size || image.h() > max_size){
-                if(error_callable_){
-                    error_callable_("dimensions are to large for PNG file format"sv);
-                }
+            if(image.w() > max_size || image.h() > max_size){
+                report_error("dimensions are to large for PNG file format");
+                return false;
+            }
+
+            if(options_.compression_level < -1 || options_.compression_level > 9){
+                report_error("compression level must be in range -1 to 9");
                 return false;
             }
 
+            using pixel_type = png_pixel_t<T>;
+
+            if(!options_.interlace){
+                try{
+                    return write_bands(image, os);
+                }catch(std::exception const& e){
+                    report_error(e.what());
+                    return false;
+                }
+            }
+
             reset();
 
             main_ = ::png_create_write_struct(PNG_LIBPNG_VER_STRING, this, &error, &warn);
             if(!main_){
-                if(error_callable_){
-                    error_callable_("failed to allocate png struct"sv);
-                }
+                report_error("failed to allocate png struct");
                 return false;
             }
 
             info_ = ::png_create_info_struct(main_);
             if(!info_){
-                if(error_callable_){
-                    error_callable_("failed to allocate png info struct"sv);
-                }
+                report_error("failed to allocate png info struct");
                 return false;
             }
 
-            // libpng will jump to this condition if an error occurs
-            if(std::setjmp(::png_jmpbuf(main_))){
-                return false;
+            auto const w = image.w();
+            auto const h = image.h();
+
+            // layout compatible types are passed directly, all others are converted row by row
+            if constexpr(!is_png_layout_v<T>){
+                row_buffer_.resize(w * sizeof(pixel_type));
             }
 
             ::png_set_write_fn(main_, &os, &write_data, &flush_data);
 
-            auto const w = image.w_as<std::int32_t>()
-            auto const h = image.h_as<std::int32_t>()
+            return guarded(main_, [&]{
+                ::png_set_IHDR(main_, info_, static_cast<::png_uint_32>(w), static_cast<::png_uint_32>(h),
+                    pixel_type::bit_depth, pixel_type::channels,
+                    options_.interlace ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                    PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+                ::png_set_compression_level(main_, options_.compression_level);
+                ::png_set_compression_strategy(main_, zlib_strategy(options_.strategy));
+                ::png_set_filter(main_, PNG_FILTER_TYPE_BASE, filter_flags(options_.filter));
 
-            using pixel_type = pixel_access<T>::target_type;
-            ::png_set_IHDR(main_, info_, w, h, pixel_type::bit_depth, pixel_type::channels,
-                PNG_INTERLACE_ADAM7, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT)
+                ::png_write_info(main_, info_);
 
-            // TODO: Implement some direct access instead of copy for types which support this
-            std::vector<pixel_type> data;
-            data.reserve(image.point_count());
-            std::ranges::transform(image, std::back_inserter(data),
-                [](T const& v){
-                    return pixel_access<T>(v);
-                });
+                if constexpr(pixel_type::bit_depth == 1){
+                    ::png_set_packing(main_);
+                }
+                if constexpr(pixel_type::bit_depth == 16 && std::endian::native == std::endian::little){
+                    ::png_set_swap(main_);
+                }
 
-            std::vector<pixel_type const*> rows;
-            rows.reserve(h);
-            for(std::size_t y = 0; y < h; ++y){
-                rows.push_back(&data[y * w]);
+                auto const passes = ::png_set_interlace_handling(main_);
+                for(int pass = 0; pass < passes; ++pass){
+                    for(std::size_t y = 0; y < h; ++y){
+                        ::png_write_row(main_, row(image, y, row_buffer_));
+                    }
+                }
+
+                ::png_write_end(main_, nullptr);
+            });
+        }
+
+    private:
+        /// \brief Encoder for non interlaced images, see write_options::threads
+        ///
+        /// A single thread encodes the whole image as one band.
+        template <typename T>
+        bool write_bands(bitmap<T> const& image, std::ostream& os){
+            using pixel_type = png_pixel_t<T>;
+
+            if(image.empty()){
+                report_error("PNG images must not be empty");
+                return false;
+            }
+
+            auto const w = image.w();
+            auto const h = image.h();
+            auto const bpp = pixel_type::bit_depth == 1 ? std::size_t(1) : sizeof(pixel_type);
+            auto const row_size = pixel_type::bit_depth == 1 ? (w + 7) / 8 : w * sizeof(pixel_type);
+
+            // deflate window size, every band is primed with this much data of its predecessor
+            constexpr std::size_t window_size = 32768;
+            constexpr std::size_t min_band_size = 4 * window_size;
+            auto const band_count = std::clamp<std::size_t>(
+                row_size * h / min_band_size, 1, std::min(h, ::bmp::detail::thread_count(options_.threads)));
+
+            while(bands_.size() < band_count){
+                bands_.push_back(std::make_unique<detail::deflate_band>());
+            }
+
+            auto const strategy = zlib_strategy(options_.strategy);
+            ::bmp::detail::parallel_for(band_count, options_.threads, [&](std::size_t const index){
+                auto const begin = ::bmp::detail::band_begin(index, band_count, h);
+                auto const end = ::bmp::detail::band_begin(index + 1, band_count, h);
+
+                auto& band = *bands_[index];
+                auto& raw = band.raw;
+                auto& filtered = band.filtered;
+                auto& candidate = band.candidate;
+                auto& dictionary = band.dictionary;
+                auto& stream = band.stream;
+
+                if constexpr(!is_png_layout_v<T>){
+                    band.convert.resize(w * sizeof(pixel_type));
+                }
+                raw[0].resize(row_size);
+                raw[1].resize(row_size);
+                filtered.resize(row_size + 1);
+                candidate.resize(row_size + 1);
+
+                auto const raw_row = [&](std::size_t y, std::vector<::png_byte>& out){
+                    auto const* const data = row(image, y, band.convert);
+                    if constexpr(pixel_type::bit_depth == 1){
+                        std::fill(out.begin(), out.end(), ::png_byte(0));
+                        for(std::size_t x = 0; x < w; ++x){
+                            if(data[x] != 0){
+                                out[x / 8] |= static_cast<::png_byte>(0x80 >> (x % 8));
+                            }
+                        }
+                    }else{
+                        std::copy(data, data + row_size, out.begin());
+                        if constexpr(pixel_type::bit_depth == 16 && std::endian::native == std::endian::little){
+                            for(std::size_t i = 0; i < row_size; i += 2){
+                                std::swap(out[i], out[i + 1]);
+                            }
+                        }
+                    }
+                };
+
+                band.start(options_.compression_level, strategy);
+
+                band.adler = ::adler32_z(0, nullptr, 0);
+                band.length = (end - begin) * (row_size + 1);
+                band.data.resize(::deflateBound(&stream, static_cast<::uLong>(band.length)) + 16);
+
+                // prime with the filtered rows in front of the band
+                auto const prime_begin = begin - std::min(begin, window_size / (row_size + 1) + 1);
+                if(prime_begin > 0){
+                    raw_row(prime_begin - 1, raw[(prime_begin - 1) % 2]);
+                }
+
+                dictionary.clear();
+                for(auto y = prime_begin; y < begin; ++y){
+                    raw_row(y, raw[y % 2]);
+                    detail::filter_row(options_.filter, raw[y % 2].data(), y > 0 ? raw[(y + 1) % 2].data() : nullptr,
+                        row_size, bpp, filtered.data(), candidate.data());
+                    dictionary.insert(dictionary.end(), filtered.begin(), filtered.end());
+                }
+
+                if(!dictionary.empty()){
+                    auto const size = std::min(dictionary.size(), window_size);
+                    ::deflateSetDictionary(&stream, dictionary.data() + dictionary.size() - size, static_cast<::uInt>(size));
+                }
+
+                stream.next_out = band.data.data();
+                stream.avail_out = static_cast<::uInt>(band.data.size());
+
+                for(auto y = begin; y < end; ++y){
+                    raw_row(y, raw[y % 2]);
+                    detail::filter_row(options_.filter, raw[y % 2].data(), y > 0 ? raw[(y + 1) % 2].data() : nullptr,
+                        row_size, bpp, filtered.data(), candidate.data());
+                    band.adler = ::adler32_z(band.adler, filtered.data(), filtered.size());
+
+                    auto const last = y + 1 == end;
+                    stream.next_in = filtered.data();
+                    stream.avail_in = static_cast<::uInt>(filtered.size());
+                    auto const flush = !last ? Z_NO_FLUSH : index + 1 == band_count ? Z_FINISH : Z_SYNC_FLUSH;
+                    auto const ret = ::deflate(&stream, flush);
+                    if(ret == Z_STREAM_ERROR || stream.avail_in != 0 || (flush == Z_FINISH && ret != Z_STREAM_END)){
+                        throw std::runtime_error("deflate failed");
+                    }
+                }
+
+                band.data.resize(band.data.size() - stream.avail_out);
+            });
+
+            // zlib header: deflate with 32 KiB window, compression level hint and check bits
+            auto const level = options_.compression_level;
+            auto const level_hint = level == 0 || level == 1 ? 0 : level >= 2 && level <= 5 ? 1 : level == 6 || level == -1 ? 2 : 3;
+            ::png_byte const cmf = 0x78;
+            auto flg = static_cast<::png_byte>(level_hint << 6);
+            flg = static_cast<::png_byte>(flg + 31 - (cmf * 256 + flg) % 31);
+            std::array<::png_byte, 2> const zlib_header{cmf, flg};
+
+            auto adler = bands_[0]->adler;
+            for(std::size_t i = 1; i < band_count; ++i){
+                adler = ::adler32_combine(adler, bands_[i]->adler, static_cast<::z_off_t>(bands_[i]->length));
+            }
+            auto const adler_bytes = std::bit_cast<std::array<::png_byte, 4>>(
+                ::bmp::detail::byteswap_on_little_endian(static_cast<std::uint32_t>(adler)));
+
+            std::array<::png_byte, 13> header{};
+            auto const w_bytes = std::bit_cast<std::array<::png_byte, 4>>(
+                ::bmp::detail::byteswap_on_little_endian(static_cast<std::uint32_t>(w)));
+            auto const h_bytes = std::bit_cast<std::array<::png_byte, 4>>(
+                ::bmp::detail::byteswap_on_little_endian(static_cast<std::uint32_t>(h)));
+            std::copy(w_bytes.begin(), w_bytes.end(), header.begin());
+            std::copy(h_bytes.begin(), h_bytes.end(), header.begin() + 4);
+            header[8] = pixel_type::bit_depth;
+            header[9] = pixel_type::channels;
+
+            static constexpr std::array<::png_byte, 8> signature{137, 80, 78, 71, 13, 10, 26, 10};
+            os.write(reinterpret_cast<char const*>(signature.data()), signature.size());
+            detail::write_chunk(os, "IHDR", {header});
+
+            // chunks are limited to 2^31 - 1 bytes
+            constexpr std::size_t max_chunk_size = std::size_t(1) << 30;
+            for(std::size_t i = 0; i < band_count; ++i){
+                std::span<::png_byte const> data(bands_[i]->data);
+                do{
+                    auto const part = data.first(std::min(data.size(), max_chunk_size));
+                    data = data.subspan(part.size());
+                    auto const first = i == 0 && part.data() == bands_[i]->data.data();
+                    auto const last = i + 1 == band_count && data.empty();
+                    detail::write_chunk(os, "IDAT", {
+                        std::span<::png_byte const>(zlib_header).first(first ? 2 : 0),
+                        part,
+                        std::span<::png_byte const>(adler_bytes).first(last ? 4 : 0)});
+                }while(!data.empty());
             }
 
-            ::png_set_rows(main_, info_, rows.data());
+            detail::write_chunk(os, "IEND", {});
 
-            ::png_write_png(main_, info_, PNG_TRANSFORM_IDENTITY, nullptr);
+            if(!os.good()){
+                report_error("std::ostream::write() failed");
+                return false;
+            }
 
             return true;
         }
 
-        void on_error(std::function<void(std::string_view)noexcept> callable)noexcept{
-            error_callable_ = std::move(callable);
+        static constexpr int zlib_strategy(compression_strategy strategy)noexcept{
+            switch(strategy){
+                case compression_strategy::standard: return Z_DEFAULT_STRATEGY;
+                case compression_strategy::filtered: return Z_FILTERED;
+                case compression_strategy::huffman_only: return Z_HUFFMAN_ONLY;
+                case compression_strategy::rle: return Z_RLE;
+                case compression_strategy::fixed: return Z_FIXED;
+            }
+            return Z_DEFAULT_STRATEGY;
         }
 
-        void on_warning(std::function<void(std::string_view)noexcept> callable)noexcept{
-            warning_callable_ = std::move(callable);
+        static constexpr int filter_flags(png::filter filter)noexcept{
+            switch(filter){
+                case png::filter::none: return PNG_FILTER_NONE;
+                case png::filter::sub: return PNG_FILTER_SUB;
+                case png::filter::up: return PNG_FILTER_UP;
+                case png::filter::average: return PNG_FILTER_AVG;
+                case png::filter::paeth: return PNG_FILTER_PAETH;
+                case png::filter::adaptive: return PNG_ALL_FILTERS;
+            }
+            return PNG_ALL_FILTERS;
         }
 
-    private:
-        void reset(){
-            png_destroy_write_struct(&main_, &info_);
+        /// \brief Pointer to the PNG row y, converted into buffer if necessary
+        ///
+        /// buffer must have a size of image.w() * sizeof(png_pixel_t<T>)
+        template <typename T>
+        static ::png_byte const* row(bitmap<T> const& image, std::size_t y, std::vector<::png_byte>& buffer)noexcept{
+            if constexpr(is_png_layout_v<T>){
+                return reinterpret_cast<::png_byte const*>(image.data() + y * image.w());
+            }else{
+                using pixel_type = png_pixel_t<T>;
+                auto out = buffer.data();
+                auto const begin = image.begin() + static_cast<std::ptrdiff_t>(y * image.w());
+                for(auto iter = begin; iter != begin + image.sw(); ++iter, out += sizeof(pixel_type)){
+                    auto const pixel = pixel_access<T>(*iter);
+                    std::memcpy(out, &pixel, sizeof(pixel));
+                }
+                return buffer.data();
+            }
+        }
+
+        void reset()noexcept{
+            ::png_destroy_write_struct(&main_, &info_);
 
             main_ = nullptr;
             info_ = nullptr;
         }
 
-        static [[noreturn]] void error(::png_struct* main, char const* message)noexcept{
-            auto const& callable = static_cast<writer const*>(::png_get_error_ptr(main))->error_callable_;
-            if(callable){
-                callable(std::string_view(message));
+        static void write_data(::png_struct* png, ::png_byte* data, ::png_size_t length)noexcept{
+            char const* message = nullptr;
+            try{
+                auto& os = *static_cast<std::ostream*>(::png_get_io_ptr(png));
+                os.write(reinterpret_cast<char*>(data), static_cast<std::streamsize>(length));
+                if(!os.good()){
+                    message = "std::ostream::write() failed";
+                }
+            }catch(std::exception const& e){
+                message = e.what();
+            }catch(...){
+                message = "write_data: unknown error";
             }
 
-            // libpng requires the error handler to jump back to our write routine
-            std::longjmp(::png_jmpbuf(main), -1);
-        }
-
-        static void warn(::png_struct* main, char const* message)noexcept{
-            auto const& callable = static_cast<writer const*>(::png_get_error_ptr(main))->warning_callable_;
-            if(callable){
-                callable(std::string_view(message));
+            if(message){
+                error(png, message);
             }
         }
 
-        static void write_data(::png_struct* png, ::png_byte* data, ::png_size_t length)noexcept try{
-            auto& os = *static_cast<std::ostream*>(::png_get_io_ptr(png));
-            os.write(reinterpret_cast<char*>(data), length);
-            if(!os.good()){
-                error(png, "std::ostream::write() failed");
+        static void flush_data(png_struct* png)noexcept{
+            char const* message = nullptr;
+            try{
+                auto& os = *static_cast<std::ostream*>(::png_get_io_ptr(png));
+                os.flush();
+                if(!os.good()){
+                    message = "std::ostream::flush() failed";
+                }
+            }catch(std::exception const& e){
+                message = e.what();
+            }catch(...){
+                message = "flush_data: unknown error";
             }
-        }catch(std::exception const& error){
-            error(png, error.what());
-        }catch(...){
-            error(png, "write_data: unknown error");
-        }
 
-        static void flush_data(png_struct* png)noexcept try{
-            auto& os = *static_cast<std::ostream*>(::png_get_io_ptr(png));
-            os.flush();
-            if(!os.good()){
-                error(png, "std::ostream::flush() failed");
+            if(message){
+                error(png, message);
             }
-        }catch(std::exception const& error){
-            error(png, error.what());
-        }catch(...){
-            error(png, "flush_data: unknown error");
         }
 
         ::png_struct* main_ = nullptr;
         ::png_info* info_ = nullptr;
 
-        std::function<void(std::string_view)> error_callable_;
-        std::function<void(std::string_view)> warning_callable_;
+        write_options options_;
+
+        std::vector<::png_byte> row_buffer_;
+        std::vector<std::unique_ptr<detail::deflate_band>> bands_;
     };
 
     template <typename T>
-    bool write(bitmap<T> const& image, std::ostream& os)noexcept{
-        return writer{}.write(image, os);
+    bool write(bitmap<T> const& image, std::ostream& os, write_options const& options = {})noexcept{
+        return writer{options}.write(image, os);
+    }
+
+    template <typename T>
+    bool write(bitmap<T> const& image, std::filesystem::path const& filepath, write_options const& options = {}){
+        return writer{options}.write(image, filepath);
+    }
+
+    namespace detail{
+
+
+        /// \brief Gray alpha or RGBA pixel that stores a masked value with its validity as alpha
+        template <typename T>
+        struct masked_png_pixel{
+            using type = pixel::basic_ga<std::make_unsigned_t<T>>;
+        };
+
+        template <typename T>
+        struct masked_png_pixel<pixel::basic_rgb<T>>{
+            using type = pixel::basic_rgba<std::make_unsigned_t<T>>;
+        };
+
+        /// \brief Values of a masked_bitmap with opaque alpha for valid and transparent alpha for invalid points
+        template <typename T>
+        auto masked_to_alpha(masked_bitmap<T> const& image){
+            using pixel_type = typename masked_png_pixel<T>::type;
+            using value_type = typename pixel_type::value_type;
+            constexpr auto opaque = std::numeric_limits<value_type>::max();
+
+            bitmap<pixel_type> result(image.size());
+            for(std::size_t y = 0; y < image.h(); ++y){
+                auto const in = image.values().data() + y * image.w();
+                auto const out = result.data() + y * image.w();
+                auto const bits = image.mask().row(y);
+                for(std::size_t x = 0; x < image.w(); ++x){
+                    auto const valid = (bits[x / bitmask::word_bits] >> (x % bitmask::word_bits)) & 1;
+                    auto const alpha = valid ? opaque : value_type(0);
+                    if constexpr(std::is_arithmetic_v<T>){
+                        out[x] = {static_cast<value_type>(in[x]), alpha};
+                    }else{
+                        out[x] = {
+                            static_cast<value_type>(in[x].r),
+                            static_cast<value_type>(in[x].g),
+                            static_cast<value_type>(in[x].b),
+                            alpha};
+                    }
+                }
+            }
+            return result;
+        }
+
+
+    }
+
+    /// \brief Write a masked_bitmap as gray alpha or RGBA, invalid points get a transparent alpha
+    template <typename T>
+    bool write(masked_bitmap<T> const& image, std::ostream& os, write_options const& options = {}){
+        return writer{options}.write(detail::masked_to_alpha(image), os);
+    }
+
+    /// \brief Write a masked_bitmap as gray alpha or RGBA, invalid points get a transparent alpha
+    template <typename T>
+    bool write(masked_bitmap<T> const& image, std::filesystem::path const& filepath, write_options const& options = {}){
+        return writer{options}.write(detail::masked_to_alpha(image), filepath);
+    }
+
+    template <typename T>
+    bool read(bitmap<T>& image, std::istream& is)noexcept{
+        return reader{}.read(image, is);
+    }
+
+    template <typename T>
+    bool read(bitmap<T>& image, std::filesystem::path const& filepath){
+        return reader{}.read(image, filepath);
+    }
+
+    template <typename T>
+    bool read(bitmap<T>& image, std::istream& is, rect<std::size_t> const& region)noexcept{
+        return reader{}.read(image, is, region);
     }
 
     template <typename T>
-    bool write(bitmap<T> const& image, std::filesystem::path const& filepath){
-        return writer{}.write(image, filepath);
+    bool read(bitmap<T>& image, std::filesystem::path const& filepath, rect<std::size_t> const& region){
+        return reader{}.read(image, filepath, region);
     }
 
 
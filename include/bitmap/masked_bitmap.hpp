@@ -0,0 +1,251 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "bitmask.hpp"
+#include "histogram.hpp"
+#include "masked_pixel.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief A bitmap of masked values that stores values and validity separately
+    ///
+    /// The values are a dense bitmap<T>, the validity is a bitmask with one bit per point. A
+    /// bitmap<pixel::basic_masked_pixel<T>> needs sizeof(T) + 1 bytes plus padding per point,
+    /// this needs sizeof(T) bytes and one bit. Values of invalid points are kept but have no
+    /// meaning.
+    template <typename T>
+    class masked_bitmap {
+    public:
+        /// \brief Type of the values
+        using value_type = T;
+
+        /// \brief Type of a single point with its validity
+        using pixel_type = pixel::basic_masked_pixel<T>;
+
+        /// \brief Type of bitmap size
+        using size_type = typename bitmap<T>::size_type;
+
+
+        /// \brief Constructs a blank bitmap
+        masked_bitmap() = default;
+
+        /// \brief Constructs a bitmap with size, initialize all points with value and validity
+        masked_bitmap(size_type const& size, value_type const& value = value_type(), bool const valid = false)
+            : values_(size, value)
+            , mask_(size, valid) {}
+
+        /// \brief Constructs a bitmap with size w and h, initialize all points with value and validity
+        masked_bitmap(
+            std::size_t const w,
+            std::size_t const h,
+            value_type const& value = value_type(),
+            bool const valid = false)
+            : masked_bitmap(size_type(w, h), value, valid) {}
+
+        /// \brief Constructs a bitmap from values and their validity
+        /// \throw std::invalid_argument if the sizes differ
+        masked_bitmap(bitmap<value_type> values, bitmask mask)
+            : values_(std::move(values))
+            , mask_(std::move(mask)) {
+            if(values_.size() != mask_.size()) {
+                throw std::invalid_argument("masked_bitmap: values and mask have different sizes");
+            }
+        }
+
+        /// \brief Constructs a bitmap from masked pixels
+        explicit masked_bitmap(bitmap<pixel_type> const& image);
+
+
+        /// \brief Resize values and mask
+        /// \attention All pointers and iterators to the data become invalid
+        void resize(size_type const& size, value_type const& value = value_type(), bool const valid = false) {
+            values_.resize(size, value);
+            mask_.resize(size, valid);
+        }
+
+        /// \brief Resize values and mask
+        /// \attention All pointers and iterators to the data become invalid
+        void resize(
+            std::size_t const w,
+            std::size_t const h,
+            value_type const& value = value_type(),
+            bool const valid = false) {
+            resize(size_type(w, h), value, valid);
+        }
+
+        /// \brief Resize to zero
+        void clear() noexcept {
+            values_.clear();
+            mask_.clear();
+        }
+
+
+        /// \brief Get the width
+        std::size_t w() const {
+            return values_.w();
+        }
+
+        /// \brief Get the height
+        std::size_t h() const {
+            return values_.h();
+        }
+
+        /// \brief Get the size
+        size_type const size() const {
+            return values_.size();
+        }
+
+        /// \brief Get the number of points in the bitmap
+        std::size_t point_count() const {
+            return values_.point_count();
+        }
+
+        /// \brief true if image is empty, false otherwise
+        bool empty() const {
+            return values_.empty();
+        }
+
+
+        /// \brief Get the values
+        /// \attention Resizing the values breaks the masked_bitmap
+        bitmap<value_type>& values() noexcept {
+            return values_;
+        }
+
+        /// \brief Get the values
+        bitmap<value_type> const& values() const noexcept {
+            return values_;
+        }
+
+        /// \brief Get the validity of all points
+        /// \attention Resizing the mask breaks the masked_bitmap
+        bitmask& mask() noexcept {
+            return mask_;
+        }
+
+        /// \brief Get the validity of all points
+        bitmask const& mask() const noexcept {
+            return mask_;
+        }
+
+
+        /// \brief Get the point by local coordinates
+        pixel_type operator()(std::size_t const x, std::size_t const y) const {
+            return {values_(x, y), mask_(x, y)};
+        }
+
+        /// \brief Set the point by local coordinates
+        void set(std::size_t const x, std::size_t const y, pixel_type const& value) {
+            values_(x, y) = value.v;
+            mask_.set(x, y, value.m);
+        }
+
+        /// \brief true if the point is valid
+        bool is_valid(std::size_t const x, std::size_t const y) const noexcept {
+            return mask_(x, y);
+        }
+
+        [[nodiscard]] bool operator==(masked_bitmap const&) const = default;
+
+    private:
+        bitmap<value_type> values_;
+        bitmask mask_;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Call fn(x, y) for every set bit of mask in row major order
+        ///
+        /// Empty words are skipped at once, so sparse masks are cheap.
+        template <typename Fn>
+        void for_each_set_bit(bitmask const& mask, Fn&& fn) {
+            for(std::size_t y = 0; y < mask.h(); ++y) {
+                auto const row = mask.row(y);
+                for(std::size_t i = 0; i < mask.words_per_row(); ++i) {
+                    auto word = row[i];
+                    while(word != 0) {
+                        auto const bit = static_cast<std::size_t>(std::countr_zero(word));
+                        fn(i * bitmask::word_bits + bit, y);
+                        word &= word - 1;
+                    }
+                }
+            }
+        }
+
+
+    }
+
+
+    /// \brief Split masked pixels into values and mask
+    template <typename T>
+    masked_bitmap<T> separate_mask(bitmap<pixel::basic_masked_pixel<T>> const& image) {
+        bitmap<T> values(image.size());
+        bitmask mask(image.size());
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            auto const in = image.data() + y * image.w();
+            auto const out = values.data() + y * image.w();
+            auto const bits = mask.row(y);
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                out[x] = in[x].v;
+                bits[x / bitmask::word_bits] |= bitmask::word_type(in[x].m) << (x % bitmask::word_bits);
+            }
+        }
+        return {std::move(values), std::move(mask)};
+    }
+
+    /// \brief Merge values and mask into masked pixels
+    template <typename T>
+    bitmap<pixel::basic_masked_pixel<T>> combine_mask(masked_bitmap<T> const& image) {
+        bitmap<pixel::basic_masked_pixel<T>> result(image.size());
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            auto const in = image.values().data() + y * image.w();
+            auto const out = result.data() + y * image.w();
+            auto const bits = image.mask().row(y);
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                out[x] = {in[x], ((bits[x / bitmask::word_bits] >> (x % bitmask::word_bits)) & 1) != 0};
+            }
+        }
+        return result;
+    }
+
+    template <typename T>
+    masked_bitmap<T>::masked_bitmap(bitmap<pixel_type> const& image)
+        : masked_bitmap(separate_mask(image)) {}
+
+
+    /// \brief Histogram of the valid points, see histogram of a bitmap
+    ///
+    /// Values are clamped to min and max, NaN values are ignored.
+    template <typename T>
+    std::vector<std::size_t> histogram(
+        masked_bitmap<T> const& image,
+        T const min,
+        T const max,
+        std::size_t const bin_count,
+        bool const cumulative = false) {
+        auto const values = image.values().data();
+        auto const w = image.w();
+        return detail::histogram_of_values(
+            [&image, values, w](auto const& fn) {
+                detail::for_each_set_bit(image.mask(), [&fn, values, w](std::size_t const x, std::size_t const y) {
+                    fn(values[y * w + x]);
+                });
+            },
+            min,
+            max,
+            bin_count,
+            cumulative);
+    }
+
+
+}
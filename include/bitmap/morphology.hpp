@@ -0,0 +1,480 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "bitmask.hpp"
+#include "pixel.hpp"
+#include "pixel_algorithm.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Settings of the morphology operators
+    struct morphology_options {
+        /// \brief Threads for every pass, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Rows per band of the horizontal pass, a band is the unit of work of a thread
+        constexpr std::size_t morphology_band_rows = 16;
+
+        /// \brief Values per column strip of the vertical pass
+        constexpr std::size_t morphology_strip_values = 256;
+
+        /// \brief Minimum of two pixels, channel by channel for multi channel pixels
+        struct morphology_min {
+            template <typename T>
+            constexpr T operator()(T const& l, T const& r) const noexcept {
+                using pixel::min;
+                using std::min;
+                return min(l, r);
+            }
+        };
+
+        /// \brief Maximum of two pixels, channel by channel for multi channel pixels
+        struct morphology_max {
+            template <typename T>
+            constexpr T operator()(T const& l, T const& r) const noexcept {
+                using pixel::max;
+                using std::max;
+                return max(l, r);
+            }
+        };
+
+        /// \brief Running min or max of 2 * radius + 1 values along every row
+        ///
+        /// van Herk/Gil-Werman: the padded row is split into blocks of the window size, a
+        /// window is the suffix of one block combined with the prefix of the next, so every
+        /// value costs three operations independent of radius. Borders repeat the edge pixels.
+        template <typename T, typename Op>
+        void morphology_horizontal(
+            T const* const in,
+            T* const out,
+            std::size_t const w,
+            std::size_t const h,
+            std::size_t const radius,
+            Op const op,
+            std::size_t const threads) {
+            auto const size = 2 * radius + 1;
+            auto const n = w + 2 * radius;
+            auto const bands = (h + morphology_band_rows - 1) / morphology_band_rows;
+            parallel_for(bands, threads, [&](std::size_t const band) {
+                std::vector<T> line(n);
+                std::vector<T> suffix(n);
+                auto const y_end = std::min(h, (band + 1) * morphology_band_rows);
+                for(auto y = band * morphology_band_rows; y < y_end; ++y) {
+                    auto const row = in + y * w;
+                    std::fill(line.begin(), line.begin() + static_cast<std::ptrdiff_t>(radius), row[0]);
+                    std::copy(row, row + w, line.begin() + static_cast<std::ptrdiff_t>(radius));
+                    std::fill(line.end() - static_cast<std::ptrdiff_t>(radius), line.end(), row[w - 1]);
+
+                    suffix[n - 1] = line[n - 1];
+                    for(auto i = n - 1; i-- > 0;) {
+                        suffix[i] = (i + 1) % size == 0 ? line[i] : op(line[i], suffix[i + 1]);
+                    }
+
+                    auto const target = out + y * w;
+                    T prefix = line[0];
+                    for(std::size_t i = 0; i < n; ++i) {
+                        prefix = i % size == 0 ? line[i] : op(prefix, line[i]);
+                        if(i + 1 >= size) {
+                            target[i + 1 - size] = op(suffix[i + 1 - size], prefix);
+                        }
+                    }
+                }
+            });
+        }
+
+        /// \brief Running min or max of 2 * radius + 1 rows in every column
+        ///
+        /// van Herk/Gil-Werman as in morphology_horizontal, but every step combines whole row
+        /// segments of a column strip, so the inner loops are contiguous and vectorize. V are
+        /// channel values or bitmask words, op works elementwise on them.
+        template <typename V, typename Op>
+        void morphology_vertical(
+            V const* const in,
+            V* const out,
+            std::size_t const row_values,
+            std::size_t const h,
+            std::size_t const radius,
+            Op const op,
+            std::size_t const threads) {
+            auto const size = 2 * radius + 1;
+            auto const n = h + 2 * radius;
+            auto const strips = (row_values + morphology_strip_values - 1) / morphology_strip_values;
+            parallel_for(strips, threads, [&](std::size_t const strip) {
+                auto const begin = strip * morphology_strip_values;
+                auto const width = std::min(row_values, begin + morphology_strip_values) - begin;
+                auto const row = [&](std::size_t const i) {
+                    auto const y = std::clamp<std::ptrdiff_t>(
+                        static_cast<std::ptrdiff_t>(i) - static_cast<std::ptrdiff_t>(radius),
+                        0,
+                        static_cast<std::ptrdiff_t>(h) - 1);
+                    return in + static_cast<std::size_t>(y) * row_values + begin;
+                };
+
+                std::vector<V> suffix(n * width);
+                std::copy(row(n - 1), row(n - 1) + width, suffix.begin() + static_cast<std::ptrdiff_t>((n - 1) * width));
+                for(auto i = n - 1; i-- > 0;) {
+                    auto const source = row(i);
+                    auto const target = suffix.data() + i * width;
+                    if((i + 1) % size == 0) {
+                        std::copy(source, source + width, target);
+                    } else {
+                        auto const next = target + width;
+                        for(std::size_t x = 0; x < width; ++x) {
+                            target[x] = op(source[x], next[x]);
+                        }
+                    }
+                }
+
+                std::vector<V> prefix(width);
+                for(std::size_t i = 0; i < n; ++i) {
+                    auto const source = row(i);
+                    if(i % size == 0) {
+                        std::copy(source, source + width, prefix.begin());
+                    } else {
+                        for(std::size_t x = 0; x < width; ++x) {
+                            prefix[x] = op(prefix[x], source[x]);
+                        }
+                    }
+
+                    if(i + 1 >= size) {
+                        auto const y = i + 1 - size;
+                        auto const first = suffix.data() + y * width;
+                        auto const target = out + y * row_values + begin;
+                        for(std::size_t x = 0; x < width; ++x) {
+                            target[x] = op(first[x], prefix[x]);
+                        }
+                    }
+                }
+            });
+        }
+
+        /// \brief Erosion or dilation with a (2 * radius_x + 1) x (2 * radius_y + 1) rectangle
+        template <typename T, typename Op>
+        bitmap<T> morphology(
+            bitmap<T> const& image,
+            std::size_t const radius_x,
+            std::size_t const radius_y,
+            Op const op,
+            morphology_options const& options) {
+            using value_type = pixel::channel_type_t<T>;
+            constexpr auto channels = pixel::channel_count_v<T>;
+            static_assert(
+                std::is_arithmetic_v<value_type> && !std::is_same_v<value_type, bool>,
+                "morphology needs arithmetic channel types, use a bitmask for binary images");
+            static_assert(sizeof(T) == sizeof(value_type) * channels);
+
+            if(image.empty() || (radius_x == 0 && radius_y == 0)) {
+                return image;
+            }
+
+            bitmap<T> horizontal;
+            auto source = image.data();
+            if(radius_x != 0) {
+                horizontal = bitmap<T>(image.size());
+                morphology_horizontal(image.data(), horizontal.data(), image.w(), image.h(), radius_x, op, options.threads);
+                if(radius_y == 0) {
+                    return horizontal;
+                }
+                source = horizontal.data();
+            }
+
+            bitmap<T> result(image.size());
+            morphology_vertical(
+                reinterpret_cast<value_type const*>(source),
+                reinterpret_cast<value_type*>(result.data()),
+                image.w() * channels,
+                image.h(),
+                radius_y,
+                op,
+                options.threads);
+            return result;
+        }
+
+
+        /// \brief out bit x is in bit x + shift, bits behind the row are zero
+        inline void bitmask_shift_down(
+            bitmask::word_type const* const in,
+            bitmask::word_type* const out,
+            std::size_t const words,
+            std::size_t const shift) noexcept {
+            auto const word_shift = shift / bitmask::word_bits;
+            auto const bit_shift = shift % bitmask::word_bits;
+            for(std::size_t i = 0; i < words; ++i) {
+                auto const low = i + word_shift < words ? in[i + word_shift] : 0;
+                auto const high = i + word_shift + 1 < words ? in[i + word_shift + 1] : 0;
+                out[i] = bit_shift == 0 ? low : (low >> bit_shift) | (high << (bitmask::word_bits - bit_shift));
+            }
+        }
+
+        /// \brief out bit x is in bit x - shift, bits before the row are zero
+        inline void bitmask_shift_up(
+            bitmask::word_type const* const in,
+            bitmask::word_type* const out,
+            std::size_t const words,
+            std::size_t const shift) noexcept {
+            auto const word_shift = shift / bitmask::word_bits;
+            auto const bit_shift = shift % bitmask::word_bits;
+            for(std::size_t i = 0; i < words; ++i) {
+                auto const high = i >= word_shift ? in[i - word_shift] : 0;
+                auto const low = i >= word_shift + 1 ? in[i - word_shift - 1] : 0;
+                out[i] = bit_shift == 0 ? high : (high << bit_shift) | (low >> (bitmask::word_bits - bit_shift));
+            }
+        }
+
+        /// \brief OR of size neighboring bits in one direction by doubling shifts
+        ///
+        /// After step s every bit holds the OR of 2^s bits, so size bits need log2(size)
+        /// passes over the row, 64 bits at a time.
+        template <typename Shift>
+        void bitmask_window(
+            bitmask::word_type* const row,
+            bitmask::word_type* const scratch,
+            std::size_t const words,
+            std::size_t const size,
+            Shift const shift) noexcept {
+            std::size_t covered = 1;
+            auto const combine = [&](std::size_t const distance) {
+                shift(row, scratch, words, distance);
+                for(std::size_t i = 0; i < words; ++i) {
+                    row[i] |= scratch[i];
+                }
+            };
+            for(; covered * 2 <= size; covered *= 2) {
+                combine(covered);
+            }
+            if(covered < size) {
+                combine(size - covered);
+            }
+        }
+
+        /// \brief Clear the bits behind width w in the last word of a row
+        inline void bitmask_clear_tail(bitmask::word_type* const row, std::size_t const words, std::size_t const w) noexcept {
+            auto const tail = w % bitmask::word_bits;
+            if(words != 0 && tail != 0) {
+                row[words - 1] &= (bitmask::word_type(1) << tail) - 1;
+            }
+        }
+
+        /// \brief Dilation or erosion of every row with 2 * radius + 1 bits
+        ///
+        /// Erosion is the complement of the dilation of the complement, bits outside of the
+        /// row never remove a bit.
+        inline void bitmask_horizontal(
+            bitmask const& in,
+            bitmask& out,
+            std::size_t const radius,
+            bool const erode,
+            std::size_t const threads) {
+            auto const words = in.words_per_row();
+            auto const bands = (in.h() + morphology_band_rows - 1) / morphology_band_rows;
+            parallel_for(bands, threads, [&](std::size_t const band) {
+                std::vector<bitmask::word_type> scratch(words);
+                auto const y_end = std::min(in.h(), (band + 1) * morphology_band_rows);
+                for(auto y = band * morphology_band_rows; y < y_end; ++y) {
+                    auto const source = in.row(y);
+                    auto const target = out.row(y);
+                    for(std::size_t i = 0; i < words; ++i) {
+                        target[i] = erode ? ~source[i] : source[i];
+                    }
+                    bitmask_clear_tail(target, words, in.w());
+
+                    bitmask_window(target, scratch.data(), words, radius + 1, bitmask_shift_down);
+                    bitmask_window(target, scratch.data(), words, radius + 1, bitmask_shift_up);
+
+                    if(erode) {
+                        for(std::size_t i = 0; i < words; ++i) {
+                            target[i] = ~target[i];
+                        }
+                    }
+                    bitmask_clear_tail(target, words, in.w());
+                }
+            });
+        }
+
+        /// \brief Erosion or dilation of a bitmask with a (2 * radius_x + 1) x (2 * radius_y + 1) rectangle
+        inline bitmask bitmask_morphology(
+            bitmask const& mask,
+            std::size_t const radius_x,
+            std::size_t const radius_y,
+            bool const erode,
+            morphology_options const& options) {
+            if(mask.empty() || (radius_x == 0 && radius_y == 0)) {
+                return mask;
+            }
+
+            bitmask horizontal;
+            if(radius_x != 0) {
+                horizontal = bitmask(mask.size());
+                bitmask_horizontal(mask, horizontal, radius_x, erode, options.threads);
+                if(radius_y == 0) {
+                    return horizontal;
+                }
+            }
+
+            auto const& source = radius_x != 0 ? horizontal : mask;
+            bitmask result(mask.size());
+            if(erode) {
+                morphology_vertical(
+                    source.data(), result.data(), mask.words_per_row(), mask.h(), radius_y,
+                    std::bit_and<bitmask::word_type>{}, options.threads);
+            } else {
+                morphology_vertical(
+                    source.data(), result.data(), mask.words_per_row(), mask.h(), radius_y,
+                    std::bit_or<bitmask::word_type>{}, options.threads);
+            }
+            return result;
+        }
+
+
+    }
+
+
+    /// \brief Minimum of the (2 * radius_x + 1) x (2 * radius_y + 1) pixels around every pixel
+    ///
+    /// Multi channel pixels use pixel::min channel by channel. The cost does not depend on the
+    /// radii, see detail::morphology_horizontal. Pixels outside of the image are ignored.
+    template <typename T>
+    bitmap<T> erode(
+        bitmap<T> const& image,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return detail::morphology(image, radius_x, radius_y, detail::morphology_min{}, options);
+    }
+
+    /// \brief Minimum of the (2 * radius + 1)^2 pixels around every pixel
+    template <typename T>
+    bitmap<T> erode(bitmap<T> const& image, std::size_t const radius, morphology_options const& options = {}) {
+        return erode(image, radius, radius, options);
+    }
+
+    /// \brief Maximum of the (2 * radius_x + 1) x (2 * radius_y + 1) pixels around every pixel
+    ///
+    /// Multi channel pixels use pixel::max channel by channel. The cost does not depend on the
+    /// radii, see detail::morphology_horizontal. Pixels outside of the image are ignored.
+    template <typename T>
+    bitmap<T> dilate(
+        bitmap<T> const& image,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return detail::morphology(image, radius_x, radius_y, detail::morphology_max{}, options);
+    }
+
+    /// \brief Maximum of the (2 * radius + 1)^2 pixels around every pixel
+    template <typename T>
+    bitmap<T> dilate(bitmap<T> const& image, std::size_t const radius, morphology_options const& options = {}) {
+        return dilate(image, radius, radius, options);
+    }
+
+    /// \brief Dilation of the erosion, removes bright structures smaller than the rectangle
+    template <typename T>
+    bitmap<T> opening(
+        bitmap<T> const& image,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return dilate(erode(image, radius_x, radius_y, options), radius_x, radius_y, options);
+    }
+
+    /// \brief Dilation of the erosion with a (2 * radius + 1)^2 square
+    template <typename T>
+    bitmap<T> opening(bitmap<T> const& image, std::size_t const radius, morphology_options const& options = {}) {
+        return opening(image, radius, radius, options);
+    }
+
+    /// \brief Erosion of the dilation, removes dark structures smaller than the rectangle
+    template <typename T>
+    bitmap<T> closing(
+        bitmap<T> const& image,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return erode(dilate(image, radius_x, radius_y, options), radius_x, radius_y, options);
+    }
+
+    /// \brief Erosion of the dilation with a (2 * radius + 1)^2 square
+    template <typename T>
+    bitmap<T> closing(bitmap<T> const& image, std::size_t const radius, morphology_options const& options = {}) {
+        return closing(image, radius, radius, options);
+    }
+
+
+    /// \brief A bit stays set if all bits in the (2 * radius_x + 1) x (2 * radius_y + 1) rectangle around it are set
+    ///
+    /// Rows are processed 64 bits per word with log2(radius_x) shifts, columns with the van
+    /// Herk/Gil-Werman algorithm on whole words. Bits outside of the mask are ignored.
+    inline bitmask erode(
+        bitmask const& mask,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return detail::bitmask_morphology(mask, radius_x, radius_y, true, options);
+    }
+
+    /// \brief A bit stays set if all bits in the (2 * radius + 1)^2 square around it are set
+    inline bitmask erode(bitmask const& mask, std::size_t const radius, morphology_options const& options = {}) {
+        return erode(mask, radius, radius, options);
+    }
+
+    /// \brief A bit is set if any bit in the (2 * radius_x + 1) x (2 * radius_y + 1) rectangle around it is set
+    ///
+    /// See erode of a bitmask.
+    inline bitmask dilate(
+        bitmask const& mask,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return detail::bitmask_morphology(mask, radius_x, radius_y, false, options);
+    }
+
+    /// \brief A bit is set if any bit in the (2 * radius + 1)^2 square around it is set
+    inline bitmask dilate(bitmask const& mask, std::size_t const radius, morphology_options const& options = {}) {
+        return dilate(mask, radius, radius, options);
+    }
+
+    /// \brief Dilation of the erosion, removes set regions smaller than the rectangle
+    inline bitmask opening(
+        bitmask const& mask,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return dilate(erode(mask, radius_x, radius_y, options), radius_x, radius_y, options);
+    }
+
+    /// \brief Dilation of the erosion with a (2 * radius + 1)^2 square
+    inline bitmask opening(bitmask const& mask, std::size_t const radius, morphology_options const& options = {}) {
+        return opening(mask, radius, radius, options);
+    }
+
+    /// \brief Erosion of the dilation, fills gaps smaller than the rectangle
+    inline bitmask closing(
+        bitmask const& mask,
+        std::size_t const radius_x,
+        std::size_t const radius_y,
+        morphology_options const& options = {}) {
+        return erode(dilate(mask, radius_x, radius_y, options), radius_x, radius_y, options);
+    }
+
+    /// \brief Erosion of the dilation with a (2 * radius + 1)^2 square
+    inline bitmask closing(bitmask const& mask, std::size_t const radius, morphology_options const& options = {}) {
+        return closing(mask, radius, radius, options);
+    }
+
+
+}
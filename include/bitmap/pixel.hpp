@@ -1,5 +1,7 @@
 #pragma once
 
+#include "float16.hpp"
+
 #include <cstdint>
 #include <utility>
 
@@ -40,6 +42,8 @@ namespace bmp::pixel {
     using ga16u = basic_ga<std::uint16_t>;
     using ga32u = basic_ga<std::uint32_t>;
     using ga64u = basic_ga<std::uint64_t>;
+    using ga16f = basic_ga<float16>;
+    using ga16bf = basic_ga<bfloat16>;
     using ga32f = basic_ga<float>;
     using ga64f = basic_ga<double>;
 
@@ -78,6 +82,8 @@ namespace bmp::pixel {
     using rgb16u = basic_rgb<std::uint16_t>;
     using rgb32u = basic_rgb<std::uint32_t>;
     using rgb64u = basic_rgb<std::uint64_t>;
+    using rgb16f = basic_rgb<float16>;
+    using rgb16bf = basic_rgb<bfloat16>;
     using rgb32f = basic_rgb<float>;
     using rgb64f = basic_rgb<double>;
 
@@ -117,6 +123,8 @@ namespace bmp::pixel {
     using rgba16u = basic_rgba<std::uint16_t>;
     using rgba32u = basic_rgba<std::uint32_t>;
     using rgba64u = basic_rgba<std::uint64_t>;
+    using rgba16f = basic_rgba<float16>;
+    using rgba16bf = basic_rgba<bfloat16>;
     using rgba32f = basic_rgba<float>;
     using rgba64f = basic_rgba<double>;
 
@@ -35,7 +35,7 @@ namespace bmp::pixel {
     template <typename T>
     constexpr basic_rgba<T> min(basic_rgba<T> const& l, basic_rgba<T> const& r) noexcept {
         using std::min;
-        return {min(l.r, r.r), max(l.g, r.g), max(l.b, r.b), max(l.a, r.a)};
+        return {min(l.r, r.r), min(l.g, r.g), min(l.b, r.b), min(l.a, r.a)};
     }
 
     template <typename T>
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "histogram.hpp"
+#include "pixel.hpp"
+#include "subbitmap.hpp"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief A bitmap of multi channel pixels that stores every channel in its own plane
+    ///
+    /// Every plane is a bitmap of the channel type, so a single channel can be used with all
+    /// bitmap algorithms without copying it.
+    /// \tparam Pixel A pixel type like pixel::rgb8u
+    template <typename Pixel>
+    class planar_bitmap {
+    public:
+        static_assert(pixel::is_pixel_type_v<Pixel>, "planar_bitmap needs a multi channel pixel type");
+
+        /// \brief Type of the pixels
+        using pixel_type = Pixel;
+
+        /// \brief Type of the channel values
+        using value_type = pixel::channel_type_t<Pixel>;
+
+        /// \brief Type of a single plane
+        using plane_type = bitmap<value_type>;
+
+        /// \brief Type of bitmap size
+        using size_type = typename plane_type::size_type;
+
+        /// \brief Number of planes
+        static constexpr std::size_t channel_count = pixel::channel_count_v<Pixel>;
+
+
+        /// \brief Constructs a blank bitmap
+        planar_bitmap() = default;
+
+        /// \brief Constructs a bitmap with size, initialize all pixels with value
+        planar_bitmap(size_type const& size, pixel_type const& value = pixel_type()) {
+            resize(size, value);
+        }
+
+        /// \brief Constructs a bitmap with size w and h, initialize all pixels with value
+        planar_bitmap(std::size_t const w, std::size_t const h, pixel_type const& value = pixel_type())
+            : planar_bitmap(size_type(w, h), value) {}
+
+        /// \brief Constructs the planes of an interleaved bitmap
+        explicit planar_bitmap(bitmap<pixel_type> const& interleaved);
+
+
+        /// \brief Resize all planes
+        /// \attention All pointers and iterators to the data become invalid
+        void resize(size_type const& size, pixel_type const& value = pixel_type()) {
+            for(std::size_t c = 0; c < channel_count; ++c) {
+                planes_[c].resize(size, channel(value, c));
+            }
+        }
+
+        /// \brief Resize all planes
+        /// \attention All pointers and iterators to the data become invalid
+        void resize(std::size_t const w, std::size_t const h, pixel_type const& value = pixel_type()) {
+            resize(size_type(w, h), value);
+        }
+
+        /// \brief Resize to zero
+        void clear() noexcept {
+            for(auto& plane: planes_) {
+                plane.clear();
+            }
+        }
+
+
+        /// \brief Get the width
+        std::size_t w() const {
+            return planes_[0].w();
+        }
+
+        /// \brief Get the height
+        std::size_t h() const {
+            return planes_[0].h();
+        }
+
+        /// \brief Get the size
+        size_type const size() const {
+            return planes_[0].size();
+        }
+
+        /// \brief Get the number of points in the bitmap
+        std::size_t point_count() const {
+            return planes_[0].point_count();
+        }
+
+        /// \brief true if image is empty, false otherwise
+        bool empty() const {
+            return planes_[0].empty();
+        }
+
+
+        /// \brief Get the plane of channel c
+        /// \attention Resizing a single plane breaks the planar_bitmap
+        /// \throw std::out_of_range
+        plane_type& plane(std::size_t const c) {
+            throw_if_out_of_range(c);
+            return planes_[c];
+        }
+
+        /// \brief Get the plane of channel c
+        /// \throw std::out_of_range
+        plane_type const& plane(std::size_t const c) const {
+            throw_if_out_of_range(c);
+            return planes_[c];
+        }
+
+        /// \brief Get all planes
+        /// \attention Resizing a single plane breaks the planar_bitmap
+        std::array<plane_type, channel_count>& planes() noexcept {
+            return planes_;
+        }
+
+        /// \brief Get all planes
+        std::array<plane_type, channel_count> const& planes() const noexcept {
+            return planes_;
+        }
+
+
+        /// \brief Get the pixel by local coordinates
+        pixel_type operator()(std::size_t const x, std::size_t const y) const {
+            pixel_type result;
+            for(std::size_t c = 0; c < channel_count; ++c) {
+                channel(result, c) = planes_[c](x, y);
+            }
+            return result;
+        }
+
+        /// \brief Set the pixel by local coordinates
+        void set(std::size_t const x, std::size_t const y, pixel_type const& value) {
+            for(std::size_t c = 0; c < channel_count; ++c) {
+                planes_[c](x, y) = channel(value, c);
+            }
+        }
+
+        [[nodiscard]] bool operator==(planar_bitmap const&) const = default;
+
+
+        /// \brief Channel c of a pixel
+        static value_type& channel(pixel_type& value, std::size_t const c) noexcept {
+            return *(reinterpret_cast<value_type*>(&value) + c);
+        }
+
+        /// \brief Channel c of a pixel
+        static value_type const& channel(pixel_type const& value, std::size_t const c) noexcept {
+            return *(reinterpret_cast<value_type const*>(&value) + c);
+        }
+
+    private:
+        void throw_if_out_of_range(std::size_t const c) const {
+            if(c >= channel_count) {
+                throw std::out_of_range(
+                    "planar_bitmap: channel " + std::to_string(c) + " is outside of " + std::to_string(channel_count)
+                    + " channels");
+            }
+        }
+
+        std::array<plane_type, channel_count> planes_;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Split count interleaved pixels into N planes
+        ///
+        /// N is a compile time constant, so the compiler turns the inner loop into vector shuffles.
+        template <std::size_t N, typename V>
+        void deinterleave(V const* const in, std::array<V*, N> const& out, std::size_t const count) noexcept {
+            for(std::size_t i = 0; i < count; ++i) {
+                for(std::size_t c = 0; c < N; ++c) {
+                    out[c][i] = in[i * N + c];
+                }
+            }
+        }
+
+        /// \brief Merge N planes into count interleaved pixels
+        template <std::size_t N, typename V>
+        void interleave(std::array<V const*, N> const& in, V* const out, std::size_t const count) noexcept {
+            for(std::size_t i = 0; i < count; ++i) {
+                for(std::size_t c = 0; c < N; ++c) {
+                    out[i * N + c] = in[c][i];
+                }
+            }
+        }
+
+
+    }
+
+
+    /// \brief Split an interleaved bitmap into planes
+    template <typename Pixel>
+    planar_bitmap<Pixel> deinterleave(bitmap<Pixel> const& image) {
+        using value_type = pixel::channel_type_t<Pixel>;
+        constexpr auto channels = pixel::channel_count_v<Pixel>;
+        static_assert(sizeof(Pixel) == sizeof(value_type) * channels);
+
+        planar_bitmap<Pixel> result;
+        std::array<value_type*, channels> out;
+        for(std::size_t c = 0; c < channels; ++c) {
+            auto& plane = result.plane(c);
+            plane.resize(image.size());
+            out[c] = plane.data();
+        }
+
+        detail::deinterleave(reinterpret_cast<value_type const*>(image.data()), out, image.point_count());
+        return result;
+    }
+
+    /// \brief Merge the planes into an interleaved bitmap
+    template <typename Pixel>
+    bitmap<Pixel> interleave(planar_bitmap<Pixel> const& image) {
+        using value_type = pixel::channel_type_t<Pixel>;
+        constexpr auto channels = pixel::channel_count_v<Pixel>;
+        static_assert(sizeof(Pixel) == sizeof(value_type) * channels);
+
+        bitmap<Pixel> result(image.size());
+        std::array<value_type const*, channels> in;
+        for(std::size_t c = 0; c < channels; ++c) {
+            in[c] = image.plane(c).data();
+        }
+
+        detail::interleave(in, reinterpret_cast<value_type*>(result.data()), image.point_count());
+        return result;
+    }
+
+    template <typename Pixel>
+    planar_bitmap<Pixel>::planar_bitmap(bitmap<pixel_type> const& interleaved)
+        : planar_bitmap(deinterleave(interleaved)) {}
+
+
+    /// \brief Return the pixels in rect as new planar bitmap, throw if out of range
+    template <typename Pixel, typename XT, typename YT, typename WT, typename HT>
+    planar_bitmap<Pixel> subbitmap(planar_bitmap<Pixel> const& org, rect<XT, YT, WT, HT> const& rect) {
+        planar_bitmap<Pixel> result;
+        for(std::size_t c = 0; c < planar_bitmap<Pixel>::channel_count; ++c) {
+            result.plane(c) = subbitmap(org.plane(c), rect);
+        }
+        return result;
+    }
+
+
+    /// \brief Histogram of every channel, see histogram of a bitmap
+    template <typename Pixel>
+    std::array<std::vector<std::size_t>, pixel::channel_count_v<Pixel>> histogram(
+        planar_bitmap<Pixel> const& image,
+        pixel::channel_type_t<Pixel> const min,
+        pixel::channel_type_t<Pixel> const max,
+        std::size_t const bin_count,
+        bool const cumulative = false) {
+        std::array<std::vector<std::size_t>, pixel::channel_count_v<Pixel>> result;
+        for(std::size_t c = 0; c < result.size(); ++c) {
+            result[c] = histogram(image.plane(c), min, max, bin_count, cumulative);
+        }
+        return result;
+    }
+
+
+}
@@ -0,0 +1,386 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "float16.hpp"
+#include "pixel.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Filter applied before every 2x decimation of a pyramid
+    enum class pyramid_filter : std::uint8_t {
+        /// \brief Average of 2x2 pixels
+        box,
+
+        /// \brief Separable 5 tap binomial kernel 1 4 6 4 1 / 16, an approximated Gaussian
+        gaussian
+    };
+
+    /// \brief Settings of a pyramid
+    struct pyramid_options {
+        pyramid_filter filter = pyramid_filter::box;
+
+        /// \brief Maximum number of levels including the full resolution, 0 means down to 1x1
+        std::size_t levels = 0;
+
+        /// \brief Threads for every level, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief true for 64 bit integers, their box sums are split into quotients and remainders
+        template <typename V>
+        constexpr bool is_pyramid_wide_v = std::is_integral_v<V> && sizeof(V) == 8;
+
+        /// \brief Type to sum up filter weighted channel values of V without overflow
+        template <typename V>
+        using pyramid_accumulator_t = std::conditional_t<
+            is_floating_channel_v<V>,
+            std::conditional_t<std::is_same_v<V, double>, double, float>,
+            std::conditional_t<sizeof(V) <= 2, std::int32_t, std::int64_t>>;
+
+        /// \brief Output rows per band, a band is the unit of work of a thread
+        constexpr std::size_t pyramid_band_rows = 32;
+
+        /// \brief Sum divided by 2^Shift, rounded for integral V
+        template <typename V, unsigned Shift, typename A>
+        V pyramid_normalize(A const sum) noexcept {
+            if constexpr(is_floating_channel_v<V>) {
+                return static_cast<V>(sum * (A(1) / A(1 << Shift)));
+            } else {
+                return static_cast<V>((sum + (A(1) << (Shift - 1))) >> Shift);
+            }
+        }
+
+        /// \brief One output row of the 2x2 box filter
+        ///
+        /// The vertical sum is a contiguous loop over all channels, the horizontal one reads
+        /// column 2x and 2x + 1. Odd widths and heights repeat the last column and row.
+        template <typename V, std::size_t C>
+        void pyramid_box_row(
+            V const* const row0,
+            V const* const row1,
+            pyramid_accumulator_t<V>* const sum,
+            V* const out,
+            std::size_t const w,
+            std::size_t const out_w) noexcept {
+            using accumulator = pyramid_accumulator_t<V>;
+
+            if constexpr(is_pyramid_wide_v<V>) {
+                // floor(v / 4) and v % 4 summed separately, so four 64 bit values can't overflow
+                static_cast<void>(sum);
+                for(std::size_t x = 0; x < out_w; ++x) {
+                    auto const x0 = 2 * x * C;
+                    auto const x1 = std::min(2 * x + 1, w - 1) * C;
+                    for(std::size_t c = 0; c < C; ++c) {
+                        V const values[4] = {row0[x0 + c], row0[x1 + c], row1[x0 + c], row1[x1 + c]};
+                        V quotient = 0;
+                        V remainder = 0;
+                        for(auto const v: values) {
+                            quotient += v >> 2;
+                            remainder += v & 3;
+                        }
+                        out[x * C + c] = static_cast<V>(quotient + ((remainder + 2) >> 2));
+                    }
+                }
+                return;
+            }
+
+            for(std::size_t i = 0; i < w * C; ++i) {
+                sum[i] = static_cast<accumulator>(row0[i]) + static_cast<accumulator>(row1[i]);
+            }
+
+            auto const pairs = w / 2;
+            for(std::size_t x = 0; x < pairs; ++x) {
+                for(std::size_t c = 0; c < C; ++c) {
+                    out[x * C + c] = pyramid_normalize<V, 2>(sum[2 * x * C + c] + sum[(2 * x + 1) * C + c]);
+                }
+            }
+            if(pairs < out_w) {
+                for(std::size_t c = 0; c < C; ++c) {
+                    out[pairs * C + c] = pyramid_normalize<V, 2>(sum[2 * pairs * C + c] * 2);
+                }
+            }
+        }
+
+        /// \brief One output row of the 5 tap binomial filter
+        ///
+        /// rows are the five source rows around row 2y, borders repeat the edge pixels.
+        template <typename V, std::size_t C>
+        void pyramid_gaussian_row(
+            V const* const (&rows)[5],
+            pyramid_accumulator_t<V>* const sum,
+            V* const out,
+            std::size_t const w,
+            std::size_t const out_w) noexcept {
+            using accumulator = pyramid_accumulator_t<V>;
+
+            for(std::size_t i = 0; i < w * C; ++i) {
+                sum[i] = static_cast<accumulator>(rows[0][i]) + static_cast<accumulator>(rows[4][i])
+                    + (static_cast<accumulator>(rows[1][i]) + static_cast<accumulator>(rows[3][i])) * 4
+                    + static_cast<accumulator>(rows[2][i]) * 6;
+            }
+
+            auto const at = [sum, w](std::ptrdiff_t const x, std::size_t const c) {
+                auto const clamped = std::clamp<std::ptrdiff_t>(x, 0, static_cast<std::ptrdiff_t>(w) - 1);
+                return sum[static_cast<std::size_t>(clamped) * C + c];
+            };
+            auto const edge = [&](std::size_t const x) {
+                auto const sx = static_cast<std::ptrdiff_t>(2 * x);
+                for(std::size_t c = 0; c < C; ++c) {
+                    out[x * C + c] = pyramid_normalize<V, 8>(
+                        at(sx - 2, c) + at(sx + 2, c) + (at(sx - 1, c) + at(sx + 1, c)) * 4 + at(sx, c) * 6);
+                }
+            };
+
+            // inner columns need no border handling: 2x - 2 >= 0 and 2x + 2 < w
+            auto const inner_begin = std::min<std::size_t>(1, out_w);
+            auto const inner_end = std::max(inner_begin, w >= 3 ? std::min(out_w, (w - 3) / 2 + 1) : inner_begin);
+            for(std::size_t x = 0; x < inner_begin; ++x) {
+                edge(x);
+            }
+            for(std::size_t x = inner_begin; x < inner_end; ++x) {
+                auto const s = sum + (2 * x - 2) * C;
+                for(std::size_t c = 0; c < C; ++c) {
+                    out[x * C + c] = pyramid_normalize<V, 8>(
+                        s[c] + s[4 * C + c] + (s[C + c] + s[3 * C + c]) * 4 + s[2 * C + c] * 6);
+                }
+            }
+            for(std::size_t x = inner_end; x < out_w; ++x) {
+                edge(x);
+            }
+        }
+
+        /// \brief Decimate the w x h image in to the (w + 1) / 2 x (h + 1) / 2 image out
+        /// \throw std::invalid_argument for the gaussian filter on 64 bit integer channels
+        template <typename V, std::size_t C>
+        void pyramid_level(
+            V const* const in,
+            V* const out,
+            std::size_t const w,
+            std::size_t const h,
+            pyramid_filter const filter,
+            std::size_t const threads) {
+            if(is_pyramid_wide_v<V> && filter != pyramid_filter::box) {
+                throw std::invalid_argument("pyramid: the gaussian filter needs up to 32 bit integer channels");
+            }
+
+            auto const out_w = (w + 1) / 2;
+            auto const out_h = (h + 1) / 2;
+            auto const bands = (out_h + pyramid_band_rows - 1) / pyramid_band_rows;
+
+            parallel_for(bands, threads, [&](std::size_t const band) {
+                std::vector<pyramid_accumulator_t<V>> sum(is_pyramid_wide_v<V> ? 0 : w * C);
+                auto const y_end = std::min(out_h, (band + 1) * pyramid_band_rows);
+                for(auto y = band * pyramid_band_rows; y < y_end; ++y) {
+                    auto const row = [&](std::ptrdiff_t const sy) {
+                        auto const clamped = std::clamp<std::ptrdiff_t>(sy, 0, static_cast<std::ptrdiff_t>(h) - 1);
+                        return in + static_cast<std::size_t>(clamped) * w * C;
+                    };
+
+                    auto const sy = static_cast<std::ptrdiff_t>(2 * y);
+                    auto const target = out + y * out_w * C;
+                    if(filter == pyramid_filter::box) {
+                        pyramid_box_row<V, C>(row(sy), row(sy + 1), sum.data(), target, w, out_w);
+                    } else if constexpr(!is_pyramid_wide_v<V>) {
+                        V const* const rows[5] = {row(sy - 2), row(sy - 1), row(sy), row(sy + 1), row(sy + 2)};
+                        pyramid_gaussian_row<V, C>(rows, sum.data(), target, w, out_w);
+                    }
+                }
+            });
+        }
+
+
+    }
+
+
+    /// \brief All levels of an image pyramid in one contiguous allocation
+    ///
+    /// Level 0 is the image, every further level has half the width and height (rounded up) of
+    /// the one before. The levels are stored one behind the other, so the whole pyramid is a
+    /// single allocation.
+    template <typename T>
+    class pyramid {
+    public:
+        /// \brief Type of the pixels
+        using value_type = T;
+
+        /// \brief Type of level sizes
+        using size_type = typename bitmap<T>::size_type;
+
+
+        /// \brief Constructs an empty pyramid
+        pyramid() = default;
+
+        /// \brief Builds the pyramid of image level by level
+        /// \throw std::invalid_argument for the gaussian filter on 64 bit integer channels
+        explicit pyramid(bitmap<T> const& image, pyramid_options const& options = {}) {
+            using channel_type = pixel::channel_type_t<T>;
+            constexpr auto channels = pixel::channel_count_v<T>;
+            static_assert(
+                detail::is_floating_channel_v<channel_type>
+                    || (std::is_integral_v<channel_type> && !std::is_same_v<channel_type, bool>),
+                "pyramid needs a floating point or integer channel type");
+            static_assert(sizeof(T) == sizeof(channel_type) * channels);
+
+            if(image.empty()) {
+                return;
+            }
+
+            auto size = image.size();
+            std::size_t total = 0;
+            for(;;) {
+                offsets_.push_back(total);
+                sizes_.push_back(size);
+                total += size.area();
+
+                if((size.w() == 1 && size.h() == 1) || sizes_.size() == options.levels) {
+                    break;
+                }
+                size = size_type((size.w() + 1) / 2, (size.h() + 1) / 2);
+            }
+
+            data_.resize(total);
+            std::copy(image.begin(), image.end(), data_.begin());
+            for(std::size_t level = 1; level < sizes_.size(); ++level) {
+                detail::pyramid_level<channel_type, channels>(
+                    reinterpret_cast<channel_type const*>(data(level - 1)),
+                    reinterpret_cast<channel_type*>(data(level)),
+                    w(level - 1),
+                    h(level - 1),
+                    options.filter,
+                    options.threads);
+            }
+        }
+
+
+        /// \brief Number of levels
+        std::size_t levels() const noexcept {
+            return sizes_.size();
+        }
+
+        /// \brief true if the pyramid has no levels
+        bool empty() const noexcept {
+            return sizes_.empty();
+        }
+
+        /// \brief Size of a level
+        size_type const size(std::size_t const level) const {
+            throw_if_out_of_range(level);
+            return sizes_[level];
+        }
+
+        /// \brief Width of a level
+        std::size_t w(std::size_t const level) const {
+            return size(level).w();
+        }
+
+        /// \brief Height of a level
+        std::size_t h(std::size_t const level) const {
+            return size(level).h();
+        }
+
+
+        /// \brief Pixels of a level in row major order
+        T* data(std::size_t const level) {
+            throw_if_out_of_range(level);
+            return data_.data() + offsets_[level];
+        }
+
+        /// \brief Pixels of a level in row major order
+        T const* data(std::size_t const level) const {
+            throw_if_out_of_range(level);
+            return data_.data() + offsets_[level];
+        }
+
+        /// \brief Get a pixel of a level by local coordinates
+        T& operator()(std::size_t const level, std::size_t const x, std::size_t const y) {
+            return data(level)[y * sizes_[level].w() + x];
+        }
+
+        /// \brief Get a pixel of a level by local coordinates
+        T const& operator()(std::size_t const level, std::size_t const x, std::size_t const y) const {
+            return data(level)[y * sizes_[level].w() + x];
+        }
+
+        /// \brief Copy of a level as bitmap
+        bitmap<T> level(std::size_t const level) const {
+            auto const first = data(level);
+            return bitmap<T>(sizes_[level], first, first + sizes_[level].area());
+        }
+
+    private:
+        void throw_if_out_of_range(std::size_t const level) const {
+            if(level >= sizes_.size()) {
+                throw std::out_of_range(
+                    "pyramid: level " + std::to_string(level) + " is outside of " + std::to_string(sizes_.size())
+                    + " levels");
+            }
+        }
+
+        std::vector<T> data_;
+        std::vector<size_type> sizes_;
+        std::vector<std::size_t> offsets_;
+    };
+
+
+    /// \brief Image with half width and height (rounded up), filtered by filter
+    ///
+    /// This is level 1 of a pyramid without storing level 0 again. A bool pixel is true if at
+    /// least half of its filtered source pixels are true.
+    ///
+    /// \throw std::invalid_argument for the gaussian filter on 64 bit integer channels
+    template <typename T>
+    bitmap<T> downsample_half(
+        bitmap<T> const& image,
+        pyramid_filter const filter = pyramid_filter::box,
+        std::size_t const threads = 1) {
+        if constexpr(std::is_same_v<T, bool>) {
+            // 0 and 1 averages round half up to 1
+            bitmap<std::uint8_t> bytes(image.size());
+            std::transform(image.begin(), image.end(), bytes.begin(), [](bool const v) {
+                return static_cast<std::uint8_t>(v);
+            });
+            auto const scaled = downsample_half(bytes, filter, threads);
+            bitmap<bool> result(scaled.size());
+            std::transform(scaled.begin(), scaled.end(), result.begin(), [](std::uint8_t const v) { return v != 0; });
+            return result;
+        } else {
+            using channel_type = pixel::channel_type_t<T>;
+            constexpr auto channels = pixel::channel_count_v<T>;
+            static_assert(
+                detail::is_floating_channel_v<channel_type>
+                    || (std::is_integral_v<channel_type> && !std::is_same_v<channel_type, bool>),
+                "downsample_half needs a bool, floating point or integer channel type");
+            static_assert(sizeof(T) == sizeof(channel_type) * channels);
+
+            bitmap<T> result((image.w() + 1) / 2, (image.h() + 1) / 2);
+            if(!image.empty()) {
+                detail::pyramid_level<channel_type, channels>(
+                    reinterpret_cast<channel_type const*>(image.data()),
+                    reinterpret_cast<channel_type*>(result.data()),
+                    image.w(),
+                    image.h(),
+                    filter,
+                    threads);
+            }
+            return result;
+        }
+    }
+
+
+}
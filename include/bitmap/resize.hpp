@@ -0,0 +1,275 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "convert.hpp"
+#include "float16.hpp"
+#include "pixel.hpp"
+
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Interpolation filter of resize
+    enum class resize_filter : std::uint8_t {
+        /// \brief Area average when shrinking, nearest neighbor when enlarging
+        box,
+
+        /// \brief Triangle filter, linear interpolation when enlarging
+        bilinear,
+
+        /// \brief Keys cubic convolution with a = -0.5
+        bicubic,
+
+        /// \brief Lanczos windowed sinc with 3 lobes
+        lanczos3
+    };
+
+    /// \brief Settings of resize
+    struct resize_options {
+        resize_filter filter = resize_filter::bilinear;
+
+        /// \brief Threads for both passes, 0 means one per hardware thread
+        std::size_t threads = 1;
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Half width of the filter kernel in source pixels when enlarging
+        constexpr double resize_radius(resize_filter const filter) noexcept {
+            switch(filter) {
+            case resize_filter::box:
+                return 0.5;
+            case resize_filter::bilinear:
+                return 1;
+            case resize_filter::bicubic:
+                return 2;
+            case resize_filter::lanczos3:
+                return 3;
+            }
+            return 0;
+        }
+
+        /// \brief Unnormalized kernel value at distance x
+        inline double resize_kernel(resize_filter const filter, double const x) noexcept {
+            auto const a = std::abs(x);
+            switch(filter) {
+            case resize_filter::box:
+                // half open, so a tap on the border between two pixels counts once
+                return x >= -0.5 && x < 0.5 ? 1 : 0;
+            case resize_filter::bilinear:
+                return a < 1 ? 1 - a : 0;
+            case resize_filter::bicubic:
+                if(a < 1) {
+                    return (1.5 * a - 2.5) * a * a + 1;
+                } else if(a < 2) {
+                    return ((-0.5 * a + 2.5) * a - 4) * a + 2;
+                }
+                return 0;
+            case resize_filter::lanczos3:
+                if(a < 1e-8) {
+                    return 1;
+                } else if(a < 3) {
+                    auto const px = std::numbers::pi * x;
+                    return 3 * std::sin(px) * std::sin(px / 3) / (px * px);
+                }
+                return 0;
+            }
+            return 0;
+        }
+
+        /// \brief Precomputed filter taps of every target coordinate along one axis
+        ///
+        /// Target coordinate i reads the source coordinates first[i] to first[i] + taps - 1 with
+        /// weights[i * taps] to weights[i * taps + taps - 1]. Every target coordinate has the
+        /// same number of taps, unused ones have weight 0, so the inner loop has a fixed length.
+        template <typename Compute>
+        struct resize_weights {
+            std::size_t taps = 0;
+            std::vector<std::size_t> first;
+            std::vector<Compute> weights;
+        };
+
+        /// \brief Filter taps to resample in source values to out target values
+        ///
+        /// Pixel centers are aligned, so the image borders map to each other. When shrinking,
+        /// the kernel is widened by the scale factor to average all covered source pixels.
+        /// Source coordinates outside of the image repeat the border pixel.
+        template <typename Compute>
+        resize_weights<Compute> make_resize_weights(std::size_t const in, std::size_t const out, resize_filter const filter) {
+            auto const ratio = static_cast<double>(in) / static_cast<double>(out);
+            auto const scale = std::max(ratio, 1.0);
+            auto const support = resize_radius(filter) * scale;
+            auto const last_index = static_cast<std::ptrdiff_t>(in) - 1;
+
+            std::vector<std::vector<double>> taps(out);
+            std::vector<std::size_t> first(out);
+            std::size_t tap_count = 1;
+            for(std::size_t i = 0; i < out; ++i) {
+                auto const center = (static_cast<double>(i) + 0.5) * ratio - 0.5;
+                auto const begin = static_cast<std::ptrdiff_t>(std::floor(center - support));
+                auto const end = static_cast<std::ptrdiff_t>(std::ceil(center + support));
+
+                auto const clamped_begin = std::clamp<std::ptrdiff_t>(begin, 0, last_index);
+                auto const clamped_end = std::clamp<std::ptrdiff_t>(end, 0, last_index);
+                auto& weights = taps[i];
+                weights.assign(static_cast<std::size_t>(clamped_end - clamped_begin + 1), 0);
+
+                double sum = 0;
+                for(auto k = begin; k <= end; ++k) {
+                    auto const weight = resize_kernel(filter, (static_cast<double>(k) - center) / scale);
+                    weights[static_cast<std::size_t>(std::clamp(k, clamped_begin, clamped_end) - clamped_begin)] += weight;
+                    sum += weight;
+                }
+                for(auto& weight: weights) {
+                    weight /= sum;
+                }
+
+                first[i] = static_cast<std::size_t>(clamped_begin);
+                tap_count = std::max(tap_count, weights.size());
+            }
+
+            resize_weights<Compute> result{tap_count, std::move(first), std::vector<Compute>(out * tap_count)};
+            for(std::size_t i = 0; i < out; ++i) {
+                // move the window left at the right border, so all taps are inside of the source
+                auto const begin = std::min(result.first[i], in - tap_count);
+                auto const offset = result.first[i] - begin;
+                result.first[i] = begin;
+                for(std::size_t k = 0; k < taps[i].size(); ++k) {
+                    result.weights[i * tap_count + offset + k] = static_cast<Compute>(taps[i][k]);
+                }
+            }
+            return result;
+        }
+
+        /// \brief Resample one row horizontally, C channels per pixel
+        template <std::size_t C, typename V, typename Compute>
+        void resize_row(
+            V const* const in,
+            Compute* const out,
+            std::size_t const out_w,
+            resize_weights<Compute> const& weights) noexcept {
+            auto const taps = weights.taps;
+            for(std::size_t x = 0; x < out_w; ++x) {
+                auto const source = in + weights.first[x] * C;
+                auto const w = weights.weights.data() + x * taps;
+                for(std::size_t c = 0; c < C; ++c) {
+                    Compute sum = 0;
+                    for(std::size_t k = 0; k < taps; ++k) {
+                        sum += w[k] * static_cast<Compute>(source[k * C + c]);
+                    }
+                    out[x * C + c] = sum;
+                }
+            }
+        }
+
+        /// \brief Rows per band of both passes, a band is the unit of work of a thread
+        constexpr std::size_t resize_band_rows = 16;
+
+
+    }
+
+
+    /// \brief Resample image to size with a separable filter
+    ///
+    /// The first pass resamples every row into a buffer of target width, the second one
+    /// combines whole buffer rows into target rows, so both passes read memory linearly. The
+    /// filter taps of every column and row are computed once. Integral results are rounded and
+    /// saturated.
+    ///
+    /// \throw std::invalid_argument if image is empty and size is not
+    template <typename T>
+    bitmap<T> resize(
+        bitmap<T> const& image,
+        typename bitmap<T>::size_type const& size,
+        resize_options const& options = {}) {
+        using value_type = pixel::channel_type_t<T>;
+        using compute = detail::convert_compute_type<value_type, value_type>;
+        constexpr auto channels = pixel::channel_count_v<T>;
+        static_assert(
+            (std::is_arithmetic_v<value_type> || is_half_float_v<value_type>) && !std::is_same_v<value_type, bool>,
+            "resize needs arithmetic or half precision channel types");
+        static_assert(sizeof(T) == sizeof(value_type) * channels);
+
+        bitmap<T> result(size);
+        if(result.empty()) {
+            return result;
+        }
+        if(image.empty()) {
+            throw std::invalid_argument(
+                "resize of an empty image to " + std::to_string(size.w()) + "x" + std::to_string(size.h()));
+        }
+
+        auto const in_w = image.w();
+        auto const in_h = image.h();
+        auto const out_w = size.w();
+        auto const out_h = size.h();
+        auto const row_values = out_w * channels;
+
+        auto const columns = detail::make_resize_weights<compute>(in_w, out_w, options.filter);
+        auto const rows = detail::make_resize_weights<compute>(in_h, out_h, options.filter);
+
+        // horizontal pass, only the source rows the vertical pass reads
+        auto const first_row = rows.first.front();
+        auto const end_row = rows.first.back() + rows.taps;
+        std::vector<compute> buffer((end_row - first_row) * row_values);
+        auto const in = reinterpret_cast<value_type const*>(image.data());
+        auto const horizontal_bands = (end_row - first_row + detail::resize_band_rows - 1) / detail::resize_band_rows;
+        detail::parallel_for(horizontal_bands, options.threads, [&](std::size_t const band) {
+            auto const y_begin = first_row + band * detail::resize_band_rows;
+            auto const y_end = std::min(end_row, y_begin + detail::resize_band_rows);
+            for(auto y = y_begin; y < y_end; ++y) {
+                detail::resize_row<channels>(
+                    in + y * in_w * channels, buffer.data() + (y - first_row) * row_values, out_w, columns);
+            }
+        });
+
+        // vertical pass, every target row is a weighted sum of whole buffer rows
+        auto const out = reinterpret_cast<value_type*>(result.data());
+        auto const vertical_bands = (out_h + detail::resize_band_rows - 1) / detail::resize_band_rows;
+        detail::parallel_for(vertical_bands, options.threads, [&](std::size_t const band) {
+            std::vector<compute> sum(row_values);
+            auto const y_end = std::min(out_h, (band + 1) * detail::resize_band_rows);
+            for(auto y = band * detail::resize_band_rows; y < y_end; ++y) {
+                auto const weights = rows.weights.data() + y * rows.taps;
+                auto const source = buffer.data() + (rows.first[y] - first_row) * row_values;
+
+                std::fill(sum.begin(), sum.end(), compute(0));
+                for(std::size_t k = 0; k < rows.taps; ++k) {
+                    auto const weight = weights[k];
+                    auto const row = source + k * row_values;
+                    for(std::size_t i = 0; i < row_values; ++i) {
+                        sum[i] += weight * row[i];
+                    }
+                }
+
+                detail::convert_values(sum.data(), out + y * row_values, row_values, convert_options{});
+            }
+        });
+
+        return result;
+    }
+
+    /// \brief Resample image to w x h with a separable filter
+    ///
+    /// \throw std::invalid_argument if image is empty and w x h is not
+    template <typename T>
+    bitmap<T> resize(bitmap<T> const& image, std::size_t const w, std::size_t const h, resize_options const& options = {}) {
+        return resize(image, typename bitmap<T>::size_type(w, h), options);
+    }
+
+
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "bitmask.hpp"
+#include "histogram.hpp"
+#include "rect.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace bmp {
+
+
+    /// \brief Covered pixels [begin, end) of a row
+    struct rle_span {
+        std::uint32_t begin = 0;
+        std::uint32_t end = 0;
+
+        /// \brief Number of covered pixels
+        constexpr std::size_t length() const noexcept {
+            return end - begin;
+        }
+
+        [[nodiscard]] constexpr bool operator==(rle_span const&) const noexcept = default;
+    };
+
+
+    /// \brief A mask that stores the covered pixels of every row as sorted spans
+    ///
+    /// Memory and the cost of all operations depend on the number of spans, not on the number
+    /// of pixels, so huge sparse masks are cheap. The spans of a row are sorted, disjoint and
+    /// never touch each other. All spans are in one array, row y owns the spans from
+    /// row_begin[y] to row_begin[y + 1].
+    class rle_mask {
+    public:
+        /// \brief Type of mask size
+        using size_type = ::bmp::size<std::size_t>;
+
+
+        /// \brief Constructs a blank mask
+        rle_mask() = default;
+
+        /// \brief Constructs a mask with size that covers nothing
+        explicit rle_mask(size_type const& size)
+            : size_(size)
+            , row_begin_(size.h() + 1) {
+            throw_if_too_wide();
+        }
+
+        /// \brief Constructs a mask with size w and h that covers nothing
+        rle_mask(std::size_t const w, std::size_t const h)
+            : rle_mask(size_type(w, h)) {}
+
+        /// \brief Constructs a mask with size that covers the part of rect inside of it
+        rle_mask(size_type const& size, rect<std::size_t> const& rect)
+            : rle_mask(size) {
+            auto const l = std::min(rect.x(), size.w());
+            auto const r = std::min(rect.x() + rect.w(), size.w());
+            auto const t = std::min(rect.y(), size.h());
+            auto const b = std::min(rect.y() + rect.h(), size.h());
+            if(l == r) {
+                return;
+            }
+
+            spans_.assign(b - t, rle_span{static_cast<std::uint32_t>(l), static_cast<std::uint32_t>(r)});
+            for(auto y = t; y <= size.h(); ++y) {
+                row_begin_[y] = std::min(y, b) - t;
+            }
+        }
+
+        /// \brief Constructs a mask from a bitmap of bools
+        explicit rle_mask(bitmap<bool> const& image)
+            : rle_mask(image.size()) {
+            for(std::size_t y = 0; y < h(); ++y) {
+                std::size_t x = 0;
+                for(;;) {
+                    while(x < w() && !image(x, y)) {
+                        ++x;
+                    }
+                    if(x >= w()) {
+                        break;
+                    }
+                    auto const begin = x;
+                    while(x < w() && image(x, y)) {
+                        ++x;
+                    }
+                    spans_.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(x)});
+                }
+                row_begin_[y + 1] = spans_.size();
+            }
+        }
+
+        /// \brief Constructs a mask from a bitmask, words without a change are skipped at once
+        explicit rle_mask(bitmask const& mask)
+            : rle_mask(mask.size()) {
+            for(std::size_t y = 0; y < h(); ++y) {
+                detail::for_each_run(mask, y, [this](std::size_t const begin, std::size_t const end) {
+                    spans_.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+                });
+                row_begin_[y + 1] = spans_.size();
+            }
+        }
+
+
+        /// \brief Get the width
+        std::size_t w() const noexcept {
+            return size_.w();
+        }
+
+        /// \brief Get the height
+        std::size_t h() const noexcept {
+            return size_.h();
+        }
+
+        /// \brief Get the size
+        size_type const size() const noexcept {
+            return size_;
+        }
+
+        /// \brief Get the number of points in the mask, covered or not
+        std::size_t point_count() const noexcept {
+            return size_.area();
+        }
+
+        /// \brief true if mask is empty, false otherwise
+        bool empty() const noexcept {
+            return point_count() == 0;
+        }
+
+        /// \brief Number of covered pixels
+        std::size_t area() const noexcept {
+            std::size_t result = 0;
+            for(auto const& span: spans_) {
+                result += span.length();
+            }
+            return result;
+        }
+
+        /// \brief Number of spans in all rows
+        std::size_t span_count() const noexcept {
+            return spans_.size();
+        }
+
+
+        /// \brief Get the spans of row y
+        std::span<rle_span const> row(std::size_t const y) const noexcept {
+            return {spans_.data() + row_begin_[y], spans_.data() + row_begin_[y + 1]};
+        }
+
+        /// \brief true if the pixel is covered, binary search in its row
+        bool operator()(std::size_t const x, std::size_t const y) const noexcept {
+            auto const spans = row(y);
+            auto const it = std::upper_bound(
+                spans.begin(), spans.end(), x, [](std::size_t const v, rle_span const& span) { return v < span.end; });
+            return it != spans.end() && it->begin <= x;
+        }
+
+        /// \brief Smallest rect that contains all covered pixels, (0, 0, 0, 0) if nothing is covered
+        rect<std::size_t> bounds() const noexcept {
+            std::size_t l = w();
+            std::size_t r = 0;
+            std::size_t t = h();
+            std::size_t b = 0;
+            for(std::size_t y = 0; y < h(); ++y) {
+                auto const spans = row(y);
+                if(spans.empty()) {
+                    continue;
+                }
+                t = std::min(t, y);
+                b = y + 1;
+                l = std::min<std::size_t>(l, spans.front().begin);
+                r = std::max<std::size_t>(r, spans.back().end);
+            }
+            return b == 0 ? rect<std::size_t>() : rect<std::size_t>(l, t, r - l, b - t);
+        }
+
+
+        /// \brief Build a mask row by row from fn(y, spans), fn appends the sorted spans of row y
+        ///
+        /// \throw std::invalid_argument if fn appends unsorted, touching or out of range spans
+        template <typename Fn>
+        static rle_mask from_rows(size_type const& size, Fn&& fn) {
+            rle_mask result(size);
+            for(std::size_t y = 0; y < size.h(); ++y) {
+                auto const first = result.spans_.size();
+                fn(y, result.spans_);
+                for(auto i = first; i < result.spans_.size(); ++i) {
+                    auto const& span = result.spans_[i];
+                    if(span.begin >= span.end || span.end > size.w()
+                       || (i > first && result.spans_[i - 1].end >= span.begin)) {
+                        throw std::invalid_argument(
+                            "rle_mask: invalid span [" + std::to_string(span.begin) + ", " + std::to_string(span.end)
+                            + ") in row " + std::to_string(y));
+                    }
+                }
+                result.row_begin_[y + 1] = result.spans_.size();
+            }
+            return result;
+        }
+
+        [[nodiscard]] bool operator==(rle_mask const&) const = default;
+
+    private:
+        void throw_if_too_wide() const {
+            if(size_.w() > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::length_error("rle_mask: width does not fit into 32 bit");
+            }
+        }
+
+        size_type size_;
+        std::vector<rle_span> spans_;
+        std::vector<std::size_t> row_begin_ = std::vector<std::size_t>(1);
+    };
+
+
+    namespace detail {
+
+
+        /// \brief Combine two sorted span lists, op(in_a, in_b) decides if a pixel is covered
+        ///
+        /// One sweep over the span borders of both rows, so the cost is linear in the number
+        /// of spans. Neighboring output spans are merged.
+        template <typename Op>
+        void rle_combine_row(
+            std::span<rle_span const> const a,
+            std::span<rle_span const> const b,
+            std::vector<rle_span>& out,
+            Op const op) {
+            constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+            std::size_t i = 0;
+            std::size_t j = 0;
+            bool in_a = false;
+            bool in_b = false;
+            bool covered = false;
+            std::uint32_t begin = 0;
+            for(;;) {
+                auto const next_a = i < a.size() ? (in_a ? a[i].end : a[i].begin) : none;
+                auto const next_b = j < b.size() ? (in_b ? b[j].end : b[j].begin) : none;
+                auto const x = std::min(next_a, next_b);
+                if(x == none) {
+                    break;
+                }
+
+                if(next_a == x) {
+                    in_a = !in_a;
+                    i += in_a ? 0 : 1;
+                }
+                if(next_b == x) {
+                    in_b = !in_b;
+                    j += in_b ? 0 : 1;
+                }
+
+                auto const now = op(in_a, in_b);
+                if(now != covered) {
+                    if(now) {
+                        begin = x;
+                    } else {
+                        out.push_back({begin, x});
+                    }
+                    covered = now;
+                }
+            }
+        }
+
+        /// \brief Combine two masks of equal size row by row
+        template <typename Op>
+        rle_mask rle_combine(rle_mask const& a, rle_mask const& b, Op const op, char const* const name) {
+            if(a.size() != b.size()) {
+                throw std::invalid_argument(
+                    std::string("rle_mask ") + name + ": sizes " + std::to_string(a.w()) + "x" + std::to_string(a.h())
+                    + " and " + std::to_string(b.w()) + "x" + std::to_string(b.h()) + " differ");
+            }
+            return rle_mask::from_rows(a.size(), [&](std::size_t const y, std::vector<rle_span>& spans) {
+                rle_combine_row(a.row(y), b.row(y), spans, op);
+            });
+        }
+
+
+    }
+
+
+    /// \brief Pixels covered by l or r
+    /// \throw std::invalid_argument if the sizes differ
+    inline rle_mask operator|(rle_mask const& l, rle_mask const& r) {
+        return detail::rle_combine(l, r, [](bool const a, bool const b) { return a || b; }, "union");
+    }
+
+    /// \brief Pixels covered by l and r
+    /// \throw std::invalid_argument if the sizes differ
+    inline rle_mask operator&(rle_mask const& l, rle_mask const& r) {
+        return detail::rle_combine(l, r, [](bool const a, bool const b) { return a && b; }, "intersection");
+    }
+
+    /// \brief Pixels covered by exactly one of l and r
+    /// \throw std::invalid_argument if the sizes differ
+    inline rle_mask operator^(rle_mask const& l, rle_mask const& r) {
+        return detail::rle_combine(l, r, [](bool const a, bool const b) { return a != b; }, "symmetric difference");
+    }
+
+    /// \brief Pixels covered by l but not by r
+    /// \throw std::invalid_argument if the sizes differ
+    inline rle_mask operator-(rle_mask const& l, rle_mask const& r) {
+        return detail::rle_combine(l, r, [](bool const a, bool const b) { return a && !b; }, "difference");
+    }
+
+    /// \brief Pixels of mask inside of rect, the size stays the same
+    inline rle_mask clip(rle_mask const& mask, rect<std::size_t> const& rect) {
+        auto const l = std::min(rect.x(), mask.w());
+        auto const r = std::min(rect.x() + rect.w(), mask.w());
+        auto const t = std::min(rect.y(), mask.h());
+        auto const b = std::min(rect.y() + rect.h(), mask.h());
+        return rle_mask::from_rows(mask.size(), [&](std::size_t const y, std::vector<rle_span>& spans) {
+            if(y < t || y >= b) {
+                return;
+            }
+            for(auto const& span: mask.row(y)) {
+                auto const begin = std::max<std::size_t>(span.begin, l);
+                auto const end = std::min<std::size_t>(span.end, r);
+                if(begin < end) {
+                    spans.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+                }
+            }
+        });
+    }
+
+
+    /// \brief Call fn(y, begin, end) for every span in row major order
+    template <typename Fn>
+    void for_each_span(rle_mask const& mask, Fn&& fn) {
+        for(std::size_t y = 0; y < mask.h(); ++y) {
+            for(auto const& span: mask.row(y)) {
+                fn(y, std::size_t(span.begin), std::size_t(span.end));
+            }
+        }
+    }
+
+    /// \brief Call fn(x, y) for every covered pixel in row major order
+    template <typename Fn>
+    void for_each_pixel(rle_mask const& mask, Fn&& fn) {
+        for_each_span(mask, [&fn](std::size_t const y, std::size_t const begin, std::size_t const end) {
+            for(auto x = begin; x < end; ++x) {
+                fn(x, y);
+            }
+        });
+    }
+
+
+    /// \brief Unpack a mask into a bitmap of bools
+    inline bitmap<bool> to_bitmap(rle_mask const& mask) {
+        bitmap<bool> result(mask.size());
+        for_each_pixel(mask, [&result](std::size_t const x, std::size_t const y) { result(x, y) = true; });
+        return result;
+    }
+
+    /// \brief Unpack a mask into a bitmask
+    inline bitmask to_bitmask(rle_mask const& mask) {
+        bitmask result(mask.size());
+        for_each_span(mask, [&result](std::size_t const y, std::size_t const begin, std::size_t const end) {
+            auto const row = result.row(y);
+            for(auto x = begin; x < end;) {
+                auto const index = x / bitmask::word_bits;
+                auto const first = x % bitmask::word_bits;
+                auto const last = std::min(end - index * bitmask::word_bits, bitmask::word_bits);
+                auto const bits = last - first == bitmask::word_bits
+                    ? ~bitmask::word_type(0)
+                    : ((bitmask::word_type(1) << (last - first)) - 1) << first;
+                row[index] |= bits;
+                x = index * bitmask::word_bits + last;
+            }
+        });
+        return result;
+    }
+
+
+    /// \brief Histogram of the pixels of image covered by mask, see histogram of a bitmap
+    ///
+    /// Values are clamped to min and max, NaN values are ignored. Only covered pixels are read.
+    ///
+    /// \throw std::invalid_argument if the sizes differ
+    template <typename T>
+    std::vector<std::size_t> histogram(
+        bitmap<T> const& image,
+        rle_mask const& mask,
+        T const min,
+        T const max,
+        std::size_t const bin_count,
+        bool const cumulative = false) {
+        if(image.size() != mask.size()) {
+            throw std::invalid_argument("histogram: image and rle_mask have different sizes");
+        }
+
+        auto const values = image.data();
+        auto const w = image.w();
+        return detail::histogram_of_values(
+            [&mask, values, w](auto const& fn) {
+                for_each_span(
+                    mask, [&fn, values, w](std::size_t const y, std::size_t const begin, std::size_t const end) {
+                        auto const row = values + y * w;
+                        for(auto x = begin; x < end; ++x) {
+                            fn(row[x]);
+                        }
+                    });
+            },
+            min,
+            max,
+            bin_count,
+            cumulative);
+    }
+
+
+}
@@ -0,0 +1,74 @@
+#include <bitmap/async_writer.hpp>
+#include <bitmap/binary_read.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+
+
+using bmp::async_writer;
+using bmp::bitmap;
+
+
+TEST(AsyncWriterTest, BinaryWrite) {
+    auto const dir = std::filesystem::temp_directory_path() / "bitmap_async_writer_test";
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::future<void>> futures;
+    {
+        async_writer writer(2);
+        for(int i = 0; i < 8; ++i) {
+            bitmap<int> image(5, 3, i);
+            auto const data = image.data();
+            futures.push_back(writer.binary_write(std::move(image), (dir / (std::to_string(i) + ".bbf")).string()));
+            EXPECT_NE(image.data(), data);
+        }
+        writer.wait();
+        EXPECT_EQ(writer.used_bytes(), 0);
+    }
+
+    for(int i = 0; i < 8; ++i) {
+        EXPECT_NO_THROW(futures[static_cast<std::size_t>(i)].get());
+        EXPECT_EQ(bmp::binary_read<int>((dir / (std::to_string(i) + ".bbf")).string()), bitmap<int>(5, 3, i));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AsyncWriterTest, Error) {
+    async_writer writer;
+    auto future = writer.binary_write(bitmap<int>(2, 2), "/nonexistent_directory/file.bbf");
+    EXPECT_THROW(future.get(), bmp::binary_io_error);
+
+    std::exception_ptr error;
+    writer.write(
+        bitmap<int>(2, 2), [](auto const&) { throw std::runtime_error("test"); },
+        [&error](std::exception_ptr e) { error = e; });
+    writer.wait();
+    EXPECT_TRUE(error);
+}
+
+TEST(AsyncWriterTest, MemoryBudget) {
+    async_writer writer(1, 100 * sizeof(int));
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    auto first = writer.write(bitmap<int>(10, 10), [released](auto const&) { released.wait(); });
+    EXPECT_EQ(writer.used_bytes(), 100 * sizeof(int));
+
+    std::atomic<bool> second_queued = false;
+    std::thread producer([&] {
+        writer.write(bitmap<int>(10, 1), [](auto const&) {}).get();
+        second_queued = true;
+    });
+
+    EXPECT_FALSE(second_queued);
+    release.set_value();
+    producer.join();
+    EXPECT_TRUE(second_queued);
+    first.get();
+
+    // an image larger than the budget is accepted if nothing else is queued
+    writer.write(bitmap<int>(20, 20), [](auto const&) {}).get();
+}
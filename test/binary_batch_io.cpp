@@ -0,0 +1,106 @@
+#include <bitmap/binary_batch_io.hpp>
+#include <bitmap/binary_tiled.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+
+using bmp::batch_io_backend;
+using bmp::batch_io_options;
+using bmp::bitmap;
+
+
+namespace {
+
+
+    class BinaryBatchIOTest: public testing::TestWithParam<batch_io_options> {
+    protected:
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() / "bitmap_binary_batch_io_test";
+            std::filesystem::create_directories(dir);
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(dir);
+        }
+
+        std::vector<std::string> filenames(std::size_t const count) const {
+            std::vector<std::string> result;
+            for(std::size_t i = 0; i < count; ++i) {
+                result.push_back((dir / (std::to_string(i) + ".bbf")).string());
+            }
+            return result;
+        }
+
+        std::filesystem::path dir;
+    };
+
+
+}
+
+
+TEST_P(BinaryBatchIOTest, WriteRead) {
+    std::vector<bitmap<std::uint16_t>> images;
+    for(std::size_t i = 0; i < 20; ++i) {
+        // includes empty bitmaps and sizes larger than one alignment block
+        images.emplace_back(i * 13, i, static_cast<std::uint16_t>(i * 1000));
+    }
+
+    auto const names = filenames(images.size());
+    bmp::binary_write_batch(images, names, std::endian::native, GetParam());
+
+    for(std::size_t i = 0; i < images.size(); ++i) {
+        EXPECT_EQ(std::filesystem::file_size(names[i]), 24 + images[i].point_count() * 2);
+        EXPECT_EQ(bmp::binary_read<std::uint16_t>(names[i]), images[i]);
+    }
+
+    EXPECT_EQ(bmp::binary_read_batch<std::uint16_t>(names, GetParam()), images);
+}
+
+TEST_P(BinaryBatchIOTest, Bool) {
+    std::vector<bitmap<bool>> images{bitmap<bool>(3, 5, true), bitmap<bool>(9, 1, false)};
+    auto const names = filenames(images.size());
+    bmp::binary_write_batch(images, names, std::endian::big, GetParam());
+    EXPECT_EQ(bmp::binary_read_batch<bool>(names, GetParam()), images);
+}
+
+TEST_P(BinaryBatchIOTest, Tiled) {
+    // tiles are found by seeking in the read buffer
+    std::vector<bitmap<std::uint16_t>> images{bitmap<std::uint16_t>(37, 21), bitmap<std::uint16_t>(5, 70)};
+    for(auto& image: images) {
+        for(std::size_t i = 0; i < image.point_count(); ++i) {
+            image.data()[i] = static_cast<std::uint16_t>(i * 7);
+        }
+    }
+
+    auto const names = filenames(images.size());
+    bmp::binary_write_tiled(images[0], names[0], bmp::binary_tiling{16, 8, 2});
+    bmp::binary_write_tiled(images[1], names[1], bmp::binary_tiling{4, 32, 1}, std::endian::big);
+    EXPECT_EQ(bmp::binary_read_batch<std::uint16_t>(names, GetParam()), images);
+}
+
+TEST_P(BinaryBatchIOTest, Errors) {
+    auto names = filenames(3);
+    bmp::binary_write_batch(std::vector{bitmap<int>(2, 2, 1), bitmap<int>(2, 2, 2), bitmap<int>(2, 2, 3)}, names, std::endian::native, GetParam());
+
+    EXPECT_THROW(bmp::binary_read_batch<float>(names, GetParam()), bmp::binary_io_error);
+
+    std::filesystem::resize_file(names[1], 30);
+    EXPECT_THROW(bmp::binary_read_batch<int>(names, GetParam()), bmp::binary_io_error);
+
+    names[1] = (dir / "missing.bbf").string();
+    EXPECT_THROW(bmp::binary_read_batch<int>(names, GetParam()), bmp::binary_io_error);
+
+    EXPECT_THROW(bmp::binary_write_batch(std::vector{bitmap<int>(2, 2)}, names), std::invalid_argument);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Backends,
+    BinaryBatchIOTest,
+    testing::Values(
+        batch_io_options{},
+        batch_io_options{1, false, batch_io_backend::automatic},
+        batch_io_options{4, true, batch_io_backend::automatic},
+        batch_io_options{4, false, batch_io_backend::pread},
+        batch_io_options{4, true, batch_io_backend::pread}));
@@ -165,3 +165,172 @@ TYPED_TEST(endian_read_write_test, BigRWTest) {
     auto img2 = binary_read<type>(s);
     EXPECT_EQ(img, img2);
 }
+
+
+template <typename T>
+struct compressed_read_write_test: public ::testing::Test {
+    using type = T;
+};
+
+TYPED_TEST_SUITE(compressed_read_write_test, all_types, );
+
+TYPED_TEST(compressed_read_write_test, RWTest) {
+    using type = typename TestFixture::type;
+    auto img = make<type>(37, 29);
+    for(auto const codec: {bmp::binary_codec::none, bmp::binary_codec::lz4}) {
+        for(auto const endianness: {std::endian::little, std::endian::big}) {
+            for(auto const delta: {false, true}) {
+                std::stringstream s;
+                binary_write(img, s, bmp::binary_compression{codec, true, delta, 4, 2}, endianness);
+                EXPECT_EQ(binary_read<type>(s, true, 3), img);
+            }
+        }
+    }
+}
+
+TEST(BinaryIOTest, CompressedBool) {
+    auto img = make<bool>(13, 11);
+    std::stringstream s;
+    binary_write(img, s, bmp::binary_compression{bmp::binary_codec::lz4, true, true, 3});
+    EXPECT_EQ(binary_read<bool>(s), img);
+}
+
+TEST(BinaryIOTest, CompressedSize) {
+    bitmap<std::uint16_t> img(640, 480);
+    for(std::size_t y = 0; y < img.h(); ++y) {
+        for(std::size_t x = 0; x < img.w(); ++x) {
+            img(x, y) = static_cast<std::uint16_t>(1000 + x * 3 + y);
+        }
+    }
+
+    std::stringstream s;
+    binary_write(img, s, bmp::binary_compression{bmp::binary_codec::lz4, true, true});
+    EXPECT_LT(s.str().size(), img.point_count() * sizeof(std::uint16_t) / 10);
+    EXPECT_EQ(binary_read<std::uint16_t>(s, true, 0), img);
+
+    // empty bitmap
+    std::stringstream empty;
+    binary_write(bitmap<float>(), empty, bmp::binary_compression{});
+    EXPECT_EQ(binary_read<float>(empty), bitmap<float>());
+}
+
+TEST(BinaryIOTest, CompressedCorrupt) {
+    bitmap<std::uint32_t> img(100, 100, 7);
+    std::stringstream s;
+    binary_write(img, s, bmp::binary_compression{});
+    auto data = s.str();
+
+    for(std::size_t i = header_size + 8; i < data.size(); i += 7) {
+        auto corrupt = data;
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x5A);
+        std::istringstream is(corrupt);
+        try {
+            // either detected or decoded to some image, but never out of bounds
+            binary_read<std::uint32_t>(is);
+        } catch(bmp::binary_io_error const&) {
+        }
+    }
+
+    std::istringstream truncated(data.substr(0, data.size() - 1));
+    EXPECT_THROW(binary_read<std::uint32_t>(truncated), bmp::binary_io_error);
+}
+
+
+TEST(BinaryIOTest, Crc32c) {
+    std::string const check = "123456789";
+    EXPECT_EQ(bmp::detail::crc32c(0, check.data(), check.size()), 0xE3069283u);
+    EXPECT_EQ(bmp::detail::crc32c(bmp::detail::crc32c(0, check.data(), 4), check.data() + 4, 5), 0xE3069283u);
+
+    std::string data(1000, '\0');
+    for(std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    auto const bytes = reinterpret_cast<std::byte const*>(data.data() + 3);
+    EXPECT_EQ(
+        bmp::detail::crc32c(0, bytes, 997),
+        ~bmp::detail::crc32c_impl::software(~std::uint32_t(0), bytes, 997));
+}
+
+
+template <typename T>
+struct checksum_read_write_test: public ::testing::Test {
+    using type = T;
+};
+
+TYPED_TEST_SUITE(checksum_read_write_test, all_types, );
+
+TYPED_TEST(checksum_read_write_test, RWTest) {
+    using type = typename TestFixture::type;
+    auto img = make<type>(37, 29);
+    for(auto const endianness: {std::endian::little, std::endian::big}) {
+        for(auto const chunk_size: {std::size_t(1), std::size_t(100), std::size_t(1) << 20}) {
+            std::stringstream s;
+            binary_write(img, s, bmp::binary_checksum{chunk_size}, endianness);
+            EXPECT_EQ(binary_read<type>(s), img);
+        }
+    }
+}
+
+TEST(BinaryIOTest, ChecksumCorrupt) {
+    auto img = make<std::uint16_t>(50, 40);
+    std::stringstream s;
+    binary_write(img, s, bmp::binary_checksum{256});
+    auto data = s.str();
+    EXPECT_EQ(data.size(), header_size + 8 + 4000 + 16 * 4);
+
+    for(std::size_t i = 0; i < data.size(); i += 5) {
+        auto corrupt = data;
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x01);
+        std::istringstream is(corrupt);
+        EXPECT_THROW(binary_read<std::uint16_t>(is), bmp::binary_io_error) << "byte " << i;
+    }
+
+    std::istringstream truncated(data.substr(0, data.size() - 1));
+    EXPECT_THROW(binary_read<std::uint16_t>(truncated), bmp::binary_io_error);
+}
+
+
+TEST(BinaryIOTest, MaskedRWTest) {
+    bmp::masked_bitmap<std::uint16_t> img(make<std::uint16_t>(70, 9), bmp::bitmask(70, 9));
+    for(std::size_t y = 0; y < img.h(); ++y) {
+        for(std::size_t x = 0; x < img.w(); ++x) {
+            img.mask().set(x, y, (x + y) % 3 != 0);
+        }
+    }
+
+    for(auto const endianness: {std::endian::little, std::endian::big}) {
+        std::stringstream s;
+        binary_write(img, s, endianness);
+        // values, then 2 words of mask per row
+        EXPECT_EQ(s.str().size(), header_size + 70 * 9 * 2 + 9 * 2 * 8);
+        EXPECT_EQ(static_cast<std::uint8_t>(s.str()[7]) & 0x20, 0x20);
+
+        bmp::masked_bitmap<std::uint16_t> img2;
+        binary_read(img2, s);
+        EXPECT_EQ(img2, img);
+
+        s.seekg(0);
+        EXPECT_EQ(binary_read<pixel::masked_g16u>(s), bmp::combine_mask(img));
+
+        s.seekg(0);
+        EXPECT_THROW(binary_read<std::uint16_t>(s), bmp::binary_io_error);
+    }
+
+    std::stringstream plain;
+    binary_write(img.values(), plain);
+    bmp::masked_bitmap<std::uint16_t> img3;
+    EXPECT_THROW(binary_read(img3, plain), bmp::binary_io_error);
+}
+
+TEST(BinaryIOTest, MaskedPixelRWTest) {
+    bitmap<pixel::masked_rgb8u> img(5, 4);
+    std::size_t i = 0;
+    for(auto& v: img) {
+        auto const c = static_cast<std::uint8_t>(i);
+        v = {{c, static_cast<std::uint8_t>(c * 2), static_cast<std::uint8_t>(c * 3)}, i++ % 4 == 0};
+    }
+
+    std::stringstream s;
+    binary_write(img, s);
+    EXPECT_EQ(binary_read<pixel::masked_rgb8u>(s), img);
+}
@@ -0,0 +1,80 @@
+#include <bitmap/binary_probe.hpp>
+#include <bitmap/binary_write.hpp>
+#include <bitmap/pixel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+
+using bmp::binary_probe;
+using bmp::binary_value_type;
+using bmp::bitmap;
+
+
+namespace {
+
+
+    std::filesystem::path temp_directory(std::string const& name) {
+        auto const path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        return path;
+    }
+
+
+}
+
+
+TEST(BinaryProbeTest, Probe) {
+    auto const directory = temp_directory("bitmap_binary_probe_test");
+    auto const filename = (directory / "a.bbf").string();
+    bmp::binary_write(bitmap<bmp::pixel::rgb16u>(7, 5), filename, std::endian::big);
+
+    auto const header = binary_probe(filename);
+    EXPECT_EQ(header.version, 0);
+    EXPECT_EQ(header.channel_size, 2);
+    EXPECT_EQ(header.channel_count, 3);
+    EXPECT_EQ(header.w, 7);
+    EXPECT_EQ(header.h, 5);
+    EXPECT_EQ(bmp::binary_type(header), binary_value_type::unsigned_integer);
+    EXPECT_EQ(bmp::binary_endianness(header), std::endian::big);
+
+    std::ofstream((directory / "b.txt").string()) << "no bitmap";
+    EXPECT_THROW(binary_probe((directory / "b.txt").string()), bmp::binary_io_error);
+    EXPECT_THROW(binary_probe((directory / "missing.bbf").string()), bmp::binary_io_error);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(BinaryProbeTest, Directory) {
+    auto const directory = temp_directory("bitmap_binary_probe_directory_test");
+    std::filesystem::create_directory(directory / "sub");
+    for(std::size_t i = 0; i < 20; ++i) {
+        bmp::binary_write(bitmap<float>(i, 2 * i), (directory / ("f" + std::to_string(100 + i) + ".bbf")).string());
+    }
+    bmp::binary_write(bitmap<std::int8_t>(3, 4), (directory / "sub" / "s.bbf").string(), bmp::binary_compression{});
+    std::ofstream((directory / "x.bbf").string()) << "bbf";
+
+    auto const results = bmp::binary_probe_directory(directory, {false, ".bbf", 4});
+    ASSERT_EQ(results.size(), 21);
+    for(std::size_t i = 0; i < 20; ++i) {
+        ASSERT_TRUE(results[i].valid()) << results[i].error;
+        EXPECT_EQ(results[i].header.w, i);
+        EXPECT_EQ(results[i].header.h, 2 * i);
+        EXPECT_EQ(bmp::binary_type(results[i].header), binary_value_type::floating_point);
+    }
+    EXPECT_FALSE(results[20].valid());
+
+    auto const recursive = bmp::binary_probe_directory(directory, {true, ".bbf"});
+    ASSERT_EQ(recursive.size(), 22);
+    auto const sub = std::find_if(recursive.begin(), recursive.end(), [](auto const& result) {
+        return result.filename.find("s.bbf") != std::string::npos;
+    });
+    ASSERT_NE(sub, recursive.end());
+    EXPECT_EQ(sub->header.version, 1);
+    EXPECT_EQ(bmp::binary_type(sub->header), binary_value_type::signed_integer);
+
+    std::filesystem::remove_all(directory);
+}
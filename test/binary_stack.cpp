@@ -0,0 +1,115 @@
+#include <bitmap/binary_stack.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "test_images.hpp"
+
+
+using bmp::binary_stack_reader;
+using bmp::binary_stack_writer;
+using bmp::bitmap;
+using bmp::bitmap_vector;
+
+
+TEST(BinaryStackTest, WriteRead) {
+    auto const filename = temp_file("bitmap_binary_stack_test.bbs");
+    auto const frames = make_ramp_frames(7, 33, 21);
+
+    for(auto const codec: {bmp::binary_codec::none, bmp::binary_codec::lz4}) {
+        for(auto const endianness: {std::endian::little, std::endian::big}) {
+            bmp::binary_write_stack(frames, filename, {codec, true, true}, endianness);
+
+            binary_stack_reader<std::uint16_t> reader(filename);
+            EXPECT_EQ(reader.frame_count(), 7);
+            EXPECT_EQ(reader.frame_size(), bmp::size<std::size_t>(33, 21));
+            EXPECT_EQ(reader.read(5), frames[5]);
+            EXPECT_EQ(reader.read_all(3), frames);
+            EXPECT_THROW(reader.read(7), std::out_of_range);
+        }
+    }
+
+    EXPECT_THROW(binary_stack_reader<float>{filename}, bmp::binary_io_error);
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryStackTest, Appender) {
+    auto const filename = temp_file("bitmap_binary_stack_append_test.bbs");
+    auto const frames = make_ramp_frames(4, 16, 9);
+
+    {
+        binary_stack_writer<std::uint16_t> writer(filename, 16, 9);
+        EXPECT_EQ(writer.append(frames[0]), 0);
+        EXPECT_EQ(writer.append(frames[1]), 1);
+        EXPECT_THROW(writer.append(bitmap<std::uint16_t>(9, 16)), std::invalid_argument);
+
+        // raw frames of a stack that is not closed yet are found by the file size
+        binary_stack_reader<std::uint16_t> reader(filename);
+        EXPECT_EQ(reader.frame_count(), 2);
+        EXPECT_EQ(reader.read(1), frames[1]);
+
+        std::thread a([&] { writer.append(frames[2]); });
+        std::thread b([&] { writer.append(frames[3]); });
+        a.join();
+        b.join();
+        EXPECT_EQ(writer.frame_count(), 4);
+    }
+
+    auto const result = bmp::binary_read_stack<std::uint16_t>(filename);
+    ASSERT_EQ(result.size(), 4);
+    EXPECT_EQ(result[0], frames[0]);
+    EXPECT_EQ(result[1], frames[1]);
+    EXPECT_TRUE((result[2] == frames[2] && result[3] == frames[3]) || (result[2] == frames[3] && result[3] == frames[2]));
+
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryStackTest, Bool) {
+    auto const filename = temp_file("bitmap_binary_stack_bool_test.bbs");
+    bitmap_vector<bool> frames(3, bitmap<bool>(13, 5));
+    frames[1](3, 4) = true;
+    frames[2](12, 0) = true;
+
+    bmp::binary_write_stack(frames, filename, {bmp::binary_codec::lz4});
+    EXPECT_EQ(bmp::binary_read_stack<bool>(filename, true, 2), frames);
+
+    bmp::binary_write_stack(bitmap_vector<bool>(), filename);
+    EXPECT_EQ(bmp::binary_read_stack<bool>(filename), bitmap_vector<bool>());
+
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryStackTest, Corrupt) {
+    auto const filename = temp_file("bitmap_binary_stack_corrupt_test.bbs");
+    bmp::binary_write_stack(make_ramp_frames(3, 20, 10), filename, {bmp::binary_codec::lz4});
+
+    std::string data;
+    {
+        std::ifstream is(filename, std::ios_base::binary);
+        data.assign(std::istreambuf_iterator<char>(is), {});
+    }
+
+    for(std::size_t i = 0; i < data.size(); i += 3) {
+        if(i >= 32 && i < 48) {
+            // a corrupt frame size is only detected when the frame doesn't fit into memory
+            continue;
+        }
+
+        auto corrupt = data;
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x5A);
+        std::ofstream(filename, std::ios_base::binary).write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+        try {
+            // either detected or decoded to some frames, but never out of bounds
+            bmp::binary_read_stack<std::uint16_t>(filename);
+        } catch(bmp::binary_io_error const&) {
+        }
+    }
+
+    std::ofstream(filename, std::ios_base::binary).write(data.data(), 30);
+    EXPECT_THROW(bmp::binary_read_stack<std::uint16_t>(filename), bmp::binary_io_error);
+
+    std::filesystem::remove(filename);
+}
@@ -0,0 +1,120 @@
+#include <bitmap/binary_tiled.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "test_images.hpp"
+
+
+using bmp::binary_tile_reader;
+using bmp::binary_tile_writer;
+using bmp::binary_tiling;
+using bmp::bitmap;
+using bmp::rect;
+
+
+TEST(BinaryTiledTest, WriteRead) {
+    auto const filename = temp_file("bitmap_binary_tiled_test.bbf");
+    auto const image = make_ramp_image(100, 70);
+    bmp::binary_write_tiled(image, filename, binary_tiling{32, 16, 3, {bmp::binary_codec::lz4, true, true, 0, 2}});
+
+    // binary_read reads the full resolution
+    EXPECT_EQ(bmp::binary_read<std::uint16_t>(filename), image);
+
+    binary_tile_reader<std::uint16_t> reader(filename);
+    ASSERT_EQ(reader.levels(), 3);
+    EXPECT_EQ(reader.level_size(1), bmp::size<std::size_t>(50, 35));
+    EXPECT_EQ(reader.level_size(2), bmp::size<std::size_t>(25, 18));
+    EXPECT_EQ(reader.tiles_x(0), 4);
+    EXPECT_EQ(reader.tiles_y(0), 5);
+    EXPECT_EQ(reader.tile_rect(0, 3, 4), rect<std::size_t>(96, 64, 4, 6));
+
+    EXPECT_EQ(reader.read_tile(0, 3, 4), bmp::subbitmap(image, rect<std::size_t>(96, 64, 4, 6)));
+    EXPECT_EQ(reader.read(0, rect<std::size_t>(13, 9, 60, 40), 3), bmp::subbitmap(image, rect<std::size_t>(13, 9, 60, 40)));
+    EXPECT_EQ(reader.read(0, 2), image);
+
+    auto const level1 = reader.read(1);
+    EXPECT_EQ(level1(3, 2), static_cast<std::uint16_t>((image(6, 4) + image(7, 4) + image(6, 5) + image(7, 5) + 2) / 4));
+
+    // the levels are the ones of a box filtered pyramid
+    bmp::pyramid<std::uint16_t> const pyramid(image, {bmp::pyramid_filter::box, 3});
+    EXPECT_EQ(level1, pyramid.level(1));
+    EXPECT_EQ(reader.read(2), pyramid.level(2));
+
+    EXPECT_THROW(reader.read_tile(3, 0, 0), std::out_of_range);
+    EXPECT_THROW(reader.read_tile(0, 4, 0), std::out_of_range);
+    EXPECT_THROW(reader.read(0, rect<std::size_t>(90, 0, 11, 1)), std::out_of_range);
+    EXPECT_THROW(binary_tile_reader<float>{filename}, bmp::binary_io_error);
+
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryTiledTest, WriterAnyOrder) {
+    auto const filename = temp_file("bitmap_binary_tiled_writer_test.bbf");
+    auto const image = make_ramp_image(64, 64);
+    {
+        binary_tile_writer<std::uint16_t> writer(filename, 64, 64, binary_tiling{16, 16});
+        std::vector<std::thread> threads;
+        for(std::size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                // bottom up, the last column is left out
+                for(std::size_t ty = 4; ty-- > 0;) {
+                    if(t < 3) {
+                        writer.write_tile(0, t, ty, bmp::subbitmap(image, writer.tile_rect(0, t, ty)));
+                    }
+                }
+            });
+        }
+        for(auto& thread: threads) {
+            thread.join();
+        }
+        EXPECT_THROW(writer.write_tile(0, 0, 0, bitmap<std::uint16_t>(3, 3)), std::invalid_argument);
+    }
+
+    binary_tile_reader<std::uint16_t> reader(filename);
+    EXPECT_TRUE(reader.has_tile(0, 2, 3));
+    EXPECT_FALSE(reader.has_tile(0, 3, 0));
+    EXPECT_EQ(reader.read(0, rect<std::size_t>(0, 0, 48, 64)), bmp::subbitmap(image, rect<std::size_t>(0, 0, 48, 64)));
+    EXPECT_EQ(reader.read_tile(0, 3, 1), bitmap<std::uint16_t>(16, 16));
+
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryTiledTest, Bool) {
+    auto const filename = temp_file("bitmap_binary_tiled_bool_test.bbf");
+    bitmap<bool> image(37, 23);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        *(image.begin() + static_cast<std::ptrdiff_t>(i)) = i % 3 == 0;
+    }
+    bmp::binary_write_tiled(image, filename, binary_tiling{8, 8, 2}, std::endian::big);
+
+    EXPECT_EQ(bmp::binary_read<bool>(filename), image);
+    binary_tile_reader<bool> reader(filename);
+    EXPECT_EQ(reader.read(0, rect<std::size_t>(5, 3, 20, 17), 4), bmp::subbitmap(image, rect<std::size_t>(5, 3, 20, 17)));
+
+    std::filesystem::remove(filename);
+}
+
+TEST(BinaryTiledTest, CorruptTileSize) {
+    auto const filename = temp_file("bitmap_binary_tiled_corrupt_test.bbf");
+    auto const image = make_ramp_image(200, 10);
+    bmp::binary_write_tiled(image, filename, binary_tiling{16, 16});
+    {
+        // size of the first tile behind the common header, the tiled header and its offset,
+        // 1000 bytes are inside of the file but more than any 16x10 tile needs
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(24 + 16 + 8);
+        char const size[8] = {0, 0, 0, 0, 0, 0, 0x03, char(0xe8)};
+        file.write(size, sizeof(size));
+    }
+
+    EXPECT_THROW(bmp::binary_read<std::uint16_t>(filename), bmp::binary_io_error);
+    binary_tile_reader<std::uint16_t> reader(filename);
+    EXPECT_THROW(reader.read_tile(0, 0, 0), bmp::binary_io_error);
+    EXPECT_EQ(reader.read_tile(0, 1, 0), bmp::subbitmap(image, rect<std::size_t>(16, 0, 16, 10)));
+
+    std::filesystem::remove(filename);
+}
@@ -0,0 +1,98 @@
+#include <bitmap/color.hpp>
+
+#include <gtest/gtest.h>
+
+
+using bmp::bayer_pattern;
+using bmp::bitmap;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    /// \brief Keep only the color of the filter array at every pixel
+    bitmap<std::uint16_t> mosaic(bitmap<pixel::rgb16u> const& image, bayer_pattern const pattern) {
+        char const* const names[] = {"RGGB", "BGGR", "GRBG", "GBRG"};
+        auto const name = names[static_cast<std::size_t>(pattern)];
+
+        bitmap<std::uint16_t> raw(image.size());
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                auto const& v = image(x, y);
+                switch(name[(y % 2) * 2 + x % 2]) {
+                case 'R':
+                    raw(x, y) = v.r;
+                    break;
+                case 'G':
+                    raw(x, y) = v.g;
+                    break;
+                default:
+                    raw(x, y) = v.b;
+                }
+            }
+        }
+        return raw;
+    }
+
+
+}
+
+
+TEST(ColorTest, Gray) {
+    bitmap<pixel::rgb8u> rgb(3, 1);
+    rgb(0, 0) = {255, 255, 255};
+    rgb(1, 0) = {255, 0, 0};
+    rgb(2, 0) = {0, 0, 255};
+    EXPECT_EQ(bmp::to_gray(rgb), (bitmap<std::uint8_t>({{255, 76, 29}})));
+    EXPECT_EQ(bmp::to_gray(rgb, bmp::bt709_weights), (bitmap<std::uint8_t>({{255, 54, 18}})));
+
+    auto const rgba = bmp::to_rgba(rgb, std::uint8_t(7));
+    EXPECT_EQ(rgba(1, 0), (pixel::rgba8u{255, 0, 0, 7}));
+    EXPECT_EQ(bmp::to_rgb(rgba), rgb);
+    EXPECT_EQ(bmp::to_gray(rgba), bmp::to_gray(rgb));
+
+    auto const ga = bmp::to_ga(rgba);
+    EXPECT_EQ(ga(1, 0), (pixel::ga8u{76, 7}));
+    EXPECT_EQ(bmp::to_rgba(ga)(1, 0), (pixel::rgba8u{76, 76, 76, 7}));
+    EXPECT_EQ(bmp::to_rgb(ga)(2, 0), (pixel::rgb8u{29, 29, 29}));
+    EXPECT_EQ(bmp::to_gray(ga), bmp::to_gray(rgb));
+
+    bitmap<float> gray({{0.5f, 1.f}});
+    EXPECT_EQ(bmp::to_rgb(gray)(0, 0), (pixel::rgb32f{0.5f, 0.5f, 0.5f}));
+    EXPECT_EQ(bmp::to_rgba(gray, 1.f)(1, 0), (pixel::rgba32f{1.f, 1.f, 1.f, 1.f}));
+    EXPECT_EQ(bmp::to_ga(gray, 0.f)(0, 0), (pixel::ga32f{0.5f, 0.f}));
+}
+
+TEST(ColorTest, DemosaicConstant) {
+    bitmap<pixel::rgb16u> const image(9, 7, {100, 2000, 30000});
+    for(auto const pattern: {bayer_pattern::rggb, bayer_pattern::bggr, bayer_pattern::grbg, bayer_pattern::gbrg}) {
+        EXPECT_EQ(bmp::demosaic(mosaic(image, pattern), pattern), image);
+    }
+}
+
+TEST(ColorTest, DemosaicGradient) {
+    bitmap<pixel::rgb16u> image(150, 140);
+    for(std::size_t y = 0; y < image.h(); ++y) {
+        for(std::size_t x = 0; x < image.w(); ++x) {
+            image(x, y) = {
+                static_cast<std::uint16_t>(x * 4), static_cast<std::uint16_t>(1000 + y * 8),
+                static_cast<std::uint16_t>(x * 2 + y * 2)};
+        }
+    }
+
+    for(auto const pattern: {bayer_pattern::rggb, bayer_pattern::bggr, bayer_pattern::grbg, bayer_pattern::gbrg}) {
+        auto const result = bmp::demosaic(mosaic(image, pattern), pattern, 3);
+        ASSERT_EQ(result.size(), image.size());
+
+        // bilinear interpolation is exact for linear gradients, only the mirrored border differs
+        for(std::size_t y = 1; y + 1 < image.h(); ++y) {
+            for(std::size_t x = 1; x + 1 < image.w(); ++x) {
+                ASSERT_EQ(result(x, y), image(x, y)) << x << ", " << y;
+            }
+        }
+    }
+
+    EXPECT_THROW(bmp::demosaic(bitmap<std::uint16_t>(1, 5), bayer_pattern::rggb), std::invalid_argument);
+    EXPECT_EQ(bmp::demosaic(bitmap<std::uint16_t>(), bayer_pattern::rggb), bitmap<pixel::rgb16u>());
+}
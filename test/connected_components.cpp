@@ -0,0 +1,133 @@
+#include <bitmap/connected_components.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "test_images.hpp"
+
+
+using bmp::bitmap;
+using bmp::bitmask;
+using bmp::component_options;
+using bmp::connectivity;
+using bmp::rect;
+
+
+namespace {
+
+
+    /// \brief Flood fill labels, numbered in raster order of the first pixel
+    bitmap<std::uint32_t> reference_labels(bitmap<std::uint8_t> const& image, connectivity neighbors) {
+        bitmap<std::uint32_t> labels(image.size());
+        std::uint32_t count = 0;
+        std::vector<std::pair<std::size_t, std::size_t>> stack;
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                if(image(x, y) == 0 || labels(x, y) != 0) {
+                    continue;
+                }
+
+                labels(x, y) = ++count;
+                stack.emplace_back(x, y);
+                while(!stack.empty()) {
+                    auto const [px, py] = stack.back();
+                    stack.pop_back();
+                    for(int dy = -1; dy <= 1; ++dy) {
+                        for(int dx = -1; dx <= 1; ++dx) {
+                            if((dx == 0 && dy == 0) || (neighbors == connectivity::four && dx != 0 && dy != 0)) {
+                                continue;
+                            }
+                            auto const nx = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(px) + dx);
+                            auto const ny = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(py) + dy);
+                            if(nx < image.w() && ny < image.h() && image(nx, ny) != 0 && labels(nx, ny) == 0) {
+                                labels(nx, ny) = count;
+                                stack.emplace_back(nx, ny);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return labels;
+    }
+
+    bitmask to_mask(bitmap<std::uint8_t> const& image) {
+        bitmask mask(image.size());
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                mask.set(x, y, image(x, y) != 0);
+            }
+        }
+        return mask;
+    }
+
+
+}
+
+
+TEST(ConnectedComponentsTest, Labels) {
+    for(auto const& [w, h]: {std::pair<std::size_t, std::size_t>{1, 1}, {17, 9}, {64, 70}, {131, 200}}) {
+        auto const image = make_blob_image(w, h);
+        auto const mask = to_mask(image);
+        for(auto const neighbors: {connectivity::four, connectivity::eight}) {
+            auto const reference = reference_labels(image, neighbors);
+            for(std::size_t threads: {1, 4}) {
+                component_options const options{neighbors, threads};
+                auto const result = bmp::connected_components(image, options);
+                EXPECT_EQ(result.labels, reference) << w << "x" << h << " " << threads;
+                EXPECT_EQ(bmp::connected_components(mask, options).labels, reference) << w << "x" << h;
+            }
+        }
+    }
+}
+
+TEST(ConnectedComponentsTest, Stats) {
+    bitmap<bool> image(10, 8);
+    // an L shape
+    for(std::size_t y = 1; y < 5; ++y) {
+        image(2, y) = true;
+    }
+    image(3, 4) = true;
+    image(4, 4) = true;
+    // a single pixel touching the L only diagonally
+    image(5, 5) = true;
+    // a 2x2 square
+    image(8, 0) = image(9, 0) = image(8, 1) = image(9, 1) = true;
+
+    auto const eight = bmp::connected_components(image);
+    ASSERT_EQ(eight.components.size(), 2);
+    EXPECT_EQ(eight.components[0].label, 1);
+    EXPECT_EQ(eight.components[0].area, 4);
+    EXPECT_EQ(eight.components[0].bounds, rect<std::size_t>(8, 0, 2, 2));
+    EXPECT_DOUBLE_EQ(eight.components[0].centroid.x(), 8.5);
+    EXPECT_DOUBLE_EQ(eight.components[0].centroid.y(), 0.5);
+    EXPECT_EQ(eight.components[1].area, 7);
+    EXPECT_EQ(eight.components[1].bounds, rect<std::size_t>(2, 1, 4, 5));
+    EXPECT_DOUBLE_EQ(eight.components[1].centroid.x(), 20. / 7);
+    EXPECT_DOUBLE_EQ(eight.components[1].centroid.y(), 23. / 7);
+    EXPECT_EQ(eight.labels(5, 5), 2);
+    EXPECT_EQ(eight.labels(0, 0), 0);
+
+    auto const four = bmp::connected_components(image, {connectivity::four});
+    ASSERT_EQ(four.components.size(), 3);
+    EXPECT_EQ(four.components[1].area, 6);
+    EXPECT_EQ(four.components[2].area, 1);
+    EXPECT_EQ(four.components[2].bounds, rect<std::size_t>(5, 5, 1, 1));
+    EXPECT_EQ(four.labels(5, 5), 3);
+}
+
+TEST(ConnectedComponentsTest, Uniform) {
+    // one component spanning all thread bands and whole words
+    bitmask const full(150, 300, true);
+    auto const result = bmp::connected_components(full, {connectivity::four, 4});
+    ASSERT_EQ(result.components.size(), 1);
+    EXPECT_EQ(result.components[0].area, 45000);
+    EXPECT_EQ(result.components[0].bounds, rect<std::size_t>(0, 0, 150, 300));
+    EXPECT_EQ(result.labels, bitmap<std::uint32_t>(150, 300, 1));
+
+    EXPECT_TRUE(bmp::connected_components(bitmask(150, 300)).components.empty());
+    EXPECT_TRUE(bmp::connected_components(bitmap<std::uint8_t>()).labels.empty());
+}
@@ -0,0 +1,72 @@
+#include <bitmap/convert.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+
+using bmp::bitmap;
+using bmp::convert;
+using bmp::convert_options;
+namespace pixel = bmp::pixel;
+
+
+TEST(ConvertTest, Widening) {
+    bitmap<std::uint8_t> image(300, 7);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        image.data()[i] = static_cast<std::uint8_t>(i);
+    }
+
+    auto const u16 = convert<std::uint16_t>(image);
+    auto const f32 = convert<float>(image);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        EXPECT_EQ(u16.data()[i], image.data()[i]);
+        EXPECT_EQ(f32.data()[i], static_cast<float>(image.data()[i]));
+    }
+
+    // 8 to 16 bit full range
+    auto const scaled = convert<std::uint16_t>(image, {257});
+    EXPECT_EQ(scaled(255, 0), 65535);
+    EXPECT_EQ(scaled(1, 0), 257);
+}
+
+TEST(ConvertTest, Saturation) {
+    bitmap<float> image(6, 1);
+    image(0, 0) = -3.f;
+    image(1, 0) = 1.5f;
+    image(2, 0) = 2.49f;
+    image(3, 0) = 254.6f;
+    image(4, 0) = 1000.f;
+    image(5, 0) = std::numeric_limits<float>::quiet_NaN();
+
+    auto const rounded = convert<std::uint8_t>(image);
+    EXPECT_EQ(rounded, (bitmap<std::uint8_t>({{0, 2, 2, 255, 255, 0}})));
+
+    auto const truncated = convert<std::uint8_t>(image, {1, 0, false});
+    EXPECT_EQ(truncated, (bitmap<std::uint8_t>({{0, 1, 2, 254, 255, 0}})));
+
+    auto const signed_result = convert<std::int8_t>(image, {1, -130});
+    EXPECT_EQ(signed_result, (bitmap<std::int8_t>({{-128, -128, -128, 125, 127, -128}})));
+
+    bitmap<std::int64_t> large(2, 1);
+    large(0, 0) = std::numeric_limits<std::int64_t>::max();
+    large(1, 0) = -5;
+    EXPECT_EQ(convert<std::uint32_t>(large), (bitmap<std::uint32_t>({{0xFFFFFFFF, 0}})));
+}
+
+TEST(ConvertTest, Pixel) {
+    bitmap<pixel::rgb16u> image(200, 300, {0, 32768, 65535});
+    bitmap<pixel::rgb32f> target(200, 300);
+    auto const data = target.data();
+
+    convert(image, target, {1. / 65535, 0, true, true, 3});
+    EXPECT_EQ(target.data(), data);
+    EXPECT_EQ(target(199, 299), (pixel::rgb32f{0.f, 32768.f / 65535.f, 1.f}));
+
+    auto const back = convert<std::uint16_t>(target, {65535});
+    EXPECT_EQ(back, image);
+
+    bitmap<pixel::rgb8u> empty;
+    EXPECT_EQ(convert<float>(empty), bitmap<pixel::rgb32f>());
+}
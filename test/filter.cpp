@@ -0,0 +1,195 @@
+#include <bitmap/filter.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include "test_images.hpp"
+
+
+using bmp::bitmap;
+using bmp::border_mode;
+using bmp::filter_options;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    /// \brief Direct 2D correlation with the outer product of kernel_x and kernel_y
+    bitmap<double> reference_filter(
+        bitmap<double> const& image,
+        std::vector<double> const& kernel_x,
+        std::vector<double> const& kernel_y,
+        filter_options const& options) {
+        auto const rx = static_cast<std::ptrdiff_t>(kernel_x.size() / 2);
+        auto const ry = static_cast<std::ptrdiff_t>(kernel_y.size() / 2);
+        bitmap<double> result(image.size());
+        for(std::ptrdiff_t y = 0; y < image.sh(); ++y) {
+            for(std::ptrdiff_t x = 0; x < image.sw(); ++x) {
+                double sum = 0;
+                for(std::ptrdiff_t j = -ry; j <= ry; ++j) {
+                    for(std::ptrdiff_t i = -rx; i <= rx; ++i) {
+                        auto const sx = bmp::detail::border_index(x + i, image.sw(), options.border);
+                        auto const sy = bmp::detail::border_index(y + j, image.sh(), options.border);
+                        auto const v = sx < 0 || sy < 0
+                            ? options.border_value
+                            : image(static_cast<std::size_t>(sx), static_cast<std::size_t>(sy));
+                        sum += kernel_x[static_cast<std::size_t>(i + rx)] * kernel_y[static_cast<std::size_t>(j + ry)] * v;
+                    }
+                }
+                result(static_cast<std::size_t>(x), static_cast<std::size_t>(y)) = sum;
+            }
+        }
+        return result;
+    }
+
+    void expect_near(bitmap<double> const& a, bitmap<double> const& b, double const tolerance) {
+        ASSERT_EQ(a.size(), b.size());
+        for(std::size_t i = 0; i < a.point_count(); ++i) {
+            ASSERT_NEAR(a.data()[i], b.data()[i], tolerance) << "index " << i;
+        }
+    }
+
+
+}
+
+
+TEST(FilterTest, BorderIndex) {
+    using bmp::detail::border_index;
+    EXPECT_EQ(border_index(-2, 4, border_mode::replicate), 0);
+    EXPECT_EQ(border_index(5, 4, border_mode::replicate), 3);
+    EXPECT_EQ(border_index(-1, 4, border_mode::reflect), 0);
+    EXPECT_EQ(border_index(-3, 4, border_mode::reflect), 2);
+    EXPECT_EQ(border_index(4, 4, border_mode::reflect), 3);
+    EXPECT_EQ(border_index(-1, 4, border_mode::reflect_101), 1);
+    EXPECT_EQ(border_index(5, 4, border_mode::reflect_101), 1);
+    EXPECT_EQ(border_index(9, 4, border_mode::reflect_101), 3);
+    EXPECT_EQ(border_index(-1, 1, border_mode::reflect_101), 0);
+    EXPECT_EQ(border_index(-1, 4, border_mode::wrap), 3);
+    EXPECT_EQ(border_index(9, 4, border_mode::wrap), 1);
+    EXPECT_EQ(border_index(-1, 4, border_mode::constant), -1);
+    EXPECT_EQ(border_index(2, 4, border_mode::constant), 2);
+}
+
+TEST(FilterTest, Separable) {
+    auto const image = make_smooth_image(37, 23);
+    std::vector<double> const kernel_x{0.1, -0.5, 2, 0.7, 0.2};
+    std::vector<double> const kernel_y{0.25, 0.5, 0.25};
+
+    for(auto const border:
+        {border_mode::replicate, border_mode::reflect, border_mode::reflect_101, border_mode::wrap, border_mode::constant}) {
+        filter_options const options{border, 7.5, 3};
+        expect_near(
+            bmp::separable_filter(image, kernel_x, kernel_y, options),
+            reference_filter(image, kernel_x, kernel_y, options),
+            1e-9);
+    }
+
+    // kernels larger than the image
+    auto const small = make_smooth_image(3, 2);
+    auto const kernel = bmp::gaussian_kernel(2);
+    expect_near(bmp::separable_filter(small, kernel, kernel), reference_filter(small, kernel, kernel, {}), 1e-9);
+
+    EXPECT_THROW(bmp::separable_filter(image, {0.5, 0.5}, {1}), std::invalid_argument);
+}
+
+TEST(FilterTest, GaussianKernel) {
+    auto const kernel = bmp::gaussian_kernel(1.5);
+    ASSERT_EQ(kernel.size(), 11);
+    double sum = 0;
+    for(auto const v: kernel) {
+        sum += v;
+    }
+    EXPECT_NEAR(sum, 1, 1e-12);
+    EXPECT_DOUBLE_EQ(kernel[3], kernel[7]);
+    EXPECT_GT(kernel[5], kernel[4]);
+    EXPECT_EQ(bmp::gaussian_kernel(0), std::vector<double>{1});
+    EXPECT_EQ(bmp::gaussian_kernel(1, 2).size(), 5);
+    EXPECT_THROW(bmp::gaussian_kernel(-1), std::invalid_argument);
+}
+
+TEST(FilterTest, Box) {
+    auto const image = make_smooth_image(41, 29);
+    for(auto const border: {border_mode::replicate, border_mode::reflect_101, border_mode::constant}) {
+        filter_options const options{border, -3, 2};
+        std::vector<double> const kernel_x(7, 1. / 7);
+        std::vector<double> const kernel_y(3, 1. / 3);
+        expect_near(bmp::box_filter(image, 3, 1, options), reference_filter(image, kernel_x, kernel_y, options), 1e-9);
+    }
+
+    // radii larger than the thread bands and the image
+    auto const tall = make_smooth_image(9, 300);
+    for(auto const radius_y: {std::size_t(100), std::size_t(400)}) {
+        for(std::size_t threads: {1, 3}) {
+            filter_options const options{border_mode::reflect, 0, threads};
+            std::vector<double> const kernel_y(2 * radius_y + 1, 1. / static_cast<double>(2 * radius_y + 1));
+            std::vector<double> const kernel_x(3, 1. / 3);
+            expect_near(
+                bmp::box_filter(tall, 1, radius_y, options), reference_filter(tall, kernel_x, kernel_y, options), 1e-9);
+        }
+    }
+
+    // integral types are rounded
+    bitmap<std::uint16_t> steps({{0, 0, 3, 3}});
+    EXPECT_EQ(bmp::box_filter(steps, 1, 0, {border_mode::replicate}), (bitmap<std::uint16_t>({{0, 1, 2, 3}})));
+
+    bitmap<pixel::rgb8u> color(5, 5, {10, 20, 30});
+    EXPECT_EQ(bmp::box_filter(color, 2), color);
+}
+
+TEST(FilterTest, Gaussian) {
+    auto const image = make_smooth_image(60, 50);
+    filter_options const options{border_mode::reflect_101, 0, 2};
+
+    // small sigma is the sampled kernel
+    auto const kernel = bmp::gaussian_kernel(1.2);
+    expect_near(bmp::gaussian_filter(image, 1.2, options), reference_filter(image, kernel, kernel, options), 1e-9);
+
+    // large sigma is recursive, it differs from the sampled kernel cut off at 3 sigma by about 0.1 %
+    // of the value range
+    auto const large = bmp::gaussian_kernel(6);
+    auto const reference = reference_filter(image, large, large, options);
+    expect_near(bmp::gaussian_filter(image, 6, options), reference, 0.2);
+    expect_near(bmp::gaussian_filter(image, 6, 1.2, options), reference_filter(image, large, kernel, options), 0.2);
+    expect_near(bmp::gaussian_filter(image, 1.2, 6, options), reference_filter(image, kernel, large, options), 0.2);
+
+    // the recursive impulse response is within 0.05 % of the peak of the sampled kernel
+    for(auto const sigma: {4., 10., 30.}) {
+        auto const radius = static_cast<std::size_t>(std::ceil(8 * sigma));
+        auto const sampled = bmp::gaussian_kernel(sigma, radius);
+        auto const peak = sampled[radius];
+        bitmap<double> row(2 * radius + 1, 1);
+        bitmap<double> column(1, 2 * radius + 1);
+        row(radius, 0) = 1;
+        column(0, radius) = 1;
+        filter_options const zero{border_mode::constant, 0, 1};
+        auto const row_result = bmp::gaussian_filter(row, sigma, 0, zero);
+        auto const column_result = bmp::gaussian_filter(column, 0, sigma, zero);
+        for(std::size_t i = 0; i < sampled.size(); ++i) {
+            EXPECT_NEAR(row_result(i, 0), sampled[i], 5e-4 * peak) << sigma << " " << i;
+            EXPECT_NEAR(column_result(0, i), sampled[i], 5e-4 * peak) << sigma << " " << i;
+        }
+    }
+
+    // a constant image stays constant
+    bitmap<float> constant(30, 20, 4.f);
+    for(auto const sigma: {0.5, 2., 9.}) {
+        for(auto const v: bmp::gaussian_filter(constant, sigma)) {
+            EXPECT_NEAR(v, 4.f, 1e-4f);
+        }
+    }
+
+    // threads give the same result
+    bitmap<std::uint16_t> u16(70, 45);
+    for(std::size_t i = 0; i < u16.point_count(); ++i) {
+        u16.data()[i] = static_cast<std::uint16_t>(i * 977);
+    }
+    for(auto const sigma: {1.5, 5.}) {
+        EXPECT_EQ(bmp::gaussian_filter(u16, sigma, {border_mode::reflect_101, 0, 1}),
+            bmp::gaussian_filter(u16, sigma, {border_mode::reflect_101, 0, 4}));
+    }
+
+    EXPECT_THROW(bmp::gaussian_filter(image, -1.), std::invalid_argument);
+}
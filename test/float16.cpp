@@ -0,0 +1,139 @@
+#include <bitmap/binary_read.hpp>
+#include <bitmap/binary_write.hpp>
+#include <bitmap/convert.hpp>
+#include <bitmap/float16.hpp>
+#include <bitmap/histogram.hpp>
+#include <bitmap/subbitmap.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+
+using bmp::bfloat16;
+using bmp::bitmap;
+using bmp::float16;
+namespace pixel = bmp::pixel;
+
+
+TEST(Float16Test, ExactValues) {
+    for(float const v: {0.f, 1.f, -1.f, 0.5f, 2048.f, 65504.f, -65504.f, 0.000061035156f}) {
+        EXPECT_EQ(static_cast<float>(float16(v)), v);
+    }
+
+    EXPECT_EQ(float16(1.f).bits(), 0x3C00);
+    EXPECT_EQ(float16(-2.f).bits(), 0xC000);
+    EXPECT_EQ(float16(65504.f).bits(), 0x7BFF);
+    EXPECT_EQ(std::numeric_limits<float16>::max(), float16(65504.f));
+    EXPECT_EQ(std::numeric_limits<float16>::lowest(), float16(-65504.f));
+}
+
+TEST(Float16Test, Rounding) {
+    // 2049 is halfway between 2048 and 2050, ties to even
+    EXPECT_EQ(static_cast<float>(float16(2049.f)), 2048.f);
+    EXPECT_EQ(static_cast<float>(float16(2051.f)), 2052.f);
+    EXPECT_EQ(static_cast<float>(float16(2050.9f)), 2050.f);
+
+    // smallest subnormal and underflow
+    EXPECT_EQ(float16(std::ldexp(1.f, -24)).bits(), 0x0001);
+    EXPECT_EQ(float16(std::ldexp(1.f, -26)).bits(), 0x0000);
+    EXPECT_EQ(static_cast<float>(float16::from_bits(0x0001)), std::ldexp(1.f, -24));
+    EXPECT_EQ(static_cast<float>(float16::from_bits(0x03FF)), std::ldexp(1023.f, -24));
+}
+
+TEST(Float16Test, Special) {
+    EXPECT_EQ(float16(70000.f).bits(), 0x7C00);
+    EXPECT_EQ(float16(-std::numeric_limits<float>::infinity()).bits(), 0xFC00);
+    EXPECT_TRUE(std::isinf(static_cast<float>(float16::from_bits(0x7C00))));
+    EXPECT_TRUE(std::isnan(static_cast<float>(float16(std::numeric_limits<float>::quiet_NaN()))));
+    EXPECT_FALSE(float16(std::numeric_limits<float>::quiet_NaN()) == float16(std::numeric_limits<float>::quiet_NaN()));
+    EXPECT_EQ(float16::from_bits(0x8000), float16(0.f));
+}
+
+TEST(Float16Test, BFloat16) {
+    EXPECT_EQ(bfloat16(1.f).bits(), 0x3F80);
+    EXPECT_EQ(static_cast<float>(bfloat16(3.f)), 3.f);
+    EXPECT_EQ(static_cast<float>(bfloat16(1e30f)), static_cast<float>(bfloat16::from_bits(0x714A)));
+    // 257 is halfway between 256 and 258, ties to even
+    EXPECT_EQ(static_cast<float>(bfloat16(257.f)), 256.f);
+    EXPECT_EQ(static_cast<float>(bfloat16(259.f)), 260.f);
+    EXPECT_TRUE(std::isnan(static_cast<float>(bfloat16(std::numeric_limits<float>::quiet_NaN()))));
+    EXPECT_TRUE(std::isinf(static_cast<float>(bfloat16(std::numeric_limits<float>::infinity()))));
+}
+
+TEST(Float16Test, BulkMatchesScalar) {
+    std::vector<float16> half(1003);
+    for(std::size_t i = 0; i < half.size(); ++i) {
+        half[i] = float16::from_bits(static_cast<std::uint16_t>(i * 65 + 7));
+    }
+
+    std::vector<float> values(half.size());
+    bmp::detail::float16_to_float(half.data(), values.data(), half.size());
+    for(std::size_t i = 0; i < half.size(); ++i) {
+        auto const expected = static_cast<float>(half[i]);
+        if(std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(values[i]));
+        } else {
+            EXPECT_EQ(values[i], expected) << i;
+        }
+    }
+
+    for(std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(i) * 0.37f - 150.f;
+    }
+    std::vector<float16> back(values.size());
+    bmp::detail::float_to_float16(values.data(), back.data(), values.size());
+    for(std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(back[i].bits(), float16(values[i]).bits()) << i;
+    }
+}
+
+TEST(Float16Test, BinaryReadWrite) {
+    bitmap<float16> image(5, 3);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        image.data()[i] = float16(static_cast<float>(i) * 0.25f - 1.f);
+    }
+
+    for(auto const endian: {std::endian::big, std::endian::little}) {
+        std::stringstream s;
+        bmp::binary_write(image, s, endian);
+        EXPECT_EQ(bmp::binary_read<float16>(s), image);
+
+        s.seekg(0);
+        EXPECT_THROW(bmp::binary_read<bfloat16>(s), std::runtime_error);
+    }
+
+    bitmap<bfloat16> bimage(4, 2, bfloat16(-3.5f));
+    std::stringstream s;
+    bmp::binary_write(bimage, s, std::endian::little);
+    EXPECT_EQ(bmp::binary_read<bfloat16>(s), bimage);
+
+    bitmap<pixel::rgb16f> rgb(2, 2, {float16(1.f), float16(0.5f), float16(-2.f)});
+    std::stringstream rgb_s;
+    bmp::binary_write(rgb, rgb_s);
+    EXPECT_EQ(bmp::binary_read<pixel::rgb16f>(rgb_s), rgb);
+}
+
+TEST(Float16Test, Algorithms) {
+    bitmap<float16> image(4, 1);
+    image(0, 0) = float16(0.f);
+    image(1, 0) = float16(0.5f);
+    image(2, 0) = float16(1.f);
+    image(3, 0) = float16(std::numeric_limits<float>::quiet_NaN());
+
+    auto const hist = bmp::histogram(image, float16(0.f), float16(1.f), 3);
+    EXPECT_EQ(hist, (std::vector<std::size_t>{1, 1, 1}));
+
+    auto const f32 = bmp::convert<float>(image);
+    EXPECT_EQ(f32(1, 0), 0.5f);
+    EXPECT_EQ(bmp::convert<float16>(f32)(2, 0), float16(1.f));
+    EXPECT_EQ(bmp::convert<std::uint8_t>(image, {255})(1, 0), 128);
+    EXPECT_EQ(bmp::convert<float16>(bitmap<std::uint8_t>(2, 1, 200), {0.5})(0, 0), float16(100.f));
+
+    auto const sub = bmp::subbitmap(image, bmp::rect<float, float, std::size_t, std::size_t>(0.5f, 0.f, 2, 1));
+    EXPECT_FLOAT_EQ(static_cast<float>(sub(0, 0)), 0.25f);
+    EXPECT_FLOAT_EQ(static_cast<float>(sub(1, 0)), 0.75f);
+}
@@ -1,21 +1,41 @@
+#include <bitmap/async_writer.hpp>
+#include <bitmap/binary_batch_io.hpp>
+#include <bitmap/binary_checksum.hpp>
+#include <bitmap/binary_compression.hpp>
+#include <bitmap/binary_probe.hpp>
 #include <bitmap/binary_read.hpp>
+#include <bitmap/binary_stack.hpp>
+#include <bitmap/binary_tiled.hpp>
 #include <bitmap/binary_write.hpp>
 #include <bitmap/bitmap_io.hpp>
 #include <bitmap/bitmap.hpp>
+#include <bitmap/bitmask.hpp>
+#include <bitmap/color.hpp>
+#include <bitmap/connected_components.hpp>
+#include <bitmap/convert.hpp>
 #include <bitmap/exception.hpp>
+#include <bitmap/filter.hpp>
+#include <bitmap/float16.hpp>
 #include <bitmap/get_size.hpp>
 #include <bitmap/histogram.hpp>
+#include <bitmap/integral_image.hpp>
 #include <bitmap/interpolate.hpp>
+#include <bitmap/masked_bitmap.hpp>
 #include <bitmap/masked_pixel.hpp>
 #include <bitmap/matrix3x3.hpp>
+#include <bitmap/morphology.hpp>
 #include <bitmap/pixel_algorithm.hpp>
 #include <bitmap/pixel_output.hpp>
 #include <bitmap/pixel.hpp>
+#include <bitmap/planar_bitmap.hpp>
 #include <bitmap/point_io.hpp>
 #include <bitmap/point.hpp>
+#include <bitmap/pyramid.hpp>
 #include <bitmap/rect_io.hpp>
 #include <bitmap/rect_transform.hpp>
 #include <bitmap/rect.hpp>
+#include <bitmap/resize.hpp>
+#include <bitmap/rle_mask.hpp>
 #include <bitmap/size_io.hpp>
 #include <bitmap/size.hpp>
 #include <bitmap/subbitmap.hpp>
@@ -0,0 +1,118 @@
+#include <bitmap/integral_image.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "test_images.hpp"
+
+
+using bmp::bitmap;
+using bmp::integral_image;
+using bmp::integral_options;
+using bmp::rect;
+
+
+namespace {
+
+
+    template <typename T>
+    double reference_sum(bitmap<T> const& image, rect<std::size_t> const& r, bool squared = false) {
+        double sum = 0;
+        for(auto y = r.y(); y < r.y() + r.h(); ++y) {
+            for(auto x = r.x(); x < r.x() + r.w(); ++x) {
+                auto const v = static_cast<double>(image(x, y));
+                sum += squared ? v * v : v;
+            }
+        }
+        return sum;
+    }
+
+
+}
+
+
+TEST(IntegralImageTest, Sums) {
+    auto const image = make_test_image<std::uint8_t>(37, 300);
+    integral_image const table(image, {true, 4});
+    EXPECT_EQ(table.size(), image.size());
+    EXPECT_TRUE(table.has_squares());
+    EXPECT_EQ(table(0, 0), 0);
+    EXPECT_EQ(table(37, 0), 0);
+    EXPECT_EQ(table(0, 300), 0);
+
+    for(auto const& r:
+        {rect<std::size_t>(0, 0, 37, 300), rect<std::size_t>(5, 7, 1, 1), rect<std::size_t>(3, 60, 20, 150),
+         rect<std::size_t>(36, 299, 1, 1), rect<std::size_t>(10, 250, 27, 50)}) {
+        EXPECT_EQ(static_cast<double>(table.rect_sum(r)), reference_sum(image, r));
+        EXPECT_EQ(static_cast<double>(table.rect_square_sum(r)), reference_sum(image, r, true));
+        EXPECT_DOUBLE_EQ(table.rect_mean(r), reference_sum(image, r) / static_cast<double>(r.area()));
+    }
+    EXPECT_EQ(table(37, 300), table.rect_sum(rect<std::size_t>(0, 0, 37, 300)));
+    EXPECT_EQ(table.rect_sum(rect<std::size_t>(4, 4, 0, 3)), 0);
+    EXPECT_TRUE(std::isnan(table.rect_mean(rect<std::size_t>(4, 4, 0, 0))));
+
+    // threads give the same table
+    integral_image const single(image, {true, 1});
+    for(std::size_t y = 0; y <= image.h(); ++y) {
+        for(std::size_t x = 0; x <= image.w(); ++x) {
+            ASSERT_EQ(single(x, y), table(x, y));
+        }
+    }
+}
+
+TEST(IntegralImageTest, Variance) {
+    bitmap<std::uint16_t> image(4, 2);
+    image(0, 0) = 2;
+    image(1, 0) = 4;
+    image(0, 1) = 4;
+    image(1, 1) = 6;
+    image(2, 0) = 9;
+    image(3, 1) = 9;
+
+    integral_image const table(image, {true});
+    EXPECT_DOUBLE_EQ(table.rect_mean(rect<std::size_t>(0, 0, 2, 2)), 4);
+    EXPECT_DOUBLE_EQ(table.rect_variance(rect<std::size_t>(0, 0, 2, 2)), 2);
+    EXPECT_DOUBLE_EQ(table.rect_variance(rect<std::size_t>(2, 0, 1, 1)), 0);
+
+    // no overflow for large 16 bit values
+    bitmap<std::uint16_t> const bright(1000, 1000, 65535);
+    integral_image const large(bright, {true, 3});
+    EXPECT_EQ(large.rect_sum(rect<std::size_t>(0, 0, 1000, 1000)), 65535ull * 1000000);
+    EXPECT_EQ(large.rect_square_sum(rect<std::size_t>(0, 0, 1000, 1000)), 65535ull * 65535 * 1000000);
+    EXPECT_DOUBLE_EQ(large.rect_variance(rect<std::size_t>(100, 100, 500, 300)), 0);
+}
+
+TEST(IntegralImageTest, AccumulatorTypes) {
+    auto const image = make_test_image<float>(20, 10);
+    integral_image const table(image);
+    static_assert(std::is_same_v<decltype(table)::sum_type, double>);
+    EXPECT_DOUBLE_EQ(table.rect_sum(rect<std::size_t>(2, 3, 10, 5)), reference_sum(image, rect<std::size_t>(2, 3, 10, 5)));
+
+    bitmap<std::int8_t> const negative(8, 8, -3);
+    integral_image const signed_table(negative);
+    static_assert(std::is_same_v<decltype(signed_table)::sum_type, std::int64_t>);
+    EXPECT_EQ(signed_table.rect_sum(rect<std::size_t>(1, 1, 4, 4)), -48);
+
+    // a narrow unsigned accumulator wraps around in the table, but small rects stay exact
+    bitmap<std::uint8_t> const full(300, 300, 255);
+    integral_image<std::uint8_t, std::uint32_t> const narrow(full);
+    EXPECT_EQ(narrow.rect_sum(rect<std::size_t>(290, 290, 10, 10)), 25500u);
+}
+
+TEST(IntegralImageTest, Errors) {
+    auto const image = make_test_image<std::uint8_t>(10, 10);
+    integral_image const table(image);
+    EXPECT_FALSE(table.has_squares());
+    EXPECT_THROW((void)table.rect_sum(rect<std::size_t>(5, 5, 6, 1)), std::out_of_range);
+    EXPECT_THROW((void)table.rect_sum(rect<std::size_t>(0, 9, 1, 2)), std::out_of_range);
+    EXPECT_THROW((void)table.rect_variance(rect<std::size_t>(0, 0, 2, 2)), std::logic_error);
+
+    integral_image<std::uint8_t> const empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.rect_sum(rect<std::size_t>(0, 0, 0, 0)), 0);
+    EXPECT_TRUE(integral_image(bitmap<std::uint8_t>(0, 5)).empty());
+}
@@ -0,0 +1,108 @@
+#include <bitmap/masked_bitmap.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <stdexcept>
+
+
+using bmp::bitmap;
+using bmp::bitmask;
+using bmp::masked_bitmap;
+namespace pixel = bmp::pixel;
+
+
+TEST(BitmaskTest, SetAndCount) {
+    bitmask mask(130, 3);
+    EXPECT_EQ(mask.words_per_row(), 3);
+    EXPECT_EQ(mask.count(), 0);
+
+    mask.set(0, 0, true);
+    mask.set(63, 1, true);
+    mask.set(64, 1, true);
+    mask.set(129, 2, true);
+    EXPECT_TRUE(mask(63, 1));
+    EXPECT_TRUE(mask(64, 1));
+    EXPECT_FALSE(mask(62, 1));
+    EXPECT_EQ(mask.count(), 4);
+
+    mask.set(63, 1, false);
+    EXPECT_FALSE(mask(63, 1));
+    EXPECT_EQ(mask.count(), 3);
+
+    // bits behind the width stay zero
+    mask.fill(true);
+    EXPECT_EQ(mask.count(), 390);
+    EXPECT_EQ(mask.row(0)[2], 3);
+    EXPECT_EQ(mask, bitmask(130, 3, true));
+}
+
+TEST(BitmaskTest, ToBitmap) {
+    bitmap<bool> image(67, 2);
+    std::size_t i = 0;
+    for(auto&& v: image) {
+        v = (i++ % 3) == 0;
+    }
+
+    bitmask const mask(image);
+    EXPECT_EQ(mask.count(), 45);
+    EXPECT_EQ(bmp::to_bitmap(mask), image);
+}
+
+TEST(MaskedBitmapTest, SeparateCombine) {
+    bitmap<pixel::masked_g16u> image(100, 5);
+    std::size_t i = 0;
+    for(auto& v: image) {
+        v = {static_cast<std::uint16_t>(i * 7), (i % 5) != 1};
+        ++i;
+    }
+
+    auto const masked = bmp::separate_mask(image);
+    EXPECT_EQ(masked.size(), image.size());
+    EXPECT_EQ(masked.mask().count(), 400);
+    EXPECT_EQ(masked(1, 0), (pixel::masked_g16u{7, false}));
+    EXPECT_EQ(masked(2, 0), (pixel::masked_g16u{14, true}));
+    EXPECT_EQ(bmp::combine_mask(masked), image);
+    EXPECT_EQ(masked_bitmap<std::uint16_t>(image), masked);
+
+    static_assert(sizeof(pixel::masked_g16u) == 4);
+    EXPECT_EQ(sizeof(std::uint16_t) * masked.point_count(), 1000);
+}
+
+TEST(MaskedBitmapTest, Access) {
+    masked_bitmap<pixel::rgb8u> image(3, 2, {1, 2, 3});
+    EXPECT_FALSE(image.is_valid(2, 1));
+    image.set(2, 1, {{4, 5, 6}, true});
+    EXPECT_TRUE(image.is_valid(2, 1));
+    EXPECT_EQ(image.values()(2, 1), (pixel::rgb8u{4, 5, 6}));
+    EXPECT_EQ(image(2, 1), (pixel::masked_rgb8u{{4, 5, 6}, true}));
+
+    image.resize(4, 4, {}, true);
+    EXPECT_EQ(image.mask().count(), 16);
+
+    EXPECT_THROW(masked_bitmap<int>(bitmap<int>(2, 2), bitmask(3, 2)), std::invalid_argument);
+}
+
+TEST(MaskedBitmapTest, Histogram) {
+    masked_bitmap<std::uint8_t> image(200, 2, 0);
+    for(std::size_t x = 0; x < 200; ++x) {
+        image.set(x, 0, {static_cast<std::uint8_t>(x), x % 2 == 0});
+        image.set(x, 1, {250, false});
+    }
+
+    bitmap<std::uint8_t> valid(100, 1);
+    for(std::size_t x = 0; x < 100; ++x) {
+        valid(x, 0) = static_cast<std::uint8_t>(x * 2);
+    }
+    EXPECT_EQ(
+        bmp::histogram(image, std::uint8_t(0), std::uint8_t(199), 7),
+        bmp::histogram(valid, std::uint8_t(0), std::uint8_t(199), 7));
+    auto const cumulative = bmp::histogram(image, std::uint8_t(10), std::uint8_t(20), 11, true);
+    EXPECT_EQ(cumulative.front(), 6);
+    EXPECT_EQ(cumulative.back(), 100);
+
+    masked_bitmap<float> fimage(3, 1, 0.f, true);
+    fimage.set(1, 0, {std::numeric_limits<float>::quiet_NaN(), true});
+    fimage.set(2, 0, {5.f, true});
+    EXPECT_EQ(bmp::histogram(fimage, 0.f, 1.f, 2), (std::vector<std::size_t>{1, 1}));
+}
@@ -0,0 +1,145 @@
+#include <bitmap/morphology.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "test_images.hpp"
+
+
+using bmp::bitmap;
+using bmp::bitmask;
+using bmp::morphology_options;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    /// \brief Direct min or max over the rectangle, ignoring pixels outside of the image
+    template <typename T, typename Op>
+    T reference_pixel(bitmap<T> const& image, std::size_t x, std::size_t y, std::size_t rx, std::size_t ry, Op op) {
+        auto result = image(x, y);
+        for(auto sy = y > ry ? y - ry : 0; sy <= std::min(image.h() - 1, y + ry); ++sy) {
+            for(auto sx = x > rx ? x - rx : 0; sx <= std::min(image.w() - 1, x + rx); ++sx) {
+                result = op(result, image(sx, sy));
+            }
+        }
+        return result;
+    }
+
+    template <typename T, typename Op>
+    bitmap<T> reference(bitmap<T> const& image, std::size_t rx, std::size_t ry, Op op) {
+        bitmap<T> result(image.size());
+        for(std::size_t y = 0; y < image.h(); ++y) {
+            for(std::size_t x = 0; x < image.w(); ++x) {
+                result(x, y) = reference_pixel(image, x, y, rx, ry, op);
+            }
+        }
+        return result;
+    }
+
+    bitmask reference(bitmask const& mask, std::size_t rx, std::size_t ry, bool erode) {
+        bitmask result(mask.size());
+        for(std::size_t y = 0; y < mask.h(); ++y) {
+            for(std::size_t x = 0; x < mask.w(); ++x) {
+                auto value = mask(x, y);
+                for(auto sy = y > ry ? y - ry : 0; sy <= std::min(mask.h() - 1, y + ry); ++sy) {
+                    for(auto sx = x > rx ? x - rx : 0; sx <= std::min(mask.w() - 1, x + rx); ++sx) {
+                        value = erode ? value && mask(sx, sy) : value || mask(sx, sy);
+                    }
+                }
+                result.set(x, y, value);
+            }
+        }
+        return result;
+    }
+
+    auto const min = [](auto const& l, auto const& r) { return std::min(l, r); };
+    auto const max = [](auto const& l, auto const& r) { return std::max(l, r); };
+
+
+}
+
+
+TEST(MorphologyTest, Bitmap) {
+    auto const image = make_test_image(53, 41);
+    for(auto const& [rx, ry]: {std::pair<std::size_t, std::size_t>{0, 0}, {1, 1}, {2, 0}, {0, 3}, {4, 2}, {30, 25}, {100, 3}}) {
+        EXPECT_EQ(bmp::erode(image, rx, ry), reference(image, rx, ry, min)) << rx << " " << ry;
+        EXPECT_EQ(bmp::dilate(image, rx, ry), reference(image, rx, ry, max)) << rx << " " << ry;
+    }
+
+    EXPECT_EQ(bmp::erode(image, 3), bmp::erode(image, 3, 3));
+    EXPECT_EQ(bmp::dilate(image, 5, 7, {4}), bmp::dilate(image, 5, 7));
+
+    bitmap<float> single(1, 1, 2.5f);
+    EXPECT_EQ(bmp::erode(single, 4), single);
+    EXPECT_TRUE(bmp::dilate(bitmap<std::int16_t>(), 2).empty());
+}
+
+TEST(MorphologyTest, MultiChannel) {
+    bitmap<pixel::rgba8u> image(19, 17);
+    for(std::size_t y = 0; y < image.h(); ++y) {
+        for(std::size_t x = 0; x < image.w(); ++x) {
+            image(x, y) = {
+                static_cast<std::uint8_t>(x * 13 + y),
+                static_cast<std::uint8_t>(y * 29 + x * 3),
+                static_cast<std::uint8_t>((x * y) % 200),
+                static_cast<std::uint8_t>(255 - x - y)};
+        }
+    }
+
+    auto const pixel_min = [](auto const& l, auto const& r) { return pixel::min(l, r); };
+    auto const pixel_max = [](auto const& l, auto const& r) { return pixel::max(l, r); };
+    EXPECT_EQ(bmp::erode(image, 2, 3), reference(image, 2, 3, pixel_min));
+    EXPECT_EQ(bmp::dilate(image, 3, 1), reference(image, 3, 1, pixel_max));
+}
+
+TEST(MorphologyTest, OpeningClosing) {
+    bitmap<std::uint8_t> image(20, 12, 10);
+    image(5, 5) = 200;             // bright point smaller than the square
+    image(12, 6) = 0;              // dark point smaller than the square
+    for(std::size_t y = 2; y < 9; ++y) {
+        for(std::size_t x = 14; x < 19; ++x) {
+            image(x, y) = 100;     // bright area larger than the square
+        }
+    }
+
+    auto const opened = bmp::opening(image, 1);
+    EXPECT_EQ(opened(5, 5), 10);
+    EXPECT_EQ(opened(12, 6), 0);
+    EXPECT_EQ(opened(16, 5), 100);
+
+    auto const closed = bmp::closing(image, 1);
+    EXPECT_EQ(closed(5, 5), 200);
+    EXPECT_EQ(closed(12, 6), 10);
+    EXPECT_EQ(closed(16, 5), 100);
+
+    EXPECT_EQ(bmp::opening(opened, 1), opened);
+    EXPECT_EQ(bmp::closing(closed, 1), closed);
+}
+
+TEST(MorphologyTest, Bitmask) {
+    for(auto const& [w, h]: {std::pair<std::size_t, std::size_t>{1, 1}, {63, 5}, {64, 9}, {130, 21}, {200, 3}}) {
+        auto const mask = make_test_mask(w, h);
+        for(auto const& [rx, ry]:
+            {std::pair<std::size_t, std::size_t>{0, 0}, {1, 0}, {0, 2}, {3, 1}, {5, 4}, {63, 1}, {70, 10}}) {
+            EXPECT_EQ(bmp::erode(mask, rx, ry), reference(mask, rx, ry, true)) << w << "x" << h << " " << rx << " " << ry;
+            EXPECT_EQ(bmp::dilate(mask, rx, ry), reference(mask, rx, ry, false)) << w << "x" << h << " " << rx << " " << ry;
+        }
+    }
+
+    auto const mask = make_test_mask(150, 40);
+    EXPECT_EQ(bmp::erode(mask, 4, {3}), bmp::erode(mask, 4));
+    EXPECT_EQ(bmp::opening(mask, 2), bmp::dilate(bmp::erode(mask, 2), 2));
+    EXPECT_EQ(bmp::closing(mask, 2, 1), bmp::erode(bmp::dilate(mask, 2, 1), 2, 1));
+
+    // closing fills a hole, opening removes a speck
+    bitmask block(10, 10, true);
+    block.set(4, 4, false);
+    EXPECT_EQ(bmp::closing(block, 1), bitmask(10, 10, true));
+    bitmask speck(10, 10);
+    speck.set(4, 4, true);
+    EXPECT_EQ(bmp::opening(speck, 1), bitmask(10, 10));
+}
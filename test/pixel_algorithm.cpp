@@ -0,0 +1,50 @@
+#include <bitmap/pixel_algorithm.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+
+using namespace bmp::pixel;
+
+
+TEST(PixelAlgorithmTest, MinMaxGa) {
+    ga8u const l{10, 200};
+    ga8u const r{20, 100};
+
+    EXPECT_EQ(bmp::pixel::min(l, r), (ga8u{10, 100}));
+    EXPECT_EQ(bmp::pixel::max(l, r), (ga8u{20, 200}));
+}
+
+TEST(PixelAlgorithmTest, MinMaxRgb) {
+    rgb8u const l{1, 50, 9};
+    rgb8u const r{2, 40, 9};
+
+    EXPECT_EQ(bmp::pixel::min(l, r), (rgb8u{1, 40, 9}));
+    EXPECT_EQ(bmp::pixel::max(l, r), (rgb8u{2, 50, 9}));
+}
+
+TEST(PixelAlgorithmTest, MinMaxRgba) {
+    // every channel has its minimum in the other argument than its neighbors
+    rgba8u const l{1, 200, 3, 250};
+    rgba8u const r{100, 2, 150, 4};
+
+    EXPECT_EQ(bmp::pixel::min(l, r), (rgba8u{1, 2, 3, 4}));
+    EXPECT_EQ(bmp::pixel::max(l, r), (rgba8u{100, 200, 150, 250}));
+    EXPECT_EQ(bmp::pixel::min(r, l), bmp::pixel::min(l, r));
+    EXPECT_EQ(bmp::pixel::max(r, l), bmp::pixel::max(l, r));
+
+    rgba32f const fl{-1.f, 0.5f, 2.f, 0.f};
+    rgba32f const fr{1.f, -0.5f, 3.f, 1.f};
+    EXPECT_EQ(bmp::pixel::min(fl, fr), (rgba32f{-1.f, -0.5f, 2.f, 0.f}));
+    EXPECT_EQ(bmp::pixel::max(fl, fr), (rgba32f{1.f, 0.5f, 3.f, 1.f}));
+}
+
+TEST(PixelAlgorithmTest, AnyAll) {
+    auto const odd = [](std::uint8_t const v) { return v % 2 == 1; };
+
+    EXPECT_TRUE(bmp::pixel::any(rgba8u{2, 4, 6, 7}, odd));
+    EXPECT_FALSE(bmp::pixel::any(rgba8u{2, 4, 6, 8}, odd));
+    EXPECT_TRUE(bmp::pixel::all(rgba8u{1, 3, 5, 7}, odd));
+    EXPECT_FALSE(bmp::pixel::all(rgba8u{1, 3, 6, 7}, odd));
+}
@@ -0,0 +1,71 @@
+#include <bitmap/planar_bitmap.hpp>
+
+#include <gtest/gtest.h>
+
+
+using bmp::bitmap;
+using bmp::planar_bitmap;
+using bmp::rect;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    bitmap<pixel::rgb8u> make_rgb(std::size_t w, std::size_t h) {
+        bitmap<pixel::rgb8u> image(w, h);
+        for(std::size_t y = 0; y < h; ++y) {
+            for(std::size_t x = 0; x < w; ++x) {
+                image(x, y) = {
+                    static_cast<std::uint8_t>(x), static_cast<std::uint8_t>(y), static_cast<std::uint8_t>(x + y)};
+            }
+        }
+        return image;
+    }
+
+
+}
+
+
+TEST(PlanarBitmapTest, Construct) {
+    planar_bitmap<pixel::rgba16u> image(3, 2, {1, 2, 3, 4});
+    EXPECT_EQ(image.size(), bmp::size<std::size_t>(3, 2));
+    EXPECT_EQ(image.plane(2), bitmap<std::uint16_t>(3, 2, 3));
+    EXPECT_EQ(image(2, 1), (pixel::rgba16u{1, 2, 3, 4}));
+
+    image.set(1, 0, {5, 6, 7, 8});
+    EXPECT_EQ(image(1, 0), (pixel::rgba16u{5, 6, 7, 8}));
+    EXPECT_EQ(image.plane(3)(1, 0), 8);
+    EXPECT_THROW(image.plane(4), std::out_of_range);
+
+    image.clear();
+    EXPECT_TRUE(image.empty());
+}
+
+TEST(PlanarBitmapTest, Interleave) {
+    auto const image = make_rgb(37, 11);
+    auto const planar = bmp::deinterleave(image);
+    EXPECT_EQ(planar.w(), 37);
+    EXPECT_EQ(planar.plane(0)(5, 3), 5);
+    EXPECT_EQ(planar.plane(1)(5, 3), 3);
+    EXPECT_EQ(planar.plane(2)(5, 3), 8);
+    EXPECT_EQ(bmp::interleave(planar), image);
+    EXPECT_EQ(planar_bitmap<pixel::rgb8u>(image), planar);
+
+    bitmap<pixel::ga32f> ga(4, 3, {1.5f, 2.5f});
+    EXPECT_EQ(bmp::interleave(bmp::deinterleave(ga)), ga);
+}
+
+TEST(PlanarBitmapTest, Subbitmap) {
+    auto const image = make_rgb(20, 10);
+    auto const planar = bmp::deinterleave(image);
+    EXPECT_EQ(bmp::interleave(subbitmap(planar, rect{3, 2, 5, 4})), subbitmap(image, rect{3, 2, 5, 4}));
+}
+
+TEST(PlanarBitmapTest, Histogram) {
+    auto const planar = bmp::deinterleave(make_rgb(4, 2));
+    auto const result = bmp::histogram(planar, std::uint8_t(0), std::uint8_t(3), 4);
+    EXPECT_EQ(result[0], (std::vector<std::size_t>{2, 2, 2, 2}));
+    EXPECT_EQ(result[1], (std::vector<std::size_t>{4, 4, 0, 0}));
+    EXPECT_EQ(result[2], (std::vector<std::size_t>{1, 2, 2, 3}));
+}
@@ -0,0 +1,288 @@
+#include <bitmap/io/image_format_png.hpp>
+#include <bitmap/subbitmap.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+
+namespace pixel = bmp::pixel;
+using bmp::bitmap;
+using bmp::rect;
+
+
+template <typename T>
+bitmap<T> make_png_test_image(std::size_t w, std::size_t h) {
+    using value_type = pixel::channel_type_t<T>;
+    bitmap<T> result(w, h);
+    std::size_t i = 0;
+    for(auto& v: result) {
+        auto* const channels = reinterpret_cast<value_type*>(&v);
+        for(std::size_t c = 0; c < pixel::channel_count_v<T>; ++c) {
+            channels[c] = static_cast<value_type>(i * 7919 + c * 104729);
+        }
+        ++i;
+    }
+    return result;
+}
+
+
+template <typename T>
+struct png_read_write_test: public ::testing::Test {
+    using type = T;
+};
+
+using png_types = ::testing::Types<
+    std::uint8_t,
+    std::int8_t,
+    std::uint16_t,
+    std::int16_t,
+    pixel::ga8u,
+    pixel::ga16u,
+    pixel::rgb8u,
+    pixel::rgb16u,
+    pixel::rgba8u,
+    pixel::rgba16u>;
+
+TYPED_TEST_SUITE(png_read_write_test, png_types, );
+
+TYPED_TEST(png_read_write_test, RWTest) {
+    using type = typename TestFixture::type;
+    auto const img = make_png_test_image<type>(13, 11);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<type> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s));
+    EXPECT_EQ(img, img2);
+}
+
+TYPED_TEST(png_read_write_test, RegionTest) {
+    using type = typename TestFixture::type;
+    auto const img = make_png_test_image<type>(13, 11);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<type> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s, rect<std::size_t>(3, 2, 5, 4)));
+    ASSERT_EQ(img2.size(), (bmp::size<std::size_t>(5, 4)));
+    for(std::size_t y = 0; y < 4; ++y) {
+        for(std::size_t x = 0; x < 5; ++x) {
+            EXPECT_EQ(img2(x, y), img(x + 3, y + 2));
+        }
+    }
+}
+
+
+TEST(PNGTest, Bool) {
+    bitmap<bool> img(17, 5);
+    std::size_t i = 0;
+    for(auto&& v: img) {
+        v = (i++ % 3) == 0;
+    }
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<bool> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s));
+    EXPECT_EQ(img, img2);
+}
+
+TEST(PNGTest, Masked) {
+    bitmap<pixel::masked_rgb8u> img(4, 3);
+    std::size_t i = 0;
+    for(auto& v: img) {
+        auto const c = static_cast<std::uint8_t>(i);
+        v = {{c, static_cast<std::uint8_t>(c + 1), static_cast<std::uint8_t>(c + 2)}, (i++ % 2) == 0};
+    }
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<pixel::masked_rgb8u> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s));
+    EXPECT_EQ(img, img2);
+
+    s.seekg(0);
+    bitmap<pixel::rgba8u> rgba;
+    ASSERT_TRUE(bmp::png::read(rgba, s));
+    EXPECT_EQ(rgba(0, 0).a, 255);
+    EXPECT_EQ(rgba(1, 0).a, 0);
+}
+
+TEST(PNGTest, MaskedBitmap) {
+    bmp::masked_bitmap<std::int16_t> img(70, 3, -2);
+    img.set(0, 0, {300, true});
+    img.set(69, 2, {-1, true});
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<pixel::masked_g16> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s));
+    EXPECT_EQ(img2, bmp::combine_mask(img));
+
+    bmp::masked_bitmap<pixel::rgb8u> rgb(2, 1, {1, 2, 3});
+    rgb.mask().set(1, 0, true);
+    std::stringstream rgb_s;
+    ASSERT_TRUE(bmp::png::write(rgb, rgb_s));
+    bitmap<pixel::rgba8u> rgba;
+    ASSERT_TRUE(bmp::png::read(rgba, rgb_s));
+    EXPECT_EQ(rgba, (bitmap<pixel::rgba8u>({{{1, 2, 3, 0}, {1, 2, 3, 255}}})));
+}
+
+TEST(PNGTest, GrayToColor) {
+    auto const img = make_png_test_image<std::uint8_t>(6, 4);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+    bitmap<pixel::rgba16u> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s));
+    ASSERT_EQ(img2.size(), img.size());
+    for(std::size_t i = 0; i < img.point_count(); ++i) {
+        auto const v = static_cast<std::uint16_t>(*(img.begin() + i) * 257);
+        EXPECT_EQ(*(img2.begin() + i), (pixel::rgba16u{v, v, v, 65535}));
+    }
+}
+
+TEST(PNGTest, ReadRows) {
+    auto const img = make_png_test_image<pixel::rgb16u>(7, 9);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+
+    // reuse memory of a larger bitmap
+    bitmap<pixel::rgb16u> img2(100, 100);
+    auto const data = img2.data();
+    ASSERT_TRUE(bmp::png::reader{}.read_rows(img2, s, 4, 3));
+    EXPECT_EQ(img2.data(), data);
+    EXPECT_EQ(img2, bmp::subbitmap(img, rect<std::size_t>(0, 4, 7, 3)));
+}
+
+TEST(PNGTest, RegionOutOfRange) {
+    auto const img = make_png_test_image<std::uint8_t>(6, 4);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s));
+
+    std::string message;
+    bmp::png::reader reader;
+    reader.on_error([&message](std::string_view error) { message = error; });
+    bitmap<std::uint8_t> img2;
+    EXPECT_FALSE(reader.read(img2, s, rect<std::size_t>(3, 0, 4, 1)));
+    EXPECT_FALSE(message.empty());
+}
+
+TEST(PNGTest, InvalidData) {
+    std::stringstream s("no png");
+    bitmap<std::uint8_t> img;
+    EXPECT_FALSE(bmp::png::read(img, s));
+}
+
+TEST(PNGTest, WriteOptions) {
+    auto const img = make_png_test_image<pixel::rgb16u>(31, 17);
+
+    using bmp::png::compression_strategy;
+    using bmp::png::filter;
+    for(auto const interlace: {false, true}) {
+        for(auto const f: {filter::none, filter::sub, filter::up, filter::average, filter::paeth, filter::adaptive}) {
+            for(auto const strategy: {compression_strategy::standard, compression_strategy::rle}) {
+                std::stringstream s;
+                ASSERT_TRUE(bmp::png::write(img, s, {interlace, 1, strategy, f}));
+                bitmap<pixel::rgb16u> img2;
+                ASSERT_TRUE(bmp::png::read(img2, s));
+                EXPECT_EQ(img, img2);
+            }
+        }
+    }
+
+    std::stringstream s;
+    EXPECT_FALSE(bmp::png::write(img, s, {.compression_level = 10}));
+}
+
+TEST(PNGTest, InterlacedRegion) {
+    auto const img = make_png_test_image<pixel::rgba8u>(19, 23);
+    std::stringstream s;
+    ASSERT_TRUE(bmp::png::write(img, s, {.interlace = true}));
+
+    bitmap<pixel::rgba8u> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s, rect<std::size_t>(5, 7, 9, 11)));
+    EXPECT_EQ(img2, bmp::subbitmap(img, rect<std::size_t>(5, 7, 9, 11)));
+}
+
+template <typename T>
+struct png_parallel_write_test: public ::testing::Test {
+    using type = T;
+};
+
+using png_parallel_types = ::testing::Types<bool, std::uint8_t, std::uint16_t, pixel::ga8u, pixel::rgb16u, pixel::masked_rgb8u>;
+
+TYPED_TEST_SUITE(png_parallel_write_test, png_parallel_types, );
+
+TYPED_TEST(png_parallel_write_test, RWTest) {
+    using type = typename TestFixture::type;
+
+    bitmap<type> img;
+    if constexpr(std::is_same_v<type, bool>) {
+        img.resize(4001, 1103);
+        std::size_t i = 0;
+        for(auto&& v: img) {
+            v = (i++ % 7) < 3;
+        }
+    } else if constexpr(pixel::is_masked_pixel_type_v<type>) {
+        img.resize(1031, 517);
+        std::size_t i = 0;
+        for(auto& v: img) {
+            auto const c = static_cast<std::uint8_t>(i / 3);
+            v = {{c, static_cast<std::uint8_t>(c * 3), static_cast<std::uint8_t>(i)}, (i++ % 5) != 0};
+        }
+    } else {
+        img = make_png_test_image<type>(1031, 517);
+    }
+
+    using bmp::png::filter;
+    for(auto const f: {filter::none, filter::sub, filter::up, filter::average, filter::paeth, filter::adaptive}) {
+        std::stringstream s;
+        ASSERT_TRUE(bmp::png::write(img, s, {.compression_level = 1, .filter = f, .threads = 4}));
+        bitmap<type> img2;
+        ASSERT_TRUE(bmp::png::read(img2, s));
+        EXPECT_EQ(img, img2);
+    }
+}
+
+TEST(PNGTest, ReuseWriter) {
+    bmp::png::writer writer({.compression_level = 1, .threads = 3});
+    for(std::size_t i = 0; i < 4; ++i) {
+        if(i == 2) {
+            writer.set_options({.compression_level = 6, .threads = 3});
+        }
+
+        auto img = make_png_test_image<pixel::ga16u>(701, 401);
+        img(i, i) = {42, 43};
+
+        std::stringstream s;
+        ASSERT_TRUE(writer.write(img, s));
+        bitmap<pixel::ga16u> img2;
+        ASSERT_TRUE(bmp::png::read(img2, s));
+        EXPECT_EQ(img, img2);
+
+        std::stringstream s2;
+        ASSERT_TRUE(writer.write(bitmap<pixel::masked_g8u>(17, 3, {7, true}), s2));
+    }
+}
+
+TEST(PNGTest, ReuseSingleThreadWriter) {
+    bmp::png::writer writer;
+    auto const img = make_png_test_image<pixel::rgb8u>(301, 201);
+
+    std::stringstream s1;
+    ASSERT_TRUE(writer.write(img, s1));
+    ASSERT_EQ(writer.bands().size(), 1);
+    auto const& band = *writer.bands()[0];
+    auto const* const state = band.stream.state;
+    auto const* const data = band.data.data();
+    auto const capacity = band.data.capacity();
+
+    std::stringstream s2;
+    ASSERT_TRUE(writer.write(img, s2));
+    ASSERT_EQ(writer.bands().size(), 1);
+    EXPECT_EQ(&band, writer.bands()[0].get());
+    EXPECT_EQ(band.stream.state, state);
+    EXPECT_EQ(band.data.data(), data);
+    EXPECT_EQ(band.data.capacity(), capacity);
+    EXPECT_EQ(s1.str(), s2.str());
+
+    bitmap<pixel::rgb8u> img2;
+    ASSERT_TRUE(bmp::png::read(img2, s2));
+    EXPECT_EQ(img, img2);
+}
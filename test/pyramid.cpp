@@ -0,0 +1,134 @@
+#include <bitmap/pyramid.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+using bmp::bitmap;
+using bmp::pyramid;
+using bmp::pyramid_filter;
+using bmp::pyramid_options;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    /// \brief Straightforward 5 tap binomial decimation with edge repetition
+    bitmap<double> reference_gaussian(bitmap<double> const& image) {
+        constexpr double weights[5] = {1, 4, 6, 4, 1};
+        auto const at = [&](std::ptrdiff_t x, std::ptrdiff_t y) {
+            x = std::clamp<std::ptrdiff_t>(x, 0, image.sw() - 1);
+            y = std::clamp<std::ptrdiff_t>(y, 0, image.sh() - 1);
+            return image(static_cast<std::size_t>(x), static_cast<std::size_t>(y));
+        };
+
+        bitmap<double> result((image.w() + 1) / 2, (image.h() + 1) / 2);
+        for(std::size_t y = 0; y < result.h(); ++y) {
+            for(std::size_t x = 0; x < result.w(); ++x) {
+                double sum = 0;
+                for(std::ptrdiff_t j = 0; j < 5; ++j) {
+                    for(std::ptrdiff_t i = 0; i < 5; ++i) {
+                        sum += weights[j] * weights[i]
+                            * at(static_cast<std::ptrdiff_t>(2 * x) + i - 2, static_cast<std::ptrdiff_t>(2 * y) + j - 2);
+                    }
+                }
+                result(x, y) = sum / 256;
+            }
+        }
+        return result;
+    }
+
+
+}
+
+
+TEST(PyramidTest, Levels) {
+    bitmap<std::uint8_t> image(13, 6, 10);
+    pyramid<std::uint8_t> const levels(image);
+    ASSERT_EQ(levels.levels(), 5);
+    EXPECT_EQ(levels.size(1), (bitmap<std::uint8_t>::size_type(7, 3)));
+    EXPECT_EQ(levels.size(2), (bitmap<std::uint8_t>::size_type(4, 2)));
+    EXPECT_EQ(levels.size(3), (bitmap<std::uint8_t>::size_type(2, 1)));
+    EXPECT_EQ(levels.size(4), (bitmap<std::uint8_t>::size_type(1, 1)));
+    EXPECT_EQ(levels.level(0), image);
+    EXPECT_EQ(levels.level(3), (bitmap<std::uint8_t>(2, 1, 10)));
+
+    // all levels in one allocation
+    EXPECT_EQ(levels.data(1), levels.data(0) + 13 * 6);
+    EXPECT_EQ(levels.data(4), levels.data(3) + 2);
+
+    EXPECT_EQ(pyramid<std::uint8_t>(image, {pyramid_filter::box, 2}).levels(), 2);
+    EXPECT_THROW(levels.size(5), std::out_of_range);
+    EXPECT_TRUE(pyramid<float>(bitmap<float>()).empty());
+}
+
+TEST(PyramidTest, Box) {
+    bitmap<std::uint16_t> image({{1, 2, 3}, {5, 7, 9}, {100, 200, 255}});
+    auto const half = bmp::downsample_half(image);
+    // (1 + 2 + 5 + 7 + 2) / 4, odd edges repeat the last column and row
+    EXPECT_EQ(half, (bitmap<std::uint16_t>({{4, 6}, {150, 255}})));
+
+    bitmap<pixel::rgb32f> color(4, 2, {1.f, 2.f, 3.f});
+    color(3, 1) = {5.f, 6.f, 7.f};
+    auto const color_half = bmp::downsample_half(color);
+    EXPECT_EQ(color_half(0, 0), (pixel::rgb32f{1.f, 2.f, 3.f}));
+    EXPECT_EQ(color_half(1, 0), (pixel::rgb32f{2.f, 3.f, 4.f}));
+
+    // 64 bit sums can't overflow, they round half up like the narrow types
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+    constexpr auto min = std::numeric_limits<std::int64_t>::min();
+    bitmap<std::int64_t> wide({{max, max, min, min, -5}, {max, max - 1, min, min + 2, -6}});
+    EXPECT_EQ(bmp::downsample_half(wide), (bitmap<std::int64_t>({{max, min + 1, -5}})));
+    constexpr auto umax = std::numeric_limits<std::uint64_t>::max();
+    EXPECT_EQ(
+        bmp::downsample_half(bitmap<std::uint64_t>({{umax, umax}, {umax, umax - 2}})),
+        (bitmap<std::uint64_t>({{umax}})));
+    EXPECT_THROW(bmp::downsample_half(wide, pyramid_filter::gaussian), std::invalid_argument);
+
+    // bool pixels are true if at least half of the source pixels are
+    bitmap<bool> mask({{true, false, false, false, true}, {false, true, false, false, false}});
+    EXPECT_EQ(bmp::downsample_half(mask), (bitmap<bool>({{true, false, true}})));
+}
+
+TEST(PyramidTest, Gaussian) {
+    for(auto const& [w, h]: {std::pair{1, 1}, {2, 3}, {5, 4}, {17, 9}, {64, 70}}) {
+        bitmap<double> image(static_cast<std::size_t>(w), static_cast<std::size_t>(h));
+        for(std::size_t i = 0; i < image.point_count(); ++i) {
+            image.data()[i] = std::sin(static_cast<double>(i) * 0.37) * 100;
+        }
+
+        auto const expected = reference_gaussian(image);
+        auto const result = bmp::downsample_half(image, pyramid_filter::gaussian);
+        ASSERT_EQ(result.size(), expected.size());
+        for(std::size_t i = 0; i < result.point_count(); ++i) {
+            EXPECT_NEAR(result.data()[i], expected.data()[i], 1e-9) << w << "x" << h << " " << i;
+        }
+    }
+
+    // constant images stay constant
+    bitmap<std::uint8_t> image(31, 17, 77);
+    pyramid<std::uint8_t> const levels(image, {pyramid_filter::gaussian});
+    for(std::size_t level = 0; level < levels.levels(); ++level) {
+        EXPECT_EQ(levels.level(level), (bitmap<std::uint8_t>(levels.size(level), 77)));
+    }
+}
+
+TEST(PyramidTest, Threads) {
+    bitmap<pixel::ga16u> image(301, 257);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        image.data()[i] = {static_cast<std::uint16_t>(i * 31), static_cast<std::uint16_t>(i)};
+    }
+
+    for(auto const filter: {pyramid_filter::box, pyramid_filter::gaussian}) {
+        pyramid<pixel::ga16u> const single(image, {filter, 0, 1});
+        pyramid<pixel::ga16u> const multi(image, {filter, 0, 4});
+        ASSERT_EQ(single.levels(), multi.levels());
+        for(std::size_t level = 0; level < single.levels(); ++level) {
+            EXPECT_EQ(single.level(level), multi.level(level));
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#include <bitmap/resize.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+using bmp::bitmap;
+using bmp::resize_filter;
+using bmp::resize_options;
+namespace pixel = bmp::pixel;
+
+
+namespace {
+
+
+    constexpr resize_filter all_filters[]
+        = {resize_filter::box, resize_filter::bilinear, resize_filter::bicubic, resize_filter::lanczos3};
+
+
+}
+
+
+TEST(ResizeTest, Identity) {
+    bitmap<std::uint8_t> image(23, 11);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        image.data()[i] = static_cast<std::uint8_t>(i * 37);
+    }
+
+    for(auto const filter: all_filters) {
+        EXPECT_EQ(bmp::resize(image, image.size(), {filter}), image);
+    }
+}
+
+TEST(ResizeTest, Constant) {
+    bitmap<float> image(17, 9, 3.5f);
+    for(auto const filter: all_filters) {
+        for(auto const& [w, h]: {std::pair{std::size_t(5), std::size_t(4)}, {40, 3}, {1, 1}, {100, 50}}) {
+            auto const result = bmp::resize(image, w, h, {filter});
+            ASSERT_EQ(result.w(), w);
+            ASSERT_EQ(result.h(), h);
+            for(auto const v: result) {
+                EXPECT_NEAR(v, 3.5f, 1e-5f);
+            }
+        }
+    }
+}
+
+TEST(ResizeTest, Box) {
+    bitmap<float> image({{1, 3, 5, 7}, {3, 5, 7, 9}});
+    EXPECT_EQ(bmp::resize(image, 2, 1, {resize_filter::box}), (bitmap<float>({{3, 7}})));
+    EXPECT_EQ(bmp::resize(image, 1, 1, {resize_filter::box}), (bitmap<float>({{5}})));
+
+    // enlarging repeats pixels
+    bitmap<std::uint16_t> small({{1, 2}});
+    EXPECT_EQ(bmp::resize(small, 4, 2, {resize_filter::box}), (bitmap<std::uint16_t>({{1, 1, 2, 2}, {1, 1, 2, 2}})));
+}
+
+TEST(ResizeTest, Bilinear) {
+    bitmap<double> image({{0, 10}});
+    auto const result = bmp::resize(image, 4, 1);
+    EXPECT_EQ(result, (bitmap<double>({{0, 2.5, 7.5, 10}})));
+}
+
+TEST(ResizeTest, Bicubic) {
+    // enlarging an impulse by 2 samples the Keys kernel with a = -0.5 at x.25 and x.75
+    bitmap<double> image({{0, 0, 0, 1, 0, 0, 0, 0}});
+    auto const result = bmp::resize(image, 16, 1, {resize_filter::bicubic});
+    EXPECT_EQ(
+        result,
+        (bitmap<double>({{0, 0, 0, -0.0234375, -0.0703125, 0.2265625, 0.8671875, 0.8671875, 0.2265625, -0.0703125,
+                          -0.0234375, 0, 0, 0, 0, 0}})));
+}
+
+TEST(ResizeTest, Lanczos3) {
+    // sinc(x) * sinc(x / 3) at the same positions, divided by the sum of the six taps
+    bitmap<double> image({{0, 0, 0, 1, 0, 0, 0, 0}});
+    auto const result = bmp::resize(image, 16, 1, {resize_filter::lanczos3});
+    double const expected[] = {0, 0.007378271, 0.030112285, -0.067997263, -0.133274636, 0.271010568, 0.892770774,
+                               0.892770774, 0.271010568, -0.133274636, -0.067997263, 0.030112285, 0.007378271, 0, 0, 0};
+    ASSERT_EQ(result.w(), 16);
+    for(std::size_t x = 0; x < 16; ++x) {
+        EXPECT_NEAR(result(x, 0), expected[x], 1e-9) << x;
+    }
+}
+
+TEST(ResizeTest, Saturation) {
+    bitmap<std::uint8_t> image(8, 1);
+    for(std::size_t x = 4; x < 8; ++x) {
+        image(x, 0) = 255;
+    }
+
+    // the cubic and Lanczos kernels overshoot at the edge, integral results saturate
+    for(auto const filter: {resize_filter::bicubic, resize_filter::lanczos3}) {
+        auto const result = bmp::resize(image, 29, 3, {filter});
+        EXPECT_EQ(result(0, 0), 0);
+        EXPECT_EQ(result(28, 2), 255);
+
+        auto const wide = bmp::resize(bmp::convert<float>(image), 29, 3, {filter});
+        auto const [min, max] = std::minmax_element(wide.begin(), wide.end());
+        EXPECT_LT(*min, 0.f);
+        EXPECT_GT(*max, 255.f);
+    }
+}
+
+TEST(ResizeTest, PixelAndThreads) {
+    bitmap<pixel::rgb16u> image(97, 61);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        auto const v = static_cast<std::uint16_t>(i * 101);
+        image.data()[i] = {v, static_cast<std::uint16_t>(v / 2), static_cast<std::uint16_t>(65535 - v)};
+    }
+
+    for(auto const filter: all_filters) {
+        for(auto const& [w, h]: {std::pair{std::size_t(31), std::size_t(200)}, {300, 17}}) {
+            auto const single = bmp::resize(image, w, h, {filter, 1});
+            EXPECT_EQ(bmp::resize(image, w, h, {filter, 4}), single);
+        }
+    }
+
+    bitmap<pixel::rgb16u> gray(10, 10, {100, 100, 100});
+    EXPECT_EQ(bmp::resize(gray, 3, 7, {resize_filter::lanczos3}), (bitmap<pixel::rgb16u>(3, 7, {100, 100, 100})));
+}
+
+TEST(ResizeTest, Empty) {
+    EXPECT_TRUE(bmp::resize(bitmap<float>(3, 3), 0, 5).empty());
+    EXPECT_THROW(bmp::resize(bitmap<float>(), 2, 2), std::invalid_argument);
+}
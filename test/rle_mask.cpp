@@ -0,0 +1,177 @@
+#include <bitmap/rle_mask.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "test_images.hpp"
+
+
+using bmp::bitmap;
+using bmp::bitmask;
+using bmp::rect;
+using bmp::rle_mask;
+using bmp::rle_span;
+
+
+namespace {
+
+
+    template <typename Op>
+    bitmap<bool> reference(bitmap<bool> const& a, bitmap<bool> const& b, Op op) {
+        bitmap<bool> result(a.size());
+        for(std::size_t y = 0; y < a.h(); ++y) {
+            for(std::size_t x = 0; x < a.w(); ++x) {
+                result(x, y) = op(bool(a(x, y)), bool(b(x, y)));
+            }
+        }
+        return result;
+    }
+
+
+}
+
+
+TEST(RleMaskTest, Conversion) {
+    auto const image = make_test_pattern(150, 20, 3);
+    rle_mask const mask(image);
+    EXPECT_EQ(mask.size(), image.size());
+    EXPECT_EQ(to_bitmap(mask), image);
+    EXPECT_EQ(rle_mask(bitmask(image)), mask);
+    EXPECT_EQ(to_bitmask(mask), bitmask(image));
+
+    std::size_t area = 0;
+    for(std::size_t y = 0; y < image.h(); ++y) {
+        for(std::size_t x = 0; x < image.w(); ++x) {
+            area += image(x, y) ? 1 : 0;
+            EXPECT_EQ(mask(x, y), image(x, y));
+        }
+    }
+    EXPECT_EQ(mask.area(), area);
+    EXPECT_LT(mask.span_count(), area);
+
+    // spans covering whole words
+    bitmask full(200, 2, true);
+    full.set(64, 1, false);
+    rle_mask const long_spans(full);
+    ASSERT_EQ(long_spans.row(0).size(), 1);
+    EXPECT_EQ(long_spans.row(0)[0], (rle_span{0, 200}));
+    ASSERT_EQ(long_spans.row(1).size(), 2);
+    EXPECT_EQ(long_spans.row(1)[1], (rle_span{65, 200}));
+    EXPECT_EQ(to_bitmask(long_spans), full);
+}
+
+TEST(RleMaskTest, Rect) {
+    rle_mask const mask({10, 8}, rect<std::size_t>(3, 2, 5, 4));
+    EXPECT_EQ(mask.area(), 20);
+    EXPECT_EQ(mask.span_count(), 4);
+    EXPECT_EQ(mask.bounds(), rect<std::size_t>(3, 2, 5, 4));
+    EXPECT_TRUE(mask(3, 2));
+    EXPECT_FALSE(mask(8, 2));
+    EXPECT_FALSE(mask(3, 6));
+
+    // partially outside
+    rle_mask const outside({10, 8}, rect<std::size_t>(7, 6, 10, 10));
+    EXPECT_EQ(outside.area(), 6);
+    EXPECT_EQ(outside.bounds(), rect<std::size_t>(7, 6, 3, 2));
+    EXPECT_EQ(rle_mask({10, 8}, rect<std::size_t>(20, 0, 1, 1)), rle_mask(10, 8));
+    EXPECT_EQ(rle_mask(10, 8).bounds(), rect<std::size_t>());
+
+    auto const image = make_test_pattern(40, 30, 5);
+    rect<std::size_t> const area(5, 3, 20, 17);
+    auto expected = image;
+    for(std::size_t y = 0; y < image.h(); ++y) {
+        for(std::size_t x = 0; x < image.w(); ++x) {
+            if(x < 5 || x >= 25 || y < 3 || y >= 20) {
+                expected(x, y) = false;
+            }
+        }
+    }
+    EXPECT_EQ(to_bitmap(clip(rle_mask(image), area)), expected);
+    EXPECT_EQ(clip(rle_mask(image), area), rle_mask(image) & rle_mask(image.size(), area));
+}
+
+TEST(RleMaskTest, SetOperations) {
+    auto const a = make_test_pattern(97, 23, 3);
+    auto const b = make_test_pattern(97, 23, 7);
+    rle_mask const ma(a);
+    rle_mask const mb(b);
+
+    EXPECT_EQ(to_bitmap(ma | mb), reference(a, b, [](bool l, bool r) { return l || r; }));
+    EXPECT_EQ(to_bitmap(ma & mb), reference(a, b, [](bool l, bool r) { return l && r; }));
+    EXPECT_EQ(to_bitmap(ma ^ mb), reference(a, b, [](bool l, bool r) { return l != r; }));
+    EXPECT_EQ(to_bitmap(ma - mb), reference(a, b, [](bool l, bool r) { return l && !r; }));
+
+    // results are normalized, touching spans are merged
+    EXPECT_EQ(ma | mb, rle_mask(to_bitmap(ma | mb)));
+    rle_mask const left({10, 1}, rect<std::size_t>(0, 0, 4, 1));
+    rle_mask const right({10, 1}, rect<std::size_t>(4, 0, 3, 1));
+    EXPECT_EQ(left | right, rle_mask({10, 1}, rect<std::size_t>(0, 0, 7, 1)));
+    EXPECT_EQ((left & right).area(), 0);
+
+    EXPECT_THROW(ma | rle_mask(5, 5), std::invalid_argument);
+}
+
+TEST(RleMaskTest, Iteration) {
+    auto const image = make_test_pattern(33, 12, 2);
+    rle_mask const mask(image);
+
+    std::vector<std::pair<std::size_t, std::size_t>> pixels;
+    bmp::for_each_pixel(mask, [&](std::size_t x, std::size_t y) { pixels.emplace_back(x, y); });
+    std::vector<std::pair<std::size_t, std::size_t>> expected;
+    for(std::size_t y = 0; y < image.h(); ++y) {
+        for(std::size_t x = 0; x < image.w(); ++x) {
+            if(image(x, y)) {
+                expected.emplace_back(x, y);
+            }
+        }
+    }
+    EXPECT_EQ(pixels, expected);
+
+    std::size_t spans = 0;
+    bmp::for_each_span(mask, [&](std::size_t, std::size_t begin, std::size_t end) {
+        EXPECT_LT(begin, end);
+        ++spans;
+    });
+    EXPECT_EQ(spans, mask.span_count());
+}
+
+TEST(RleMaskTest, Histogram) {
+    bitmap<std::uint8_t> image(8, 4);
+    for(std::size_t i = 0; i < image.point_count(); ++i) {
+        image.data()[i] = static_cast<std::uint8_t>(i * 8);
+    }
+    rle_mask const mask({8, 4}, rect<std::size_t>(2, 1, 3, 2));
+
+    // covered values 80, 88, 96, 144, 152, 160 map to bin v * 3 / 255
+    EXPECT_EQ(bmp::histogram(image, mask, std::uint8_t(0), std::uint8_t(255), 4), (std::vector<std::size_t>{1, 5, 0, 0}));
+    EXPECT_EQ(
+        bmp::histogram(image, mask, std::uint8_t(0), std::uint8_t(255), 4, true), (std::vector<std::size_t>{1, 6, 6, 6}));
+
+    // one bin per value, a mask of the whole image counts like the bitmap histogram
+    EXPECT_EQ(
+        bmp::histogram(image, rle_mask({8, 4}, rect<std::size_t>(0, 0, 8, 4)), std::uint8_t(0), std::uint8_t(255), 256),
+        bmp::histogram(image, std::uint8_t(0), std::uint8_t(255), 256));
+    EXPECT_THROW(
+        bmp::histogram(image, rle_mask(3, 3), std::uint8_t(0), std::uint8_t(255), 4), std::invalid_argument);
+}
+
+TEST(RleMaskTest, FromRows) {
+    auto const mask = rle_mask::from_rows({20, 3}, [](std::size_t y, std::vector<rle_span>& spans) {
+        spans.push_back({static_cast<std::uint32_t>(y), static_cast<std::uint32_t>(y + 2)});
+        spans.push_back({10, 20});
+    });
+    EXPECT_EQ(mask.area(), 36);
+    EXPECT_TRUE(mask(2, 1));
+    EXPECT_FALSE(mask(0, 1));
+
+    auto const touching = [](std::size_t, std::vector<rle_span>& spans) {
+        spans.push_back({0, 2});
+        spans.push_back({2, 4});
+    };
+    EXPECT_THROW(rle_mask::from_rows({20, 3}, touching), std::invalid_argument);
+    auto const outside = [](std::size_t, std::vector<rle_span>& spans) { spans.push_back({15, 21}); };
+    EXPECT_THROW(rle_mask::from_rows({20, 3}, outside), std::invalid_argument);
+}
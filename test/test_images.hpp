@@ -0,0 +1,94 @@
+#pragma once
+
+#include <bitmap/bitmap.hpp>
+#include <bitmap/bitmask.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+
+/// \brief Path of name in the temporary directory
+inline std::string temp_file(std::string const& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+/// \brief Irregular values from 0 to 250 without large uniform areas
+template <typename T = std::uint8_t>
+bmp::bitmap<T> make_test_image(std::size_t w, std::size_t h) {
+    bmp::bitmap<T> image(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            image(x, y) = static_cast<T>((x * 37 + y * 101 + x * y * 7) % 251);
+        }
+    }
+    return image;
+}
+
+/// \brief Smooth waves with a small irregular part
+inline bmp::bitmap<double> make_smooth_image(std::size_t w, std::size_t h) {
+    bmp::bitmap<double> image(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            image(x, y) = std::sin(static_cast<double>(x) * 0.7) * 50 + std::cos(static_cast<double>(y) * 0.3) * 30
+                + static_cast<double>((x * 7 + y * 13) % 11);
+        }
+    }
+    return image;
+}
+
+/// \brief Linear ramp x * 7 + y * 131 + offset, wrapping around at 2^16
+inline bmp::bitmap<std::uint16_t> make_ramp_image(std::size_t w, std::size_t h, std::size_t offset = 0) {
+    bmp::bitmap<std::uint16_t> image(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            image(x, y) = static_cast<std::uint16_t>(x * 7 + y * 131 + offset);
+        }
+    }
+    return image;
+}
+
+/// \brief count ramp images, frame k has offset k * 1000
+inline bmp::bitmap_vector<std::uint16_t> make_ramp_frames(std::size_t count, std::size_t w, std::size_t h) {
+    bmp::bitmap_vector<std::uint16_t> frames;
+    for(std::size_t k = 0; k < count; ++k) {
+        frames.push_back(make_ramp_image(w, h, k * 1000));
+    }
+    return frames;
+}
+
+/// \brief Scattered nonzero blobs on about 45 % of the pixels, 0 is background
+inline bmp::bitmap<std::uint8_t> make_blob_image(std::size_t w, std::size_t h) {
+    bmp::bitmap<std::uint8_t> image(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            auto const v = (x * 2654435761u + y * 40503u + x * y * 97u) % 1000;
+            image(x, y) = v < 450 ? static_cast<std::uint8_t>(v % 255 + 1) : 0;
+        }
+    }
+    return image;
+}
+
+/// \brief Runs of true pixels, seed varies the pattern
+inline bmp::bitmap<bool> make_test_pattern(std::size_t w, std::size_t h, std::size_t seed) {
+    bmp::bitmap<bool> image(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            image(x, y) = (x / 3 * 7 + y * 13 + x * y * seed) % 11 < 4;
+        }
+    }
+    return image;
+}
+
+/// \brief Irregular set bits on about 60 % of the pixels
+inline bmp::bitmask make_test_mask(std::size_t w, std::size_t h) {
+    bmp::bitmask mask(w, h);
+    for(std::size_t y = 0; y < h; ++y) {
+        for(std::size_t x = 0; x < w; ++x) {
+            mask.set(x, y, (x * 13 + y * 7 + x * y) % 5 < 3);
+        }
+    }
+    return mask;
+}